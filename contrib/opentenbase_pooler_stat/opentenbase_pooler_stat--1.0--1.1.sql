@@ -0,0 +1,18 @@
+/* contrib/opentenbase_pooler_stat/opentenbase_pooler_stat--1.0--1.1.sql */
+
+-- complain if script is sourced in psql, rather than via ALTER EXTENSION
+\echo Use "ALTER EXTENSION opentenbase_pooler_stat UPDATE TO '1.1'" to load this file. \quit
+
+CREATE OR REPLACE FUNCTION opentenbase_get_pooler_demand_statistics(
+	OUT database name,
+	OUT user_name name,
+	OUT node_name name,
+	OUT hour int4,
+	OUT in_use_cnt int4,
+	OUT conn_cnt int4,
+	OUT hour_peak_cnt int4,
+	OUT predicted_cnt int4
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
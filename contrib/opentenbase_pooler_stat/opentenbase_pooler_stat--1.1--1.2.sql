@@ -0,0 +1,19 @@
+/* contrib/opentenbase_pooler_stat/opentenbase_pooler_stat--1.1--1.2.sql */
+
+-- complain if script is sourced in psql, rather than via ALTER EXTENSION
+\echo Use "ALTER EXTENSION opentenbase_pooler_stat UPDATE TO '1.2'" to load this file. \quit
+
+-- histogram bucket i counts the values in [2^i, 2^(i+1)), in microseconds
+-- for latencies and in seconds for slot_age
+CREATE OR REPLACE FUNCTION opentenbase_get_pooler_node_telemetry(
+	OUT database name,
+	OUT user_name name,
+	OUT node_name name,
+	OUT metric text,
+	OUT count int8,
+	OUT avg_us int8,
+	OUT histogram int8[]
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
@@ -36,6 +36,7 @@
 #include <endian.h>
 #include "pgxc/poolmgr.h"
 #include "libpq/pqformat.h"
+#include "utils/array.h"
 #include "utils/builtins.h"
 
 PG_MODULE_MAGIC;
@@ -43,6 +44,8 @@ PG_MODULE_MAGIC;
 PG_FUNCTION_INFO_V1(opentenbase_get_pooler_cmd_statistics);
 PG_FUNCTION_INFO_V1(opentenbase_reset_pooler_cmd_statistics);
 PG_FUNCTION_INFO_V1(opentenbase_get_pooler_conn_statistics);
+PG_FUNCTION_INFO_V1(opentenbase_get_pooler_demand_statistics);
+PG_FUNCTION_INFO_V1(opentenbase_get_pooler_node_telemetry);
 
 typedef struct
 {
@@ -59,6 +62,26 @@ typedef struct
     StringInfo   buf;                  /* a stringInfo buf store the result */
 } Pooler_ConnState;
 
+typedef struct
+{
+    uint32       node_cursor;          /* node pools left to return */
+    StringInfo   buf;                  /* a stringInfo buf store the result */
+} Pooler_DemandState;
+
+typedef struct
+{
+    uint32       node_cursor;          /* node pools left to return */
+    uint32       metric;               /* current metric of current node pool */
+    const char   *database;            /* current node pool's database */
+    const char   *username;            /* current node pool's username */
+    const char   *nodename;            /* current node pool's node name */
+    int64        latency_sum[POOL_LATENCY_KIND_COUNT];
+    Datum        latency[POOL_LATENCY_KIND_COUNT][POOL_LATENCY_BUCKETS];
+    Datum        slot_age[POOL_SLOT_AGE_BUCKETS];
+    int64        build_fail[POOL_BUILD_FAIL_COUNT];
+    StringInfo   buf;                  /* a stringInfo buf store the result */
+} Pooler_TelemetryState;
+
 
 /* the g_pooler_cmd_name_tab and g_pooler_cmd must be in the same order */
 static char *g_pooler_cmd_name_tab[POOLER_CMD_COUNT] =
@@ -80,7 +103,24 @@ static char *g_pooler_cmd_name_tab[POOLER_CMD_COUNT] =
     "CLOSE_POOLER_CONN",      /* Close pooler connections*/
     "GET_CMD_STATSTICS",      /* Get command statistics */
     "RESET_CMD_STATISTICS",   /* Reset command statistics */
-    "GET_CONN_STATISTICS"     /* Get connection statistics */
+    "GET_CONN_STATISTICS",    /* Get connection statistics */
+    "GET_DEMAND_STATISTICS",  /* Get demand statistics */
+    "GET_NODE_TELEMETRY"      /* Get node pool telemetry */
+};
+
+/* metrics returned for each node pool, latency kinds in PoolLatencyKind order first */
+#define POOLER_TELEMETRY_METRIC_COUNT (POOL_LATENCY_KIND_COUNT + 1 + POOL_BUILD_FAIL_COUNT)
+static char *g_pooler_telemetry_metric_tab[POOLER_TELEMETRY_METRIC_COUNT] =
+{
+    "acquire_hit",            /* acquire a free connection from the pool */
+    "async_build",            /* batch connection build to grow the pool */
+    "sync_build",             /* acquire building a new connection in sync thread */
+    "set_replay",             /* replay session parameters on an acquired connection */
+    "reset",                  /* reset a connection released to the pool */
+    "slot_age",               /* age of the free connections, in seconds */
+    "build_fail_no_thread",   /* no async thread available */
+    "build_fail_connect",     /* could not connect to the node */
+    "build_fail_discard"      /* built but pool full or version changed */
 };
 
 /*
@@ -312,4 +352,266 @@ opentenbase_get_pooler_conn_statistics(PG_FUNCTION_ARGS)
     }
 
     SRF_RETURN_DONE(funcctx);
-}
\ No newline at end of file
+}
+
+/*
+ * get pooler demand statistics of node pools
+ */
+Datum
+opentenbase_get_pooler_demand_statistics(PG_FUNCTION_ARGS)
+{
+#define  LIST_POOLER_DEMAND_STATISTICS_COLUMNS 8
+    FuncCallContext 	 *funcctx = NULL;
+    int32                ret = 0;
+    Pooler_DemandState   *status = NULL;
+    Datum		         values[LIST_POOLER_DEMAND_STATISTICS_COLUMNS];
+    bool		         nulls[LIST_POOLER_DEMAND_STATISTICS_COLUMNS];
+    HeapTuple	         tuple;
+    Datum		         result;
+    int32                hour;
+
+    if (SRF_IS_FIRSTCALL())
+    {
+        MemoryContext oldcontext;
+        TupleDesc	  tupdesc;
+
+        /* content will destroy in SRF_RETURN_DONE */
+        funcctx = SRF_FIRSTCALL_INIT();
+
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        tupdesc = CreateTemplateTupleDesc(LIST_POOLER_DEMAND_STATISTICS_COLUMNS, false);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 1, "database",
+                           NAMEOID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 2, "user_name",
+                           NAMEOID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 3, "node_name",
+                           NAMEOID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 4, "hour",
+                           INT4OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 5, "in_use_cnt",
+                           INT4OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 6, "conn_cnt",
+                           INT4OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 7, "hour_peak_cnt",
+                           INT4OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 8, "predicted_cnt",
+                           INT4OID, -1, 0);
+
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+        status = (Pooler_DemandState*) palloc(sizeof(Pooler_DemandState));
+        status->node_cursor = 0;
+        status->buf = makeStringInfo();
+
+        funcctx->user_fctx = (void*) status;
+
+        ret = PoolManagerGetDemandStatistics(status->buf);
+        if (ret)
+        {
+            elog(ERROR, "get pooler demand statictics info from pooler failed");
+        }
+        else
+        {
+            status->node_cursor = pq_getmsgint(status->buf, sizeof(uint32));
+        }
+
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+    status  = (Pooler_DemandState *) funcctx->user_fctx;
+
+    while (status->node_cursor)
+    {
+        MemSet(values, 0, sizeof(values));
+        MemSet(nulls,  0, sizeof(nulls));
+
+        values[0] = CStringGetDatum(pq_getmsgstring(status->buf));
+        values[1] = CStringGetDatum(pq_getmsgstring(status->buf));
+        values[2] = CStringGetDatum(pq_getmsgstring(status->buf));
+
+        /* no demand recorded yet */
+        hour = (int32) pq_getmsgint(status->buf, sizeof(int32));
+        if (hour < 0)
+        {
+            nulls[3] = true;
+        }
+        values[3] = Int32GetDatum(hour);
+        values[4] = Int32GetDatum((int32) pq_getmsgint(status->buf, sizeof(int32)));
+        values[5] = Int32GetDatum((int32) pq_getmsgint(status->buf, sizeof(int32)));
+        values[6] = Int32GetDatum((int32) pq_getmsgint(status->buf, sizeof(int32)));
+        values[7] = Int32GetDatum((int32) pq_getmsgint(status->buf, sizeof(int32)));
+
+        status->node_cursor--;
+
+        tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+        result = HeapTupleGetDatum(tuple);
+        SRF_RETURN_NEXT(funcctx, result);
+    }
+
+    SRF_RETURN_DONE(funcctx);
+}
+
+/*
+ * read the telemetry of next node pool from buf
+ */
+static void
+pooler_read_node_telemetry(Pooler_TelemetryState *status)
+{
+    int i;
+    int j;
+
+    status->database = pq_getmsgstring(status->buf);
+    status->username = pq_getmsgstring(status->buf);
+    status->nodename = pq_getmsgstring(status->buf);
+
+    for (i = 0; i < POOL_LATENCY_KIND_COUNT; i++)
+    {
+        status->latency_sum[i] = pq_getmsgint64(status->buf);
+        for (j = 0; j < POOL_LATENCY_BUCKETS; j++)
+        {
+            status->latency[i][j] = Int64GetDatum((int64) pq_getmsgint(status->buf, sizeof(uint32)));
+        }
+    }
+
+    for (i = 0; i < POOL_BUILD_FAIL_COUNT; i++)
+    {
+        status->build_fail[i] = (int64) pq_getmsgint(status->buf, sizeof(uint32));
+    }
+
+    for (i = 0; i < POOL_SLOT_AGE_BUCKETS; i++)
+    {
+        status->slot_age[i] = Int64GetDatum((int64) pq_getmsgint(status->buf, sizeof(uint32)));
+    }
+}
+
+static int64
+pooler_histogram_count(Datum *buckets, int nbuckets)
+{
+    int64 count = 0;
+    int   i;
+
+    for (i = 0; i < nbuckets; i++)
+    {
+        count += DatumGetInt64(buckets[i]);
+    }
+    return count;
+}
+
+/*
+ * get latency histograms, build failures and slot ages of node pools
+ */
+Datum
+opentenbase_get_pooler_node_telemetry(PG_FUNCTION_ARGS)
+{
+#define  LIST_POOLER_NODE_TELEMETRY_COLUMNS 7
+    FuncCallContext 	  *funcctx = NULL;
+    int32                 ret = 0;
+    Pooler_TelemetryState *status = NULL;
+    Datum		          values[LIST_POOLER_NODE_TELEMETRY_COLUMNS];
+    bool		          nulls[LIST_POOLER_NODE_TELEMETRY_COLUMNS];
+    HeapTuple	          tuple;
+    Datum		          result;
+    int64                 count;
+
+    if (SRF_IS_FIRSTCALL())
+    {
+        MemoryContext oldcontext;
+        TupleDesc	  tupdesc;
+
+        /* content will destroy in SRF_RETURN_DONE */
+        funcctx = SRF_FIRSTCALL_INIT();
+
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        tupdesc = CreateTemplateTupleDesc(LIST_POOLER_NODE_TELEMETRY_COLUMNS, false);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 1, "database",
+                           NAMEOID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 2, "user_name",
+                           NAMEOID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 3, "node_name",
+                           NAMEOID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 4, "metric",
+                           TEXTOID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 5, "count",
+                           INT8OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 6, "avg_us",
+                           INT8OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 7, "histogram",
+                           INT8ARRAYOID, -1, 0);
+
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+        status = (Pooler_TelemetryState*) palloc0(sizeof(Pooler_TelemetryState));
+        status->metric = POOLER_TELEMETRY_METRIC_COUNT;
+        status->buf = makeStringInfo();
+
+        funcctx->user_fctx = (void*) status;
+
+        ret = PoolManagerGetNodeTelemetry(status->buf);
+        if (ret)
+        {
+            elog(ERROR, "get pooler node telemetry from pooler failed");
+        }
+        else
+        {
+            status->node_cursor = pq_getmsgint(status->buf, sizeof(uint32));
+        }
+
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+    status  = (Pooler_TelemetryState *) funcctx->user_fctx;
+
+    if (status->metric == POOLER_TELEMETRY_METRIC_COUNT && status->node_cursor > 0)
+    {
+        pooler_read_node_telemetry(status);
+        status->node_cursor--;
+        status->metric = 0;
+    }
+
+    if (status->metric < POOLER_TELEMETRY_METRIC_COUNT)
+    {
+        uint32 metric = status->metric;
+
+        MemSet(values, 0, sizeof(values));
+        MemSet(nulls,  0, sizeof(nulls));
+
+        values[0] = CStringGetDatum(status->database);
+        values[1] = CStringGetDatum(status->username);
+        values[2] = CStringGetDatum(status->nodename);
+        values[3] = CStringGetTextDatum(g_pooler_telemetry_metric_tab[metric]);
+
+        if (metric < POOL_LATENCY_KIND_COUNT)
+        {
+            count = pooler_histogram_count(status->latency[metric], POOL_LATENCY_BUCKETS);
+            values[4] = Int64GetDatum(count);
+            values[5] = Int64GetDatum(count ? status->latency_sum[metric] / count : 0);
+            values[6] = PointerGetDatum(construct_array(status->latency[metric], POOL_LATENCY_BUCKETS,
+                                                        INT8OID, sizeof(int64), FLOAT8PASSBYVAL, 'd'));
+        }
+        else if (metric == POOL_LATENCY_KIND_COUNT)
+        {
+            values[4] = Int64GetDatum(pooler_histogram_count(status->slot_age, POOL_SLOT_AGE_BUCKETS));
+            nulls[5] = true;
+            values[6] = PointerGetDatum(construct_array(status->slot_age, POOL_SLOT_AGE_BUCKETS,
+                                                        INT8OID, sizeof(int64), FLOAT8PASSBYVAL, 'd'));
+        }
+        else
+        {
+            values[4] = Int64GetDatum(status->build_fail[metric - POOL_LATENCY_KIND_COUNT - 1]);
+            nulls[5] = true;
+            nulls[6] = true;
+        }
+
+        status->metric++;
+
+        tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+        result = HeapTupleGetDatum(tuple);
+        SRF_RETURN_NEXT(funcctx, result);
+    }
+
+    SRF_RETURN_DONE(funcctx);
+}
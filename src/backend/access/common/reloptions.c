@@ -92,6 +92,9 @@
 #include "commands/view.h"
 #include "nodes/makefuncs.h"
 #include "postmaster/postmaster.h"
+#ifdef _SHARDING_
+#include "storage/zonemap.h"
+#endif
 #include "utils/array.h"
 #include "utils/attoptcache.h"
 #include "utils/builtins.h"
@@ -492,6 +495,20 @@ static relopt_string stringRelOpts[] =
         validateWithCheckOption,
         NULL
     },
+#ifdef _SHARDING_
+    {
+        {
+            "zone_map_columns",
+            "Columns whose range of values is kept per extent to skip extents in scans",
+            RELOPT_KIND_HEAP,
+            AccessExclusiveLock
+        },
+        0,
+        true,
+        ZoneMapValidateColumns,
+        NULL
+    },
+#endif
     /* list terminator */
     {{NULL}}
 };
@@ -1429,7 +1446,11 @@ default_reloptions(Datum reloptions, bool validate, relopt_kind kind)
         {"user_catalog_table", RELOPT_TYPE_BOOL,
         offsetof(StdRdOptions, user_catalog_table)},
         {"parallel_workers", RELOPT_TYPE_INT,
-        offsetof(StdRdOptions, parallel_workers)}
+        offsetof(StdRdOptions, parallel_workers)},
+#ifdef _SHARDING_
+        {"zone_map_columns", RELOPT_TYPE_STRING,
+        offsetof(StdRdOptions, zone_map_columns_offset)}
+#endif
     };
 
     options = parseRelOptions(reloptions, validate, kind, &numoptions);
@@ -1089,6 +1089,88 @@ compute_hash(Oid type, Datum value, char locator)
     return (Datum)0;
 }
 
+#ifdef __OPENTENBASE__
+/*
+ * compute_hash_batch()
+ * compute_hash of each of nvalues values, 0 for the nulls. The common
+ * distribution key types are hashed in loops of their own rather than
+ * through the fmgr interface value by value.
+ */
+void
+compute_hash_batch(Oid type, Datum *values, bool *nulls, int nvalues,
+                   char locator, Datum *hashes)
+{
+    Oid        looptype = type;
+    int        i;
+
+    /* other locators use the values of integers as they are */
+    if (locator != LOCATOR_TYPE_HASH && locator != LOCATOR_TYPE_SHARD)
+        looptype = InvalidOid;
+
+    switch (looptype)
+    {
+        case INT4OID:
+            for (i = 0; i < nvalues; i++)
+                hashes[i] = nulls[i] ? (Datum) 0 :
+                    hash_uint32((uint32) DatumGetInt32(values[i]));
+            break;
+
+        case INT8OID:
+            for (i = 0; i < nvalues; i++)
+            {
+                int64    val;
+                uint32    lohalf;
+                uint32    hihalf;
+
+                if (nulls[i])
+                {
+                    hashes[i] = (Datum) 0;
+                    continue;
+                }
+
+                /* same as hashint8 */
+                val = DatumGetInt64(values[i]);
+                lohalf = (uint32) val;
+                hihalf = (uint32) (val >> 32);
+                lohalf ^= (val >= 0) ? hihalf : ~hihalf;
+                hashes[i] = hash_uint32(lohalf);
+            }
+            break;
+
+        case VARCHAROID:
+        case TEXTOID:
+#ifdef _PG_ORCL_
+        case VARCHAR2OID:
+        case NVARCHAR2OID:
+#endif
+            for (i = 0; i < nvalues; i++)
+            {
+                text   *key;
+
+                if (nulls[i])
+                {
+                    hashes[i] = (Datum) 0;
+                    continue;
+                }
+
+                /* same as hashtext */
+                key = DatumGetTextPP(values[i]);
+                hashes[i] = hash_any((unsigned char *) VARDATA_ANY(key),
+                                     VARSIZE_ANY_EXHDR(key));
+                if ((Pointer) key != DatumGetPointer(values[i]))
+                    pfree(key);
+            }
+            break;
+
+        default:
+            for (i = 0; i < nvalues; i++)
+                hashes[i] = nulls[i] ? (Datum) 0 :
+                    compute_hash(type, values[i], locator);
+            break;
+    }
+}
+#endif
+
 
 /*
  * get_compute_hash_function
@@ -81,6 +81,8 @@
 #include "pgxc/pgxc.h"
 #endif
 #ifdef _SHARDING_
+#include "storage/extentmapping.h"
+#include "storage/zonemap.h"
 #include "utils/guc.h"
 #endif
 #ifdef __OPENTENBASE__
@@ -97,6 +99,9 @@
 
 /* GUC variable */
 bool        synchronize_seqscans = true;
+#ifdef _SHARDING_
+bool        enable_shard_pruned_scan = true;
+#endif
 
 
 static HeapScanDesc heap_beginscan_internal(Relation relation,
@@ -111,6 +116,12 @@ static HeapScanDesc heap_beginscan_internal(Relation relation,
                         bool temp_snap);
 static void heap_parallelscan_startblock_init(HeapScanDesc scan);
 static BlockNumber heap_parallelscan_nextpage(HeapScanDesc scan);
+#ifdef _SHARDING_
+static BlockNumber heap_parallelscan_nextextentpage(HeapScanDesc scan);
+static void heap_initshardscan(HeapScanDesc scan);
+static BlockNumber heap_shardscan_nextpage(HeapScanDesc scan, BlockNumber page,
+                        bool backward, bool next_extent);
+#endif
 static HeapTuple heap_prepare_insert(Relation relation, HeapTuple tup,
                     TransactionId xid, CommandId cid, int options);
 static XLogRecPtr log_heap_update(Relation reln, Buffer oldbuf,
@@ -339,8 +350,223 @@ initscan(HeapScanDesc scan, ScanKey key, bool keep_startblock)
      */
     if (!scan->rs_bitmapscan && !scan->rs_samplescan)
         pgstat_count_heap_scan(scan->rs_rd);
+
+#ifdef _SHARDING_
+    /* the pages of the shards the scan can not see are not read */
+    if (scan->rs_shards == NULL && !keep_startblock &&
+        scan->rs_parallel == NULL &&
+        !scan->rs_bitmapscan && !scan->rs_samplescan)
+        scan->rs_shards = heap_scan_visible_shards(scan->rs_rd, scan->rs_snapshot);
+    if (scan->rs_parallel == NULL && (scan->rs_shards || scan->rs_nzmkeys > 0))
+        heap_initshardscan(scan);
+    if (scan->rs_zmbuild)
+    {
+        scan->rs_zmbuild->eid = InvalidExtentID;
+        scan->rs_zmbuild->active = false;
+    }
+#endif
+}
+
+#ifdef _SHARDING_
+/*
+ * heap_setscanshards - restrict a heapscan to the pages of some shards
+ *
+ * Only the extents the extent map assigns to one of the shards are read,
+ * instead of reading every page and testing its shard. NULL scans all
+ * of them. The pages are read in order and not reported to syncscan.
+ */
+void
+heap_setscanshards(HeapScanDesc scan, Bitmapset *shards)
+{
+    MemoryContext oldcontext;
+
+    Assert(!scan->rs_inited);    /* else too late to change */
+    Assert(scan->rs_parallel == NULL);
+
+    if (shards == NULL || !enable_shard_pruned_scan ||
+        !RelationHasExtent(scan->rs_rd))
+        return;
+
+    oldcontext = MemoryContextSwitchTo(GetMemoryChunkContext(scan));
+    if (scan->rs_shards)
+        bms_free(scan->rs_shards);
+    scan->rs_shards = bms_copy(shards);
+    MemoryContextSwitchTo(oldcontext);
+
+    scan->rs_extents_nblocks = InvalidBlockNumber;
+    heap_initshardscan(scan);
 }
 
+/*
+ * Shards whose tuples a scan with the snapshot returns, when shard
+ * visibility restricts them: see the shard test of heapgettup(). NULL if
+ * the scan returns the tuples of all the shards, or the extent map is not
+ * worth looking at.
+ */
+Bitmapset *
+heap_scan_visible_shards(Relation relation, Snapshot snapshot)
+{
+    Bitmapset  *shards = NULL;
+    ShardID        sid;
+
+    if (!enable_shard_pruned_scan ||
+        !IS_PGXC_DATANODE ||
+        !IsConnFromApp() ||
+        g_ShardVisibleMode == SHARD_VISIBLE_MODE_ALL ||
+        !RelationHasExtent(relation) ||
+        snapshot == NULL || !IsMVCCSnapshot(snapshot) ||
+        snapshot->groupsize <= 0)
+        return NULL;
+
+    /* a single extent is read anyway */
+    if (RelationGetNumberOfBlocks(relation) <= PAGES_PER_EXTENTS)
+        return NULL;
+
+    for (sid = 0; sid < MAX_SHARDS; sid++)
+    {
+        bool        shard_is_visible = bms_is_member(sid / snapshot->groupsize,
+                                                     SnapshotGetShardTable(snapshot));
+
+        if (shard_is_visible == (g_ShardVisibleMode == SHARD_VISIBLE_MODE_VISIBLE))
+            shards = bms_add_member(shards, sid);
+    }
+
+    /* none is visible, the scan reads nothing */
+    if (shards == NULL)
+        shards = bms_make_singleton(InvalidShardID);
+
+    return shards;
+}
+
+/*
+ * Look up the extents of the shards scanned. A rescan, as of the inner side
+ * of a nested loop, looks them up again only if the relation has grown: the
+ * extents holding the tuples its snapshot sees do not change. Without
+ * rs_shards, a scan skipping extents by their zone map goes through all of
+ * them.
+ */
+static void
+heap_initshardscan(HeapScanDesc scan)
+{
+    MemoryContext oldcontext;
+
+    if (scan->rs_extents == NULL ||
+        scan->rs_extents_nblocks != scan->rs_nblocks)
+    {
+        oldcontext = MemoryContextSwitchTo(GetMemoryChunkContext(scan));
+        if (scan->rs_extents)
+            pfree(scan->rs_extents);
+        if (scan->rs_shards)
+            scan->rs_extents = GetShardExtents(scan->rs_rd, scan->rs_shards,
+                                               scan->rs_nblocks, &scan->rs_nextents,
+                                               NULL);
+        else
+        {
+            int            i;
+
+            scan->rs_nextents = (scan->rs_nblocks + PAGES_PER_EXTENTS - 1) / PAGES_PER_EXTENTS;
+            scan->rs_extents = (ExtentID *) palloc(sizeof(ExtentID) * Max(scan->rs_nextents, 1));
+            for (i = 0; i < scan->rs_nextents; i++)
+                scan->rs_extents[i] = i;
+        }
+        scan->rs_extents_nblocks = scan->rs_nblocks;
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    scan->rs_cextent = 0;
+    scan->rs_syncscan = false;
+    scan->rs_startblock = 0;
+}
+
+/*
+ * Next page of a scan restricted to some shards: the one after the given
+ * page in its extent, or unless that is the last one or next_extent is
+ * set, the first one of the next extent of the shards. Backward scans go
+ * the other way. InvalidBlockNumber gets the first page of the scan, and
+ * is returned at the end of it.
+ */
+static BlockNumber
+heap_shardscan_nextpage(HeapScanDesc scan, BlockNumber page, bool backward,
+                        bool next_extent)
+{
+    int            step = backward ? -1 : 1;
+
+    if (page == InvalidBlockNumber)
+        scan->rs_cextent = backward ? scan->rs_nextents - 1 : 0;
+    else
+    {
+        if (!next_extent)
+        {
+            if (!backward && (page + 1) % PAGES_PER_EXTENTS != 0 &&
+                page + 1 < scan->rs_nblocks)
+                return page + 1;
+            if (backward && page % PAGES_PER_EXTENTS != 0)
+                return page - 1;
+        }
+        scan->rs_cextent += step;
+    }
+
+    for (; scan->rs_cextent >= 0 && scan->rs_cextent < scan->rs_nextents;
+         scan->rs_cextent += step)
+    {
+        ExtentID    eid = scan->rs_extents[scan->rs_cextent];
+        BlockNumber start = eid * PAGES_PER_EXTENTS;
+
+        if (start >= scan->rs_nblocks)
+            continue;
+        if (scan->rs_nzmkeys > 0 &&
+            !ZoneMapExtentMayMatch(scan->rs_rd, eid,
+                                   scan->rs_zmkeys, scan->rs_nzmkeys))
+            continue;
+
+        return backward ?
+            Min(start + PAGES_PER_EXTENTS, scan->rs_nblocks) - 1 : start;
+    }
+
+    return InvalidBlockNumber;
+}
+
+/*
+ * heap_setscanzonemap - skip the extents the keys can not match
+ *
+ * The keys are quals on columns of the zone map of the relation, see
+ * ZoneMapExtentMayMatch(); the others are ignored. Extents are skipped
+ * only for MVCC snapshots, which do not see the tuples put in an extent
+ * after its zone map is looked at. Call it again after heap_rescan() if
+ * the keys changed.
+ */
+void
+heap_setscanzonemap(HeapScanDesc scan, ScanKey keys, int nkeys)
+{
+    MemoryContext oldcontext;
+
+    Assert(!scan->rs_inited);    /* else too late to change */
+
+    if (scan->rs_zmkeys)
+    {
+        pfree(scan->rs_zmkeys);
+        scan->rs_zmkeys = NULL;
+        scan->rs_nzmkeys = 0;
+    }
+
+    if (nkeys <= 0 || !enable_zone_map ||
+        !IsMVCCSnapshot(scan->rs_snapshot) ||
+        scan->rs_bitmapscan || scan->rs_samplescan ||
+        RelationGetZoneMap(scan->rs_rd) == NULL)
+        return;
+
+    oldcontext = MemoryContextSwitchTo(GetMemoryChunkContext(scan));
+    scan->rs_zmkeys = (ScanKey) palloc(sizeof(ScanKeyData) * nkeys);
+    memcpy(scan->rs_zmkeys, keys, sizeof(ScanKeyData) * nkeys);
+    scan->rs_nzmkeys = nkeys;
+    MemoryContextSwitchTo(oldcontext);
+
+    /* a parallel scan skips the extents it is handed out */
+    if (scan->rs_parallel == NULL && scan->rs_extents == NULL)
+        heap_initshardscan(scan);
+}
+#endif
+
 /*
  * heap_setscanlimits - restrict range of a heapscan
  *
@@ -356,6 +582,27 @@ heap_setscanlimits(HeapScanDesc scan, BlockNumber startBlk, BlockNumber numBlks)
     /* Check startBlk is valid (but allow case of zero blocks...) */
     Assert(startBlk == 0 || startBlk < scan->rs_nblocks);
 
+#ifdef _SHARDING_
+    /* the range is scanned whole */
+    if (scan->rs_extents)
+    {
+        pfree(scan->rs_extents);
+        scan->rs_extents = NULL;
+        scan->rs_nextents = 0;
+    }
+    if (scan->rs_shards)
+    {
+        bms_free(scan->rs_shards);
+        scan->rs_shards = NULL;
+    }
+    if (scan->rs_zmkeys)
+    {
+        pfree(scan->rs_zmkeys);
+        scan->rs_zmkeys = NULL;
+        scan->rs_nzmkeys = 0;
+    }
+#endif
+
     scan->rs_startblock = startBlk;
     scan->rs_numblocks = numBlks;
 }
@@ -395,6 +642,12 @@ heapgetpage(HeapScanDesc scan, BlockNumber page)
      */
     CHECK_FOR_INTERRUPTS();
 
+#ifdef _SHARDING_
+    /* the zone map of an extent is claimed before any page of it is read */
+    if (scan->rs_zmbuild && scan->rs_pageatatime)
+        ZoneMapBuildStart(scan->rs_rd, scan->rs_zmbuild, page, scan->rs_nblocks);
+#endif
+
     /* read page using selected strategy */
     scan->rs_cbuf = ReadBufferExtended(scan->rs_rd, MAIN_FORKNUM, page,
                                        RBM_NORMAL, scan->rs_strategy);
@@ -489,6 +742,11 @@ heapgetpage(HeapScanDesc scan, BlockNumber page)
         }
     }
 
+#ifdef _SHARDING_
+    if (scan->rs_zmbuild)
+        ZoneMapBuildAddPage(scan->rs_rd, scan->rs_zmbuild, page, dp);
+#endif
+
     LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
 
     Assert(ntup <= MaxHeapTuplesPerPage);
@@ -565,6 +823,21 @@ heapgettup(HeapScanDesc scan,
                     return;
                 }
             }
+#ifdef _SHARDING_
+            else if (scan->rs_extents)
+            {
+                page = heap_shardscan_nextpage(scan, InvalidBlockNumber,
+                                               false, false);
+
+                /* none of the extents is of the shards scanned */
+                if (page == InvalidBlockNumber)
+                {
+                    Assert(!BufferIsValid(scan->rs_cbuf));
+                    tuple->t_data = NULL;
+                    return;
+                }
+            }
+#endif
             else
                 page = scan->rs_startblock; /* first page */
             heapgetpage(scan, page);
@@ -613,6 +886,20 @@ heapgettup(HeapScanDesc scan,
              */
             scan->rs_syncscan = false;
             /* start from last page of the scan */
+#ifdef _SHARDING_
+            if (scan->rs_extents)
+            {
+                page = heap_shardscan_nextpage(scan, InvalidBlockNumber,
+                                               true, false);
+                if (page == InvalidBlockNumber)
+                {
+                    Assert(!BufferIsValid(scan->rs_cbuf));
+                    tuple->t_data = NULL;
+                    return;
+                }
+            }
+            else
+#endif
             if (scan->rs_startblock > 0)
                 page = scan->rs_startblock - 1;
             else
@@ -737,6 +1024,14 @@ heapgettup(HeapScanDesc scan,
         /*
          * advance to next/prior page and detect end of scan
          */
+#ifdef _SHARDING_
+        if (scan->rs_extents)
+        {
+            page = heap_shardscan_nextpage(scan, page, backward, false);
+            finished = (page == InvalidBlockNumber);
+        }
+        else
+#endif
         if (backward)
         {
             finished = (page == scan->rs_startblock) ||
@@ -822,6 +1117,14 @@ get_next_page:
 
             if(to_skip)
             {
+#ifdef _SHARDING_
+                if (scan->rs_extents)
+                {
+                    page = heap_shardscan_nextpage(scan, page, backward, true);
+                    finished = (page == InvalidBlockNumber);
+                }
+                else
+#endif
                 if (scan->rs_parallel != NULL)
                 {
                     page = heap_parallelscan_nextpage(scan);
@@ -947,6 +1250,21 @@ heapgettup_pagemode(HeapScanDesc scan,
                     return;
                 }
             }
+#ifdef _SHARDING_
+            else if (scan->rs_extents)
+            {
+                page = heap_shardscan_nextpage(scan, InvalidBlockNumber,
+                                               false, false);
+
+                /* none of the extents is of the shards scanned */
+                if (page == InvalidBlockNumber)
+                {
+                    Assert(!BufferIsValid(scan->rs_cbuf));
+                    tuple->t_data = NULL;
+                    return;
+                }
+            }
+#endif
             else
                 page = scan->rs_startblock; /* first page */
             heapgetpage(scan, page);
@@ -992,6 +1310,20 @@ heapgettup_pagemode(HeapScanDesc scan,
              */
             scan->rs_syncscan = false;
             /* start from last page of the scan */
+#ifdef _SHARDING_
+            if (scan->rs_extents)
+            {
+                page = heap_shardscan_nextpage(scan, InvalidBlockNumber,
+                                               true, false);
+                if (page == InvalidBlockNumber)
+                {
+                    Assert(!BufferIsValid(scan->rs_cbuf));
+                    tuple->t_data = NULL;
+                    return;
+                }
+            }
+            else
+#endif
             if (scan->rs_startblock > 0)
                 page = scan->rs_startblock - 1;
             else
@@ -1105,6 +1437,14 @@ heapgettup_pagemode(HeapScanDesc scan,
          * if we get here, it means we've exhausted the items on this page and
          * it's time to move to the next.
          */
+#ifdef _SHARDING_
+        if (scan->rs_extents)
+        {
+            page = heap_shardscan_nextpage(scan, page, backward, false);
+            finished = (page == InvalidBlockNumber);
+        }
+        else
+#endif
         if (backward)
         {
             finished = (page == scan->rs_startblock) ||
@@ -1188,6 +1528,14 @@ get_next_page:
 
             if(to_skip)
             {
+#ifdef _SHARDING_
+                if (scan->rs_extents)
+                {
+                    page = heap_shardscan_nextpage(scan, page, backward, true);
+                    finished = (page == InvalidBlockNumber);
+                }
+                else
+#endif
                 if (scan->rs_parallel != NULL)
                 {
                     page = heap_parallelscan_nextpage(scan);
@@ -1722,6 +2070,21 @@ heap_beginscan_internal(Relation relation, Snapshot snapshot,
     else
         scan->rs_key = NULL;
 
+#ifdef _SHARDING_
+    scan->rs_shards = NULL;
+    scan->rs_extents = NULL;
+    scan->rs_nextents = 0;
+    scan->rs_extents_nblocks = InvalidBlockNumber;
+    scan->rs_cextent = 0;
+    scan->rs_zmkeys = NULL;
+    scan->rs_nzmkeys = 0;
+    scan->rs_zmbuild = NULL;
+    /* a scan reading whole extents summarizes them, see heapgetpage */
+    if (!is_bitmapscan && !is_samplescan &&
+        RelationGetZoneMap(relation) != NULL)
+        scan->rs_zmbuild = (ZoneMapBuildState *) palloc0(sizeof(ZoneMapBuildState));
+#endif
+
     initscan(scan, key, false);
 
     return scan;
@@ -1865,6 +2228,17 @@ heap_endscan(HeapScanDesc scan)
     if (scan->rs_temp_snap)
         UnregisterSnapshot(scan->rs_snapshot);
 
+#ifdef _SHARDING_
+    if (scan->rs_extents)
+        pfree(scan->rs_extents);
+    if (scan->rs_shards)
+        bms_free(scan->rs_shards);
+    if (scan->rs_zmkeys)
+        pfree(scan->rs_zmkeys);
+    if (scan->rs_zmbuild)
+        pfree(scan->rs_zmbuild);
+#endif
+
     pfree(scan);
 }
 
@@ -1904,8 +2278,140 @@ heap_parallelscan_initialize(ParallelHeapScanDesc target, Relation relation,
     target->phs_startblock = InvalidBlockNumber;
 	pg_atomic_write_u64(&target->phs_nallocated, 0);
     SerializeSnapshot(snapshot, target->phs_snapshot_data);
+#ifdef _SHARDING_
+    target->phs_nextents = -1;
+    target->phs_extents_off =
+        MAXALIGN(offsetof(ParallelHeapScanDescData, phs_snapshot_data) +
+                 EstimateSnapshotSpace(snapshot));
+#endif
+}
+
+#ifdef _SHARDING_
+/* extents a parallel scan hands out, after the snapshot */
+#define ParallelScanExtents(pscan) \
+    ((ExtentID *) ((char *) (pscan) + (pscan)->phs_extents_off))
+
+typedef struct ShardExtent
+{
+    ShardID        shardid;
+    ExtentID    eid;
+} ShardExtent;
+
+static int
+shard_extent_cmp(const void *a, const void *b)
+{
+    const ShardExtent *ea = (const ShardExtent *) a;
+    const ShardExtent *eb = (const ShardExtent *) b;
+
+    if (ea->shardid != eb->shardid)
+        return ea->shardid < eb->shardid ? -1 : 1;
+    if (ea->eid != eb->eid)
+        return ea->eid < eb->eid ? -1 : 1;
+    return 0;
 }
 
+/* ----------------
+ *        heap_parallelscan_shard_estimate - room for extents to hand out
+ *
+ *        Returns len, the size returned by heap_parallelscan_estimate, with
+ *        room added for heap_parallelscan_initialize_shards.
+ * ----------------
+ */
+Size
+heap_parallelscan_shard_estimate(Relation relation, Size len)
+{
+    BlockNumber nblocks;
+
+    if ((!enable_shard_pruned_scan || !IS_PGXC_DATANODE ||
+         !RelationHasExtent(relation)) &&
+        (!enable_zone_map || RelationGetZoneMap(relation) == NULL))
+        return len;
+
+    nblocks = RelationGetNumberOfBlocks(relation);
+    if (nblocks <= PAGES_PER_EXTENTS)
+        return len;
+
+    /* the relation may grow a bit until the scan is initialized */
+    return add_size(MAXALIGN(len),
+                    mul_size(sizeof(ExtentID),
+                             nblocks / PAGES_PER_EXTENTS + 2));
+}
+
+/* ----------------
+ *        heap_parallelscan_initialize_shards - hand out extents of shards
+ *
+ *        When shard visibility restricts the scan, the workers are handed
+ *        out whole extents of the shards visible rather than blocks, the
+ *        extents of a shard one after the other. So a worker reads an extent
+ *        contiguously, and the extents of the other shards are not read.
+ *        The extents of a relation with a zone map are handed out too, in
+ *        block order, for the workers to skip some of them and summarize
+ *        the others.  len is the size allocated for target.  Call this in
+ *        the leader after heap_parallelscan_initialize.
+ * ----------------
+ */
+void
+heap_parallelscan_initialize_shards(ParallelHeapScanDesc target, Size len,
+                                    Relation relation, Snapshot snapshot)
+{
+    Bitmapset  *shards;
+    ExtentID   *extents;
+    ShardID    *shardids;
+    int            nextents;
+
+    if (len <= target->phs_extents_off)
+        return;
+
+    shards = heap_scan_visible_shards(relation, snapshot);
+    if (shards == NULL)
+    {
+        ExtentID   *shared = ParallelScanExtents(target);
+        int            i;
+
+        if (!enable_zone_map || RelationGetZoneMap(relation) == NULL)
+            return;
+
+        nextents = (target->phs_nblocks + PAGES_PER_EXTENTS - 1) / PAGES_PER_EXTENTS;
+        if ((Size) nextents > (len - target->phs_extents_off) / sizeof(ExtentID))
+            return;
+        for (i = 0; i < nextents; i++)
+            shared[i] = i;
+
+        target->phs_nextents = nextents;
+        target->phs_syncscan = false;
+        return;
+    }
+
+    extents = GetShardExtents(relation, shards, target->phs_nblocks,
+                              &nextents, &shardids);
+
+    /* else the relation grew past the room, hand out blocks */
+    if ((Size) nextents <= (len - target->phs_extents_off) / sizeof(ExtentID))
+    {
+        ShardExtent *sorted = (ShardExtent *) palloc(sizeof(ShardExtent) * Max(nextents, 1));
+        ExtentID   *shared = ParallelScanExtents(target);
+        int            i;
+
+        for (i = 0; i < nextents; i++)
+        {
+            sorted[i].shardid = shardids[i];
+            sorted[i].eid = extents[i];
+        }
+        qsort(sorted, nextents, sizeof(ShardExtent), shard_extent_cmp);
+        for (i = 0; i < nextents; i++)
+            shared[i] = sorted[i].eid;
+        pfree(sorted);
+
+        target->phs_nextents = nextents;
+        target->phs_syncscan = false;
+    }
+
+    pfree(extents);
+    pfree(shardids);
+    bms_free(shards);
+}
+#endif
+
 /* ----------------
  *		heap_parallelscan_reinitialize - reset a parallel scan
  *
@@ -2004,6 +2510,11 @@ heap_parallelscan_nextpage(HeapScanDesc scan)
 	Assert(scan->rs_parallel);
 	parallel_scan = scan->rs_parallel;
 
+#ifdef _SHARDING_
+	if (parallel_scan->phs_nextents >= 0)
+		return heap_parallelscan_nextextentpage(scan);
+#endif
+
 	/*
 	 * phs_nallocated tracks how many pages have been allocated to workers
 	 * already.  When phs_nallocated >= rs_nblocks, all blocks have been
@@ -2043,6 +2554,41 @@ heap_parallelscan_nextpage(HeapScanDesc scan)
     return page;
 }
 
+#ifdef _SHARDING_
+/*
+ * Next page of a parallel scan handing out extents: the one after the
+ * current page in its extent, else the first page of the next extent not
+ * handed out yet and not skipped by its zone map. phs_nallocated counts
+ * the extents handed out then.
+ */
+static BlockNumber
+heap_parallelscan_nextextentpage(HeapScanDesc scan)
+{
+    ParallelHeapScanDesc parallel_scan = scan->rs_parallel;
+    BlockNumber page = scan->rs_cblock;
+    uint64        nallocated;
+
+    if (page != InvalidBlockNumber &&
+        (page + 1) % PAGES_PER_EXTENTS != 0 && page + 1 < scan->rs_nblocks)
+        return page + 1;
+
+    for (;;)
+    {
+        ExtentID    eid;
+
+        nallocated = pg_atomic_fetch_add_u64(&parallel_scan->phs_nallocated, 1);
+        if (nallocated >= (uint64) parallel_scan->phs_nextents)
+            return InvalidBlockNumber;
+
+        eid = ParallelScanExtents(parallel_scan)[nallocated];
+        if (scan->rs_nzmkeys == 0 ||
+            ZoneMapExtentMayMatch(scan->rs_rd, eid,
+                                  scan->rs_zmkeys, scan->rs_nzmkeys))
+            return eid * PAGES_PER_EXTENTS;
+    }
+}
+#endif
+
 /* ----------------
  *        heap_update_snapshot
  *
@@ -2899,6 +3445,10 @@ heap_insert(Relation relation, HeapTuple tup, CommandId cid,
     if (vmbuffer != InvalidBuffer)
         ReleaseBuffer(vmbuffer);
 
+#ifdef _SHARDING_
+    ZoneMapNoteInsert(relation, heaptup);
+#endif
+
     /*
      * If tuple is cachable, mark it for invalidation from the caches in case
      * we abort.  Note it is OK to do this after releasing the buffer, because
@@ -3313,6 +3863,11 @@ heap_multi_insert(Relation relation, HeapTuple *tuples, int ntuples,
         if (vmbuffer != InvalidBuffer)
             ReleaseBuffer(vmbuffer);
 
+#ifdef _SHARDING_
+        for (i = 0; i < nthispage; i++)
+            ZoneMapNoteInsert(relation, heaptuples[ndone + i]);
+#endif
+
         ndone += nthispage;
     }
 
@@ -4963,6 +5518,10 @@ l2:
 
     pgstat_count_heap_update(relation, use_hot_update);
 
+#ifdef _SHARDING_
+    ZoneMapNoteInsert(relation, heaptup);
+#endif
+
     /*
      * If heaptup is a private copy, release it.  Don't forget to copy t_self
      * back to the caller's image, too.
@@ -33,6 +33,7 @@
 #include "utils/guc.h"
 #include "utils/lsyscache.h"
 #include "utils/pg_rusage.h"
+#include "portability/instr_time.h"
 #ifdef __OPENTENBASE__
 #include "catalog/pg_type.h"
 #include "utils/memutils.h"
@@ -74,6 +75,13 @@ extern bool FirstSnapshotSet;
 bool GTMDebugPrint = false;
 static GTM_Conn *conn;
 
+#ifdef __SUPPORT_DISTRIBUTED_TRANSACTION__
+/* global timestamps got in the statement started at gts_wait_stmt_start */
+static TimestampTz gts_wait_stmt_start = 0;
+static instr_time gts_wait_time;
+static int gts_wait_count = 0;
+#endif
+
 /* Used to check if needed to commit/abort at datanodes */
 GlobalTransactionId currentGxid = InvalidGlobalTransactionId;
 
@@ -1481,12 +1489,17 @@ GetGlobalTimestampGTM(void)
 	int  retry_cnt = 0;
 	Get_GTS_Result gts_result = {InvalidGlobalTimestamp,false};
 	GTM_Timestamp  latest_gts = InvalidGlobalTimestamp;
+	TimestampTz    stmt_start;
+	instr_time     wait_start;
+	instr_time     wait_end;
 
 	if (!g_set_global_snapshot)
 	{
 		return LocalCommitTimestamp;
 	}
 
+	INSTR_TIME_SET_CURRENT(wait_start);
+
     if (log_gtm_stats)
         ResetUsageCommon(&start_r, &start_t);
 
@@ -1550,6 +1563,18 @@ GetGlobalTimestampGTM(void)
     if (log_gtm_stats)
         ShowUsageCommon("BeginTranGTM", &start_r, &start_t);
 
+	/* account the wait to the statement, see GetStatementGTSWait */
+	INSTR_TIME_SET_CURRENT(wait_end);
+	stmt_start = GetCurrentStatementStartTimestamp();
+	if (stmt_start != gts_wait_stmt_start)
+	{
+		INSTR_TIME_SET_ZERO(gts_wait_time);
+		gts_wait_count = 0;
+		gts_wait_stmt_start = stmt_start;
+	}
+	INSTR_TIME_ACCUM_DIFF(gts_wait_time, wait_end, wait_start);
+	gts_wait_count++;
+
 	latest_gts = GetLatestCommitTS();
 	if (gts_result.gts != InvalidGlobalTimestamp && latest_gts > (gts_result.gts + GTM_CHECK_DELTA))
 	{
@@ -1573,6 +1598,24 @@ GetGlobalTimestampGTM(void)
 	
 	return gts_result.gts;
 }
+
+/*
+ * Time in msec the current statement waited for global timestamps from GTM,
+ * the snapshots taken included, and the number of them. The statement may
+ * have got the first one before it started, with the transaction.
+ */
+double
+GetStatementGTSWait(int *count)
+{
+	if (gts_wait_stmt_start != GetCurrentStatementStartTimestamp())
+	{
+		*count = 0;
+		return 0;
+	}
+
+	*count = gts_wait_count;
+	return INSTR_TIME_GET_MILLISEC(gts_wait_time);
+}
 #endif
 
 GlobalTransactionId
@@ -902,6 +902,9 @@ CREATE VIEW pg_stat_progress_vacuum AS
     FROM pg_stat_get_progress_info('VACUUM') AS S
 		LEFT JOIN pg_database D ON S.datid = D.oid;
 
+CREATE VIEW pg_stat_network_cost AS
+    SELECT * FROM opentenbase_network_cost();
+
 CREATE VIEW pg_user_mappings AS
     SELECT
         U.oid       AS umid,
@@ -280,6 +280,27 @@ typedef struct
     uint64        processed;        /* # of tuples processed */
 } DR_copy;
 
+#ifdef __OPENTENBASE__
+/*
+ * Rows the coordinator reads for a shard table, routed to the datanodes a
+ * batch at a time, see CopyFromRouteBatch.
+ */
+#define MAX_ROUTED_ROWS        1000
+#define MAX_ROUTED_BYTES    65536
+
+typedef struct CopyRouteBatch
+{
+    int            nrows;
+    Datum        values[MAX_ROUTED_ROWS];    /* distribution key of each row */
+    bool        nulls[MAX_ROUTED_ROWS];
+    void       *nodes[MAX_ROUTED_ROWS];    /* datanode of each row */
+    int            offsets[MAX_ROUTED_ROWS];    /* where each row is in data */
+    int            lens[MAX_ROUTED_ROWS];
+    int            linenos[MAX_ROUTED_ROWS];    /* input line of each row */
+    StringInfoData data;        /* the rows as read */
+} CopyRouteBatch;
+#endif
+
 
 /*
  * These macros centralize code used to process line_buf and raw_buf buffers.
@@ -377,6 +398,9 @@ static void CopyFromInsertBatch(CopyState cstate, EState *estate,
                     BulkInsertState bistate,
                     int nBufferedTuples, HeapTuple *bufferedTuples,
                     int firstBufferedLineNo);
+#ifdef __OPENTENBASE__
+static void CopyFromRouteBatch(CopyState cstate, CopyRouteBatch *batch);
+#endif
 static bool CopyReadLine(CopyState cstate);
 static bool CopyReadLineText(CopyState cstate);
 #ifdef __OPENTENBASE__
@@ -2977,6 +3001,7 @@ CopyFrom(CopyState cstate)
     int         npart             = 0;
     bool        need_to_reset     = false;
     bool        nomore            = false;
+    CopyRouteBatch *routeBatch    = NULL;
 #endif
 
     Assert(cstate->rel);
@@ -3240,6 +3265,17 @@ CopyFrom(CopyState cstate)
 #endif
     econtext = GetPerTupleExprContext(estate);
 
+#ifdef __OPENTENBASE__
+    /* the rows of a shard table are routed a batch at a time */
+    if (IS_PGXC_COORDINATOR && cstate->remoteCopyState &&
+        cstate->remoteCopyState->rel_loc &&
+        IsLocatorBatchable(cstate->remoteCopyState->locator))
+    {
+        routeBatch = (CopyRouteBatch *) palloc0(sizeof(CopyRouteBatch));
+        initStringInfo(&routeBatch->data);
+    }
+#endif
+
     /* Set up callback to identify error line number */
     errcallback.callback = CopyFromErrorCallback;
     errcallback.arg = (void *) cstate;
@@ -3266,7 +3302,11 @@ CopyFrom(CopyState cstate)
         {
 #endif
 
-        if (nBufferedTuples == 0)
+        if (nBufferedTuples == 0
+#ifdef __OPENTENBASE__
+            && (routeBatch == NULL || routeBatch->nrows == 0)
+#endif
+            )
         {
             /*
              * Reset the per-tuple exprcontext. We can only do this if the
@@ -3371,6 +3411,28 @@ readnextline:
             }
 #endif
 
+#ifdef __OPENTENBASE__
+            if (routeBatch)
+            {
+                int        nrows = routeBatch->nrows;
+
+                /* the key stays valid, the per-tuple memory is kept till sent */
+                routeBatch->values[nrows] = value;
+                routeBatch->nulls[nrows] = isnull;
+                routeBatch->offsets[nrows] = routeBatch->data.len;
+                routeBatch->lens[nrows] = cstate->line_buf.len;
+                routeBatch->linenos[nrows] = cstate->cur_lineno;
+                appendBinaryStringInfo(&routeBatch->data,
+                                       cstate->line_buf.data,
+                                       cstate->line_buf.len);
+                routeBatch->nrows++;
+
+                if (routeBatch->nrows == MAX_ROUTED_ROWS ||
+                    routeBatch->data.len >= MAX_ROUTED_BYTES)
+                    CopyFromRouteBatch(cstate, routeBatch);
+            }
+            else
+#endif
             if (DataNodeCopyIn(cstate->line_buf.data,
                                cstate->line_buf.len,
 #ifdef __COLD_HOT__
@@ -3867,6 +3929,11 @@ readnextline:
     }
 #endif
 
+#ifdef __OPENTENBASE__
+    if (routeBatch && routeBatch->nrows > 0)
+        CopyFromRouteBatch(cstate, routeBatch);
+#endif
+
     if (nBufferedTuples > 0)
     {
 		/* The data of > npart table is classified into the default partition */
@@ -4093,6 +4160,51 @@ CopyFromInsertBatch(CopyState cstate, EState *estate, CommandId mycid,
     cstate->cur_lineno = save_cur_lineno;
 }
 
+#ifdef __OPENTENBASE__
+/*
+ * Send the rows of the batch to their datanodes. The datanodes of all the
+ * rows are found at once, see GET_NODES_BATCH.
+ */
+static void
+CopyFromRouteBatch(CopyState cstate, CopyRouteBatch *batch)
+{
+    RemoteCopyData *rcstate = cstate->remoteCopyState;
+    int            i;
+    int            save_cur_lineno;
+
+    /*
+     * Print error context information correctly, if sending one of the
+     * rows fails.
+     */
+    cstate->line_buf_valid = false;
+    save_cur_lineno = cstate->cur_lineno;
+
+    GET_NODES_BATCH(rcstate->locator, batch->values, batch->nulls,
+                    batch->nrows, batch->nodes);
+
+    for (i = 0; i < batch->nrows; i++)
+    {
+        PGXCNodeHandle *handle = (PGXCNodeHandle *) batch->nodes[i];
+
+        cstate->cur_lineno = batch->linenos[i];
+        if (DataNodeCopyIn(batch->data.data + batch->offsets[i],
+                           batch->lens[i],
+                           1, &handle,
+                           (cstate->binary || cstate->insert_into)))
+        {
+            ereport(ERROR,
+                        (errcode(ERRCODE_CONNECTION_EXCEPTION),
+                         errmsg("Copy failed on a data node:%s%s", handle->error,
+                                '\0' != handle->error[0] ? ";" : "")));
+        }
+    }
+
+    batch->nrows = 0;
+    resetStringInfo(&batch->data);
+    cstate->cur_lineno = save_cur_lineno;
+}
+#endif
+
 /*
  * Setup to read tuples from a file for COPY FROM.
  *
@@ -17,6 +17,7 @@
  */
 #include "postgres.h"
 
+#include "access/gtm.h"
 #include "access/xact.h"
 #include "catalog/pg_collation.h"
 #include "catalog/pg_type.h"
@@ -118,6 +119,12 @@ static void show_tablesample(TableSampleClause *tsc, PlanState *planstate,
                  List *ancestors, ExplainState *es);
 static void show_sort_info(SortState *sortstate, ExplainState *es);
 static void show_hash_info(HashState *hashstate, ExplainState *es);
+#ifdef __OPENTENBASE__
+static void show_adaptive_exchange(RemoteSubplanState *planstate,
+								   ExplainState *es);
+static void show_exchange_instr(RemoteSubplanState *planstate,
+								ExplainState *es);
+#endif
 static void show_tidbitmap_info(BitmapHeapScanState *planstate,
                     ExplainState *es);
 static void show_instrumentation_count(const char *qlabel, int which,
@@ -194,6 +201,10 @@ ExplainQuery(ParseState *pstate, ExplainStmt *stmt, const char *queryString,
         else if (strcmp(opt->defname, "num_nodes") == 0)
             es->num_nodes = defGetBoolean(opt);
 #endif /* PGXC */
+#ifdef __OPENTENBASE__
+        else if (strcmp(opt->defname, "distributed") == 0)
+            es->distributed = defGetBoolean(opt);
+#endif
         else if (strcmp(opt->defname, "timing") == 0)
         {
             timing_set = true;
@@ -236,6 +247,13 @@ ExplainQuery(ParseState *pstate, ExplainStmt *stmt, const char *queryString,
                 (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
                  errmsg("EXPLAIN option BUFFERS requires ANALYZE")));
 
+#ifdef __OPENTENBASE__
+    if (es->distributed && !es->analyze)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("EXPLAIN option DISTRIBUTED requires ANALYZE")));
+#endif
+
     /* if the timing was not set explicitly, set default value */
     es->timing = (timing_set) ? es->timing : es->analyze;
 
@@ -529,6 +547,10 @@ ExplainOnePlan(PlannedStmt *plannedstmt, IntoClause *into, ExplainState *es,
 
     if (es->buffers)
         instrument_option |= INSTRUMENT_BUFFERS;
+#ifdef __OPENTENBASE__
+    if (es->distributed)
+        instrument_option |= INSTRUMENT_EXCHANGE;
+#endif
 
     /*
      * We always collect timing for the entire statement, even when node-level
@@ -644,6 +666,24 @@ ExplainOnePlan(PlannedStmt *plannedstmt, IntoClause *into, ExplainState *es,
                                  3, es);
     }
 
+#if defined(__OPENTENBASE__) && defined(__SUPPORT_DISTRIBUTED_TRANSACTION__)
+    /* time the statement waited for global timestamps */
+    if (es->summary && es->distributed && IS_PGXC_COORDINATOR)
+    {
+        int         gts_count;
+        double      gts_wait = GetStatementGTSWait(&gts_count);
+
+        if (es->format == EXPLAIN_FORMAT_TEXT)
+            appendStringInfo(es->str, "GTS wait time: %.3f ms (%d requests)\n",
+                             gts_wait, gts_count);
+        else
+        {
+            ExplainPropertyFloat("GTS Wait Time", gts_wait, 3, es);
+            ExplainPropertyInteger("GTS Requests", gts_count, es);
+        }
+    }
+#endif
+
     ExplainCloseGroup("Query", NULL, true, es);
 }
 
@@ -1622,6 +1662,12 @@ ExplainNode(PlanState *planstate, List *ancestors,
                 if (es->verbose)
                     show_simple_sort_keys((RemoteSubplanState *)planstate,
                                           ancestors, es);
+#ifdef __OPENTENBASE__
+                if (rsubplan->adaptive != REMOTE_ADAPTIVE_NONE)
+                    show_adaptive_exchange((RemoteSubplanState *) planstate, es);
+                if (es->analyze && es->distributed)
+                    show_exchange_instr((RemoteSubplanState *) planstate, es);
+#endif
             }
             break;
 #endif
@@ -1810,6 +1856,11 @@ ExplainNode(PlanState *planstate, List *ancestors,
             if (plan->qual)
                 show_instrumentation_count("Rows Removed by Filter", 1,
                                            planstate, es);
+#ifdef __OPENTENBASE__
+            /* may pass its input through, see agg_fill_hash_table */
+            if (((Agg *) plan)->adaptive)
+                ExplainPropertyText("Adaptive", "true", es);
+#endif
             break;
         case T_Group:
             show_group_keys(castNode(GroupState, planstate), ancestors, es);
@@ -2648,6 +2699,114 @@ show_sort_info(SortState *sortstate, ExplainState *es)
 #endif
 }
 
+#ifdef __OPENTENBASE__
+/*
+ * Show the exchange of an adaptive hash join side, the one chosen at run
+ * time if executed.
+ */
+static void
+show_adaptive_exchange(RemoteSubplanState *planstate, ExplainState *es)
+{
+	RemoteSubplan *plan = (RemoteSubplan *) planstate->combiner.ss.ps.plan;
+	const char *exchange = NULL;
+
+	if (!es->analyze)
+		exchange = plan->adaptive == REMOTE_ADAPTIVE_BUILD ?
+			"broadcast or distribute" : "local or distribute";
+	else
+	{
+		switch (planstate->adaptive_exchange)
+		{
+			case ADAPTIVE_EXCHANGE_BROADCAST:
+				exchange = "broadcast";
+				break;
+			case ADAPTIVE_EXCHANGE_DISTRIBUTE:
+				exchange = "distribute";
+				break;
+			case ADAPTIVE_EXCHANGE_LOCAL:
+				exchange = "local";
+				break;
+			case ADAPTIVE_EXCHANGE_MIXED:
+				exchange = "mixed";
+				break;
+			default:
+				/* not executed */
+				break;
+		}
+	}
+
+	if (exchange)
+		ExplainPropertyText("Adaptive Exchange", exchange, es);
+}
+
+/*
+ * Show the bytes received by the consumers of the exchange and their wait
+ * for them, and the time the producers spent sending rows and paused on full
+ * consumer queues.
+ */
+static void
+show_exchange_instr(RemoteSubplanState *planstate, ExplainState *es)
+{
+	ExchangeInstrumentation *exchange = &planstate->exchange;
+	int			nproducers = exchange->nproducers;
+
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		appendStringInfoSpaces(es->str, es->indent * 2);
+		appendStringInfo(es->str, "Exchange Received: " UINT64_FORMAT "kB",
+						 (exchange->recv_bytes + 1023) / 1024);
+		if (es->timing)
+			appendStringInfo(es->str, "  Wait: %.3f ms", exchange->recv_wait);
+		appendStringInfoChar(es->str, '\n');
+
+		if (nproducers > 0)
+		{
+			appendStringInfoSpaces(es->str, es->indent * 2);
+			appendStringInfo(es->str, "Exchange Producers: %d  Sent Rows: " UINT64_FORMAT,
+							 nproducers, exchange->send_rows);
+			if (es->timing)
+				appendStringInfo(es->str,
+								 "  Send: %.3f/%.3f/%.3f ms  Stall: %.3f/%.3f/%.3f ms (min/avg/max)",
+								 exchange->send_min,
+								 exchange->send_total / nproducers,
+								 exchange->send_max,
+								 exchange->stall_min,
+								 exchange->stall_total / nproducers,
+								 exchange->stall_max);
+			appendStringInfoChar(es->str, '\n');
+		}
+	}
+	else
+	{
+		ExplainPropertyLong("Exchange Received Bytes",
+							(long) exchange->recv_bytes, es);
+		if (es->timing)
+			ExplainPropertyFloat("Exchange Wait Time", exchange->recv_wait, 3, es);
+		ExplainPropertyInteger("Exchange Producers", nproducers, es);
+		if (nproducers > 0)
+		{
+			ExplainPropertyLong("Exchange Sent Rows",
+								(long) exchange->send_rows, es);
+			if (es->timing)
+			{
+				ExplainPropertyFloat("Exchange Min Send Time",
+									 exchange->send_min, 3, es);
+				ExplainPropertyFloat("Exchange Avg Send Time",
+									 exchange->send_total / nproducers, 3, es);
+				ExplainPropertyFloat("Exchange Max Send Time",
+									 exchange->send_max, 3, es);
+				ExplainPropertyFloat("Exchange Min Stall Time",
+									 exchange->stall_min, 3, es);
+				ExplainPropertyFloat("Exchange Avg Stall Time",
+									 exchange->stall_total / nproducers, 3, es);
+				ExplainPropertyFloat("Exchange Max Stall Time",
+									 exchange->stall_max, 3, es);
+			}
+		}
+	}
+}
+#endif
+
 /*
  * Show information on hash buckets/batches.
  */
@@ -17,6 +17,7 @@
 
 #include "commands/explain_dist.h"
 #include "executor/hashjoin.h"
+#include "executor/producerReceiver.h"
 #include "libpq/libpq.h"
 #include "libpq/pqformat.h"
 #include "nodes/nodeFuncs.h"
@@ -159,18 +160,35 @@ WorkerInstrOut(StringInfo buf, WorkerInstrumentation *worker_instr)
 }
 #endif
 
+/*
+ * ExchangeInstrOut
+ *
+ * Serialize ExchangeInstrumentation with the format "val,val,...,val>".
+ */
+static void
+ExchangeInstrOut(StringInfo buf, ExchangeInstrumentation *exchange)
+{
+	appendStringInfo(buf, UINT64_FORMAT ",%.3f,%d," UINT64_FORMAT ",",
+	                 exchange->recv_bytes, exchange->recv_wait,
+	                 exchange->nproducers, exchange->send_rows);
+	appendStringInfo(buf, "%.3f,%.3f,%.3f,%.3f,%.3f,%.3f>",
+	                 exchange->send_min, exchange->send_max, exchange->send_total,
+	                 exchange->stall_min, exchange->stall_max, exchange->stall_total);
+}
+
 /*
  * SpecInstrOut
  *
  * Serialize specific information in planstate with the format
  * "1/0<val,val,...,val>", and 1/0 indicates if values are valid or not.
+ * Values summed up over the nodes are sent with the first node only.
  *
  * NOTE: The function should be modified if the corresponding data structure
  * has been changed.
  * The function is VERY related to show_sort_info, show_hash_info.
  */
 static void
-SpecInstrOut(StringInfo buf, NodeTag plantag, PlanState *planstate)
+SpecInstrOut(StringInfo buf, NodeTag plantag, PlanState *planstate, bool first)
 {
 	switch(plantag)
 	{
@@ -242,6 +260,21 @@ SpecInstrOut(StringInfo buf, NodeTag plantag, PlanState *planstate)
 				appendStringInfo(buf, "0>");
 		}
 			break;
+		case T_RemoteSubplan:
+		{
+			RemoteSubplanState *rstate = (RemoteSubplanState *) planstate;
+			ExchangeInstrumentation none;
+			
+			appendStringInfo(buf, "%d,", (int) rstate->adaptive_exchange);
+			if (first)
+				ExchangeInstrOut(buf, &rstate->exchange);
+			else
+			{
+				memset(&none, 0, sizeof(ExchangeInstrumentation));
+				ExchangeInstrOut(buf, &none);
+			}
+		}
+			break;
 		case T_Hash:
 		{
 			/* according to show_hash_info */
@@ -436,6 +469,21 @@ SpecInstrIn(StringInfo str, RemoteInstr *instr)
 			}
 		}
 			break;
+		case T_RemoteSubplan:
+		{
+			INSTR_READ_FIELD(adaptive_exchange);
+			INSTR_READ_FIELD(exchange.recv_bytes);
+			INSTR_READ_FIELD(exchange.recv_wait);
+			INSTR_READ_FIELD(exchange.nproducers);
+			INSTR_READ_FIELD(exchange.send_rows);
+			INSTR_READ_FIELD(exchange.send_min);
+			INSTR_READ_FIELD(exchange.send_max);
+			INSTR_READ_FIELD(exchange.send_total);
+			INSTR_READ_FIELD(exchange.stall_min);
+			INSTR_READ_FIELD(exchange.stall_max);
+			INSTR_READ_FIELD(exchange.stall_total);
+		}
+			break;
 		case T_Hash:
 		{
 			bool isvalid = (bool) strtod(tmp_head, &tmp_pos);
@@ -490,6 +538,7 @@ SerializeLocalInstr(PlanState *planstate, SerializeState *ss)
 		{
 			/* re-send our received remote instr to upstream. */
 			int n;
+			bool first = true;
 			for (n = 0; n < planstate->dn_instrument->nnode; n++)
 			{
 				Instrumentation *instrument = &(planstate->dn_instrument->instrument[n].instr);
@@ -499,7 +548,8 @@ SerializeLocalInstr(PlanState *planstate, SerializeState *ss)
 				if (node_id != 0)
 				{
 					InstrOut(&ss->buf, planstate->plan, instrument, node_id);
-					SpecInstrOut(&ss->buf, nodeTag(planstate->plan), planstate);
+					SpecInstrOut(&ss->buf, nodeTag(planstate->plan), planstate, first);
+					first = false;
 				}
 				else
 				{
@@ -511,7 +561,7 @@ SerializeLocalInstr(PlanState *planstate, SerializeState *ss)
 		{
 			/* send our own instr */
 			InstrOut(&ss->buf, planstate->plan, planstate->instrument, 0);
-			SpecInstrOut(&ss->buf, nodeTag(planstate->plan), planstate);
+			SpecInstrOut(&ss->buf, nodeTag(planstate->plan), planstate, true);
 		}
 	}
 	else
@@ -524,13 +574,34 @@ SerializeLocalInstr(PlanState *planstate, SerializeState *ss)
 	return planstate_tree_walker(planstate, SerializeLocalInstr, ss);
 }
 
+/*
+ * ProducerInstrOut
+ *
+ * Serialize the measurements of the producer of the fragment rooted at plan
+ * with the format "Pplan_node_id{val,val,val}".
+ */
+static void
+ProducerInstrOut(StringInfo buf, Plan *plan, DestReceiver *dest)
+{
+	uint64  rows;
+	double  send_time;
+	double  stall_time;
+	
+	if (!GetProducerInstrument(dest, &rows, &send_time, &stall_time))
+		return;
+	
+	appendStringInfo(buf, "P%d{" UINT64_FORMAT ",%.3f,%.3f}",
+	                 plan->plan_node_id, rows, send_time, stall_time);
+}
+
 /*
  * SendLocalInstr
  *
- * Serialize local instrument of the given planstate and send it to upper node.
+ * Serialize local instrument of the given planstate and send it to upper node,
+ * followed by the measurements of dest if it distributes the results.
  */
 void
-SendLocalInstr(PlanState *planstate)
+SendLocalInstr(PlanState *planstate, DestReceiver *dest)
 {
 	SerializeState ss;
 	
@@ -538,11 +609,44 @@ SendLocalInstr(PlanState *planstate)
 	ss.printed_nodes = NULL;
 	pq_beginmessage(&ss.buf, 'i');
 	SerializeLocalInstr(planstate, &ss);
+	ProducerInstrOut(&ss.buf, planstate->plan, dest);
 	pq_endmessage(&ss.buf);
 	bms_free(ss.printed_nodes);
 	pq_flush();
 }
 
+/*
+ * combineExchangeInstr
+ *
+ * Add up the exchange instrument of src to target.
+ */
+static void
+combineExchangeInstr(ExchangeInstrumentation *target, ExchangeInstrumentation *src)
+{
+	target->recv_bytes += src->recv_bytes;
+	target->recv_wait = Max(target->recv_wait, src->recv_wait);
+	
+	if (src->nproducers <= 0)
+		return;
+	
+	if (target->nproducers <= 0)
+	{
+		target->send_min = src->send_min;
+		target->stall_min = src->stall_min;
+	}
+	else
+	{
+		target->send_min = Min(target->send_min, src->send_min);
+		target->stall_min = Min(target->stall_min, src->stall_min);
+	}
+	target->send_max = Max(target->send_max, src->send_max);
+	target->stall_max = Max(target->stall_max, src->stall_max);
+	target->send_total += src->send_total;
+	target->stall_total += src->stall_total;
+	target->send_rows += src->send_rows;
+	target->nproducers += src->nproducers;
+}
+
 static void
 combineSpecRemoteInstr(RemoteInstr *rtarget, RemoteInstr *rsrc)
 {
@@ -612,6 +716,16 @@ combineSpecRemoteInstr(RemoteInstr *rtarget, RemoteInstr *rsrc)
 			}
 		}
 			break;
+		case T_RemoteSubplan:
+		{
+			if (rtarget->adaptive_exchange == ADAPTIVE_EXCHANGE_NONE)
+				rtarget->adaptive_exchange = rsrc->adaptive_exchange;
+			else if (rsrc->adaptive_exchange != ADAPTIVE_EXCHANGE_NONE &&
+			         rsrc->adaptive_exchange != rtarget->adaptive_exchange)
+				rtarget->adaptive_exchange = ADAPTIVE_EXCHANGE_MIXED;
+			combineExchangeInstr(&rtarget->exchange, &rsrc->exchange);
+		}
+			break;
 		case T_Hash:
 		{
 			rtarget->hash_stat.nbuckets = Max(rtarget->hash_stat.nbuckets, rsrc->hash_stat.nbuckets);
@@ -693,6 +807,47 @@ combineRemoteInstr(RemoteInstr *rtarget, RemoteInstr *rsrc)
 	INSTR_MAX_FIELD(bufusage.blk_write_time.tv_nsec);
 	
 	combineSpecRemoteInstr(rtarget, rsrc);
+	combineExchangeInstr(&rtarget->producer, &rsrc->producer);
+}
+
+/*
+ * ProducerInstrIn
+ *
+ * DeSerialize the measurements of a producer, saving them with the top node
+ * of its fragment.
+ */
+static void
+ProducerInstrIn(StringInfo str, int nodeid, ResponseCombiner *combiner)
+{
+	RemoteInstrKey key;
+	RemoteInstr *rinstr;
+	ExchangeInstrumentation producer;
+	bool    found;
+	char   *tmp_pos;
+	char   *tmp_head = &str->data[str->cursor + 1];
+	
+	key.plan_node_id = (int) strtol(tmp_head, &tmp_pos, 0);
+	tmp_head = tmp_pos + 1;
+	key.node_id = nodeid;
+	
+	memset(&producer, 0, sizeof(ExchangeInstrumentation));
+	producer.nproducers = 1;
+	producer.send_rows = (uint64) strtod(tmp_head, &tmp_pos);
+	tmp_head = tmp_pos + 1;
+	producer.send_min = producer.send_max = producer.send_total = strtod(tmp_head, &tmp_pos);
+	tmp_head = tmp_pos + 1;
+	producer.stall_min = producer.stall_max = producer.stall_total = strtod(tmp_head, &tmp_pos);
+	tmp_head = tmp_pos + 1;
+	
+	str->cursor = tmp_head - &str->data[0];
+	
+	rinstr = (RemoteInstr *) hash_search(combiner->recv_instr_htbl,
+	                                     (void *) &key, HASH_FIND, &found);
+	if (found)
+		combineExchangeInstr(&rinstr->producer, &producer);
+	else
+		elog(DEBUG1, "no remote instr of producer plan_node_id %d node %d",
+		     key.plan_node_id, key.node_id);
 }
 
 /*
@@ -724,6 +879,13 @@ HandleRemoteInstr(char *msg_body, size_t len, int nodeid, ResponseCombiner *comb
 	
 	while(recv_str->cursor < recv_str->len)
 	{
+		/* measurements of the producer follow the plan nodes */
+		if (recv_str->data[recv_str->cursor] == 'P')
+		{
+			ProducerInstrIn(recv_str, nodeid, combiner);
+			continue;
+		}
+		
 		memset(&recv_instr, 0, sizeof(RemoteInstr));
 		recv_instr.sort_stat.sortMethod = -1;
 		recv_instr.sort_stat.spaceType = -1;
@@ -817,6 +979,13 @@ attachRemoteSpecificInstr(PlanState *planstate, RemoteInstr *rinstr)
 			}
 		}
 			break;
+		case T_RemoteSubplan:
+		{
+			RemoteSubplanState *rs = (RemoteSubplanState *) planstate;
+			rs->adaptive_exchange = rinstr->adaptive_exchange;
+			memcpy(&rs->exchange, &rinstr->exchange, sizeof(ExchangeInstrumentation));
+		}
+			break;
 		case T_Hash:
 		{
 			HashState *hs = (HashState *) planstate;
@@ -940,6 +1109,36 @@ AttachRemoteInstr(PlanState *planstate, AttachRemoteInstrContext *ctx)
 	return planstate_tree_walker(planstate, AttachRemoteInstr, ctx);
 }
 
+/*
+ * AttachRemoteProducerInstr
+ *
+ * Add the measurements of the producers of the fragment below node, saved
+ * in the combiner, to its exchange instrument.
+ */
+void
+AttachRemoteProducerInstr(RemoteSubplanState *node, AttachRemoteInstrContext *ctx)
+{
+	PlanState  *planstate = outerPlanState(node);
+	RemoteInstrKey key;
+	RemoteInstr *rinstr;
+	bool        found;
+	ListCell   *lc;
+	
+	if (planstate == NULL || ctx->htab == NULL)
+		return;
+	
+	key.plan_node_id = planstate->plan->plan_node_id;
+	foreach(lc, ctx->node_idx_List)
+	{
+		key.node_id = get_pgxc_node_id(get_nodeoid_from_nodeid(lfirst_int(lc), PGXC_NODE_DATANODE));
+		rinstr = (RemoteInstr *) hash_search(ctx->htab,
+		                                     (void *) &key,
+		                                     HASH_FIND, &found);
+		if (found)
+			combineExchangeInstr(&node->exchange, &rinstr->producer);
+	}
+}
+
 /*
  * ExplainCommonRemoteInstr
  *
@@ -957,6 +1156,10 @@ ExplainCommonRemoteInstr(PlanState *planstate, ExplainState *es)
 	double startup_sec_min, startup_sec_max, startup_sec;
 	double total_sec_min, total_sec_max, total_sec;
 	double rows_min, rows_max, rows;
+	/* for avg display of distributed */
+	double total_sec_sum = 0;
+	double rows_sum = 0;
+	int    nexecuted = 0;
 	/* for verbose */
 	StringInfoData buf;
 	
@@ -1008,6 +1211,13 @@ ExplainCommonRemoteInstr(PlanState *planstate, ExplainState *es)
 		SET_MIN_MAX(total_sec_min, total_sec_max, total_sec);
 		SET_MIN_MAX(rows_min, rows_max, rows);
 		
+		if (nloops > 0)
+		{
+			total_sec_sum += total_sec;
+			rows_sum += rows;
+			nexecuted++;
+		}
+		
 		/* one line for each dn if verbose */
 		if (es->verbose)
 		{
@@ -1066,6 +1276,23 @@ ExplainCommonRemoteInstr(PlanState *planstate, ExplainState *es)
 				appendStringInfo(es->str,
 				                 "DN (actual rows=%.0f..%.0f loops=%.0f..%.0f)",
 				                 rows_min, rows_max, nloops_min, nloops_max);
+			
+			/* skew of the nodes, max over avg */
+			if (es->distributed && nexecuted > 0)
+			{
+				appendStringInfoChar(es->str, '\n');
+				appendStringInfoSpaces(es->str, es->indent * 2);
+				if (es->timing)
+					appendStringInfo(es->str,
+					                 "DN Skew: avg total time=%.3f avg rows=%.0f",
+					                 total_sec_sum / nexecuted, rows_sum / nexecuted);
+				else
+					appendStringInfo(es->str, "DN Skew: avg rows=%.0f",
+					                 rows_sum / nexecuted);
+				if (rows_sum > 0)
+					appendStringInfo(es->str, " max/avg rows=%.2f",
+					                 rows_max * nexecuted / rows_sum);
+			}
 		}
 		
 		if (es->verbose)
@@ -1087,6 +1314,13 @@ ExplainCommonRemoteInstr(PlanState *planstate, ExplainState *es)
 		}
 		ExplainPropertyFloat("Actual Min Rows", rows_min, 0, es);
 		ExplainPropertyFloat("Actual Max Rows", rows_max, 0, es);
+		if (es->distributed && nexecuted > 0)
+		{
+			if (es->timing)
+				ExplainPropertyFloat("Actual Avg Total Time",
+				                     total_sec_sum / nexecuted, 3, es);
+			ExplainPropertyFloat("Actual Avg Rows", rows_sum / nexecuted, 0, es);
+		}
 		ExplainPropertyFloat("Actual Min Loops", nloops_min, 0, es);
 		ExplainPropertyFloat("Actual Max Loops", nloops_max, 0, es);
 	}
@@ -246,6 +246,15 @@ volatile ReDistributeStatus *workerStatus = NULL;
 bool g_hybrid_hash_agg = false;
 bool g_hybrid_hash_agg_debug = false;
 int  g_default_hashagg_nbatches = 32;
+
+/* GUC parameters for partial aggregation below a redistribution */
+bool enable_adaptive_partial_agg = false;
+double partial_agg_reduction_ratio = 0.5;
+
+/* input rows between the checks whether a partial aggregation reduces */
+#define ADAPTIVE_AGG_CHECK_ROWS 10000
+/* input rows before the groups are compared with them */
+#define ADAPTIVE_AGG_SAMPLE_ROWS 100000
 #endif
 
 /*
@@ -612,6 +621,10 @@ static AggStatePerGroup *lookup_hash_entries(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
 static void agg_fill_hash_table(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
+#ifdef __OPENTENBASE__
+static bool agg_partial_reduces_poorly(AggState *aggstate, uint64 input_rows);
+static TupleTableSlot *agg_retrieve_passthrough(AggState *aggstate);
+#endif
 static Datum GetAggInitVal(Datum textInitVal, Oid transtype);
 static void build_pertrans_for_aggref(AggStatePerTrans pertrans,
                           AggState *aggstate, EState *estate,
@@ -3030,6 +3043,13 @@ ExecAgg(PlanState *pstate)
             case AGG_HASHED:
                 if (!node->table_filled)
                     agg_fill_hash_table(node);
+#ifdef __OPENTENBASE__
+                if (node->passthrough)
+                {
+                    result = agg_retrieve_passthrough(node);
+                    break;
+                }
+#endif
                 /* FALLTHROUGH */
             case AGG_MIXED:
                 result = agg_retrieve_hash_table(node);
@@ -3417,8 +3437,12 @@ agg_fill_hash_table(AggState *aggstate)
 #ifdef __OPENTENBASE__
     AttrNumber varattno = InvalidAttrNumber;
     Oid                dataType = InvalidOid;
+    bool            adaptive = aggstate->adaptive;
+    uint64            input_rows = 0;
 
     aggstate->tmpcxt = NULL;
+    aggstate->passthrough = false;
+    aggstate->passthrough_groups_done = false;
 
     /* get the redistribution hashfunc for parallel execution */
     if (IsParallelWorker() && aggstate->state)
@@ -3476,6 +3500,9 @@ agg_fill_hash_table(AggState *aggstate)
 												 ALLOCSET_DEFAULT_SIZES);
 
 		elog(LOG, "worker:%d redistributed in HashAgg.", ParallelWorkerNumber);
+
+		/* the rows of a group meet only in the worker they are sent to */
+		adaptive = false;
     }
 #endif
 
@@ -3591,6 +3618,19 @@ agg_fill_hash_table(AggState *aggstate)
          * hash lookups do this too
          */
         ResetExprContext(aggstate->tmpcontext);
+
+#ifdef __OPENTENBASE__
+        /* leave the rest of the input to agg_retrieve_passthrough */
+        if (adaptive && ++input_rows % ADAPTIVE_AGG_CHECK_ROWS == 0 &&
+            agg_partial_reduces_poorly(aggstate, input_rows))
+        {
+            aggstate->passthrough = true;
+            elog(DEBUG1, "partial aggregation passes rows through after "
+                 UINT64_FORMAT " rows in %u groups", input_rows,
+                 aggstate->perhash[0].hashtable->hashtab->members);
+            break;
+        }
+#endif
     }
 
     aggstate->table_filled = true;
@@ -3741,6 +3781,103 @@ agg_retrieve_hash_table(AggState *aggstate)
     return NULL;
 }
 
+#ifdef __OPENTENBASE__
+/*
+ * Does the partial aggregation reduce its input too little to be worth it?
+ * It does if its hashtable has grown beyond work_mem, or if it has more
+ * groups than partial_agg_reduction_ratio of the rows read so far. The
+ * groups grow slower than the rows, a few thousand of them would reduce well
+ * over the whole input but not over the first rows: they are only compared
+ * once ADAPTIVE_AGG_SAMPLE_ROWS rows are read.
+ */
+static bool
+agg_partial_reduces_poorly(AggState *aggstate, uint64 input_rows)
+{
+    TupleHashTable hashtable = aggstate->perhash[0].hashtable;
+    double        ngroups = (double) hashtable->hashtab->members;
+    Size        entrysize;
+
+    if (input_rows >= ADAPTIVE_AGG_SAMPLE_ROWS &&
+        ngroups > partial_agg_reduction_ratio * (double) input_rows)
+        return true;
+
+    entrysize = hash_agg_entry_size(aggstate->numtrans) +
+        MAXALIGN(SizeofMinimalTupleHeader) +
+        MAXALIGN(aggstate->ss.ps.plan->plan_width);
+
+    return ngroups * entrysize > work_mem * 1024.0;
+}
+
+/*
+ * ExecAgg for a partial aggregation that stopped aggregating: return the
+ * groups of the hash table, then every remaining input row as a group of its
+ * own. The final aggregation above the redistribution combines them all.
+ *
+ * The transition values of a passed row live in the aggcontext of the first
+ * grouping set, which hashing does not use otherwise.
+ */
+static TupleTableSlot *
+agg_retrieve_passthrough(AggState *aggstate)
+{
+    ExprContext *econtext = aggstate->ss.ps.ps_ExprContext;
+    ExprContext *tmpcontext = aggstate->tmpcontext;
+    AggStatePerGroup pergroup;
+    TupleTableSlot *outerslot;
+    TupleTableSlot *result;
+
+    if (!aggstate->passthrough_groups_done)
+    {
+        result = agg_retrieve_hash_table(aggstate);
+        if (!TupIsNull(result))
+            return result;
+
+        /* the hashtable is done with, release it before reading on */
+        aggstate->passthrough_groups_done = true;
+        aggstate->agg_done = false;
+        ReScanExprContext(aggstate->hashcontext);
+        aggstate->perhash[0].hashtable = NULL;
+    }
+
+    if (aggstate->passthrough_pergroup == NULL)
+        aggstate->passthrough_pergroup = (AggStatePerGroup)
+            MemoryContextAllocZero(aggstate->ss.ps.state->es_query_cxt,
+                                   sizeof(AggStatePerGroupData) * aggstate->numtrans);
+    pergroup = aggstate->passthrough_pergroup;
+
+    while (!aggstate->agg_done)
+    {
+        CHECK_FOR_INTERRUPTS();
+
+        outerslot = fetch_input_tuple(aggstate);
+        if (TupIsNull(outerslot))
+        {
+            aggstate->agg_done = true;
+            break;
+        }
+
+        /* the previous row has been returned, forget its values */
+        ReScanExprContext(aggstate->aggcontexts[0]);
+        ResetExprContext(econtext);
+        ResetExprContext(tmpcontext);
+
+        tmpcontext->ecxt_outertuple = outerslot;
+        select_current_set(aggstate, 0, false);
+        initialize_aggregates(aggstate, pergroup, -1);
+        advance_aggregates(aggstate, pergroup, NULL);
+
+        econtext->ecxt_outertuple = outerslot;
+        prepare_projection_slot(aggstate, outerslot, 0);
+        finalize_aggregates(aggstate, aggstate->peragg, pergroup);
+
+        result = project_aggregates(aggstate);
+        if (result)
+            return result;
+    }
+
+    return NULL;
+}
+#endif
+
 /* -----------------
  * ExecInitAgg
  *
@@ -3806,6 +3943,12 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
     aggstate->state    = NULL;
     aggstate->file     = NULL;    
     aggstate->dataslot = NULL;
+    aggstate->adaptive = node->adaptive && enable_adaptive_partial_agg &&
+        node->aggstrategy == AGG_HASHED && !node->hybrid &&
+        DO_AGGSPLIT_SKIPFINAL(node->aggsplit);
+    aggstate->passthrough = false;
+    aggstate->passthrough_groups_done = false;
+    aggstate->passthrough_pergroup = NULL;
 #endif
 
     /*
@@ -5121,6 +5264,9 @@ ExecReScanAgg(AggState *node)
          * rescan the existing hash table; no need to build it again.
          */
         if (outerPlan->chgParam == NULL &&
+#ifdef __OPENTENBASE__
+            !node->passthrough &&
+#endif
             !bms_overlap(node->ss.ps.chgParam, aggnode->aggParams))
         {
             ResetTupleHashIterator(node->perhash[0].hashtable,
@@ -27,6 +27,7 @@
 #ifdef __OPENTENBASE__
 #include "access/xact.h"
 #include "executor/execParallel.h"
+#include "pgxc/execRemote.h"
 #endif
 
 /*
@@ -164,8 +165,16 @@ ExecHashJoin(PlanState *pstate)
                           !node->hj_OuterNotEmpty))
                 {
 #ifdef __OPENTENBASE__
-                    /* When we need to prefetch inner, we just assume there is at lease one row from outer plan */
-                    if (!hashJoin->join.prefetch_inner)
+                    /*
+                     * When we need to prefetch inner, we just assume there is
+                     * at lease one row from outer plan. The same for the probe
+                     * side of an adaptive exchange: it may only be bound once
+                     * the build side knows whether it was broadcast, fetching
+                     * from it now would always redistribute it.
+                     */
+                    if (!hashJoin->join.prefetch_inner &&
+                        !(IsA(outerNode, RemoteSubplanState) &&
+                          ((RemoteSubplanState *) outerNode)->adaptive_peer != NULL))
                     {
                         node->hj_OuterInited = true;
 #endif
@@ -654,6 +663,12 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	outerPlanState(hjstate) = ExecInitNode(outerNode, estate, eflags);
 	innerPlanState(hjstate) = ExecInitNode((Plan *) hashNode, estate, eflags);
 
+#ifdef __OPENTENBASE__
+	/* the sides may choose their exchange together, see ExecRemoteSubplan */
+	ExecLinkAdaptiveRemoteSubplans(outerPlanState(hjstate),
+								   outerPlanState(innerPlanState(hjstate)));
+#endif
+
 	/*
 	 * tuple table initialization
 	 */
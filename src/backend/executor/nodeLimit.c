@@ -308,6 +308,28 @@ recompute_limits(LimitState *node)
         node->noCount = true;
     }
 
+#ifdef __OPENTENBASE__
+	/*
+	 * A limit pushed down below a RemoteSubplan returns the rows of the
+	 * window and the ones skipped before it; the upper Limit applies the
+	 * OFFSET. If the sum overflows there is nothing to limit.
+	 */
+	if (((Limit *) node->ps.plan)->includeOffset)
+	{
+		if (!node->noCount)
+		{
+			if (node->count > PG_INT64_MAX - node->offset)
+			{
+				node->count = 0;
+				node->noCount = true;
+			}
+			else
+				node->count += node->offset;
+		}
+		node->offset = 0;
+	}
+#endif
+
     /* Reset position to start-of-scan */
     node->position = 0;
     node->subSlot = NULL;
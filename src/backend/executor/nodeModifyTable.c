@@ -2750,6 +2750,12 @@ END:
     /* Restore es_result_relation_info before exiting */
     estate->es_result_relation_info = saved_resultRelInfo;
 
+#ifdef __OPENTENBASE__
+    /* rows may still be on their way to the datanodes */
+    if (node->mt_remoterels)
+        ExecFinishRemoteDML(node);
+#endif
+
     /*
      * We're done, but fire AFTER STATEMENT triggers before exiting.
      */
@@ -3446,6 +3452,8 @@ ExecEndModifyTable(ModifyTableState *node)
 		{
 			int nremote_plans = list_length(plan->remote_plans);
 
+			ExecFinishRemoteDML(node);
+
 			for (i = 0; i < nremote_plans; i++)
 			{
 				RemoteQuery *rq = (RemoteQuery *)list_nth(plan->remote_plans, i);
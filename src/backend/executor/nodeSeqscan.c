@@ -33,6 +33,15 @@
 #include "executor/execdebug.h"
 #include "executor/nodeSeqscan.h"
 #include "utils/rel.h"
+#ifdef _SHARDING_
+#include "access/nbtree.h"
+#include "catalog/pg_am.h"
+#include "commands/defrem.h"
+#include "optimizer/clauses.h"
+#include "optimizer/var.h"
+#include "storage/zonemap.h"
+#include "utils/lsyscache.h"
+#endif
 #ifdef _MLS_
 #include "utils/mls.h"
 #endif
@@ -44,6 +53,10 @@
 
 static bool InitScanRelation(SeqScanState *node, EState *estate, int eflags);
 static TupleTableSlot *SeqNext(SeqScanState *node);
+#ifdef _SHARDING_
+static void InitZoneMapKeys(SeqScanState *node);
+static void SetScanZoneMap(SeqScanState *node);
+#endif
 
 /* ----------------------------------------------------------------
  *						Scan Support
@@ -88,6 +101,9 @@ SeqNext(SeqScanState *node)
 							estate->es_snapshot->start_ts, RelationGetRelationName(node->ss.ss_currentRelation));
 		}
 		node->ss.ss_currentScanDesc = scandesc;
+#ifdef _SHARDING_
+		SetScanZoneMap(node);
+#endif
 	}
 
 	/*
@@ -287,6 +303,10 @@ ExecInitSeqScan(SeqScan *node, EState *estate, int eflags)
 		return NULL;
 	}
 
+#ifdef _SHARDING_
+	InitZoneMapKeys(scanstate);
+#endif
+
 	/*
 	 * Initialize result tuple type and projection info.
 	 */
@@ -356,8 +376,14 @@ ExecReScanSeqScan(SeqScanState *node)
 	scan = node->ss.ss_currentScanDesc;
 
 	if (scan != NULL)
+	{
 		heap_rescan(scan,		/* scan desc */
 					NULL);		/* new scan keys */
+#ifdef _SHARDING_
+		/* the values of the keys may have changed */
+		SetScanZoneMap(node);
+#endif
+	}
 
 	ExecScanReScan((ScanState *) node);
 }
@@ -380,6 +406,10 @@ ExecSeqScanEstimate(SeqScanState *node,
 	EState	   *estate = node->ss.ps.state;
 
 	node->pscan_len = heap_parallelscan_estimate(estate->es_snapshot);
+#ifdef _SHARDING_
+	node->pscan_len = heap_parallelscan_shard_estimate(node->ss.ss_currentRelation,
+													   node->pscan_len);
+#endif
 	shm_toc_estimate_chunk(&pcxt->estimator, node->pscan_len);
 	shm_toc_estimate_keys(&pcxt->estimator, 1);
 }
@@ -401,9 +431,17 @@ ExecSeqScanInitializeDSM(SeqScanState *node,
 	heap_parallelscan_initialize(pscan,
 								 node->ss.ss_currentRelation,
 								 estate->es_snapshot);
+#ifdef _SHARDING_
+	heap_parallelscan_initialize_shards(pscan, node->pscan_len,
+										node->ss.ss_currentRelation,
+										estate->es_snapshot);
+#endif
 	shm_toc_insert(pcxt->toc, node->ss.ps.plan->plan_node_id, pscan);
 	node->ss.ss_currentScanDesc =
 		heap_beginscan_parallel(node->ss.ss_currentRelation, pscan);
+#ifdef _SHARDING_
+	SetScanZoneMap(node);
+#endif
 }
 
 /* ----------------------------------------------------------------
@@ -436,4 +474,166 @@ ExecSeqScanInitializeWorker(SeqScanState *node,
 	pscan = shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id, false);
 	node->ss.ss_currentScanDesc =
 		heap_beginscan_parallel(node->ss.ss_currentRelation, pscan);
+#ifdef _SHARDING_
+	SetScanZoneMap(node);
+#endif
 }
+
+#ifdef _SHARDING_
+/* ----------------------------------------------------------------
+ *		InitZoneMapKeys
+ *
+ *		Make scan keys of the quals the zone map of the relation can
+ *		evaluate: column op value, the column being summarized and the
+ *		operator a member of the btree opfamily of its type, the value
+ *		not depending on the row scanned. See ZoneMapExtentMayMatch.
+ * ----------------------------------------------------------------
+ */
+static void
+InitZoneMapKeys(SeqScanState *node)
+{
+	Relation	rel = node->ss.ss_currentRelation;
+	SeqScan    *plan = (SeqScan *) node->ss.ps.plan;
+	ZoneMapDesc *desc = RelationGetZoneMap(rel);
+	ListCell   *lc;
+
+	node->zm_keys = NULL;
+	node->zm_keyexprs = NULL;
+	node->zm_nkeys = 0;
+
+	if (desc == NULL || !enable_zone_map || plan->plan.qual == NIL)
+		return;
+
+	node->zm_keys = (ScanKey)
+		palloc(sizeof(ScanKeyData) * list_length(plan->plan.qual));
+	node->zm_keyexprs = (ExprState **)
+		palloc(sizeof(ExprState *) * list_length(plan->plan.qual));
+
+	foreach(lc, plan->plan.qual)
+	{
+		OpExpr	   *clause = (OpExpr *) lfirst(lc);
+		ScanKey		key = &node->zm_keys[node->zm_nkeys];
+		Node	   *leftop;
+		Node	   *rightop;
+		Var		   *var;
+		Expr	   *value;
+		Oid			opclass;
+		Oid			opfamily;
+		Oid			lefttype;
+		Oid			righttype;
+		int			strategy;
+		RegProcedure cmp;
+		int			i;
+
+		if (!IsA(clause, OpExpr) || list_length(clause->args) != 2)
+			continue;
+
+		leftop = (Node *) linitial(clause->args);
+		if (leftop && IsA(leftop, RelabelType))
+			leftop = (Node *) ((RelabelType *) leftop)->arg;
+		rightop = (Node *) lsecond(clause->args);
+		if (rightop && IsA(rightop, RelabelType))
+			rightop = (Node *) ((RelabelType *) rightop)->arg;
+
+		if (leftop && IsA(leftop, Var))
+		{
+			var = (Var *) leftop;
+			value = (Expr *) rightop;
+		}
+		else if (rightop && IsA(rightop, Var))
+		{
+			var = (Var *) rightop;
+			value = (Expr *) leftop;
+		}
+		else
+			continue;
+
+		if (var->varno != plan->scanrelid || var->varlevelsup != 0)
+			continue;
+		for (i = 0; i < desc->natts; i++)
+		{
+			if (desc->attnums[i] == var->varattno)
+				break;
+		}
+		if (i == desc->natts)
+			continue;
+		if (contain_var_clause((Node *) value) ||
+			contain_volatile_functions((Node *) value))
+			continue;
+
+		opclass = GetDefaultOpClass(RelationGetDescr(rel)->attrs[var->varattno - 1]->atttypid,
+									BTREE_AM_OID);
+		if (!OidIsValid(opclass))
+			continue;
+		opfamily = get_opclass_family(opclass);
+		if (!op_in_opfamily(clause->opno, opfamily))
+			continue;
+		get_op_opfamily_properties(clause->opno, opfamily, false,
+								   &strategy, &lefttype, &righttype);
+		if ((Node *) var != leftop)
+		{
+			Oid			temp = lefttype;
+
+			/* value op column */
+			strategy = BTCommuteStrategyNumber(strategy);
+			lefttype = righttype;
+			righttype = temp;
+		}
+
+		/* the keys are kept past the per-tuple memory of the values */
+		if (!get_typbyval(righttype))
+			continue;
+		cmp = get_opfamily_proc(opfamily, lefttype, righttype, BTORDER_PROC);
+		if (!RegProcedureIsValid(cmp))
+			continue;
+
+		ScanKeyEntryInitialize(key, 0, var->varattno, strategy, righttype,
+							   clause->inputcollid, cmp, (Datum) 0);
+		node->zm_keyexprs[node->zm_nkeys] = NULL;
+		if (IsA(value, Const))
+		{
+			key->sk_argument = ((Const *) value)->constvalue;
+			if (((Const *) value)->constisnull)
+				key->sk_flags |= SK_ISNULL;
+		}
+		else
+			node->zm_keyexprs[node->zm_nkeys] =
+				ExecInitExpr(value, (PlanState *) node);
+		node->zm_nkeys++;
+	}
+}
+
+/*
+ * Compute the values of the zone map keys, and hand them to the scan
+ * started or restarted.
+ */
+static void
+SetScanZoneMap(SeqScanState *node)
+{
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	int			i;
+
+	if (node->zm_nkeys == 0)
+		return;
+
+	for (i = 0; i < node->zm_nkeys; i++)
+	{
+		ScanKey		key = &node->zm_keys[i];
+		bool		isnull;
+
+		if (node->zm_keyexprs[i] == NULL)
+			continue;
+
+		/* passed by value, see InitZoneMapKeys */
+		key->sk_argument = ExecEvalExprSwitchContext(node->zm_keyexprs[i],
+													 econtext, &isnull);
+		if (isnull)
+			key->sk_flags |= SK_ISNULL;
+		else
+			key->sk_flags &= ~SK_ISNULL;
+	}
+
+	heap_setscanzonemap(node->ss.ss_currentScanDesc,
+						node->zm_keys, node->zm_nkeys);
+}
+#endif
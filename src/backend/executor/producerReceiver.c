@@ -21,6 +21,7 @@
 
 #include "executor/producerReceiver.h"
 #include "pgxc/nodemgr.h"
+#include "portability/instr_time.h"
 #include "tcop/pquery.h"
 #include "utils/tuplestore.h"
 #include "utils/timestamp.h"
@@ -40,6 +41,12 @@ typedef struct
 #ifdef __OPENTENBASE__
     DataPumpSender sender;             /* used to send data locally, could be NULL */
     int16 *nodeMap;
+    /* exchange chosen by the consumers, see SetProducerAdaptive */
+    char adaptive;
+    long adaptiveRows;                /* rows to broadcast */
+    Locator *bcastLocator;            /* determines all the consumers */
+    int *bcastNodes;                /* array where to get its results */
+    int localConsumer;                /* consumer of the local node */
 #endif
     MemoryContext tmpcxt;           /* holds temporary data */
     Tuplestorestate **tstores;        /* storage to buffer data if destination queue
@@ -51,6 +58,11 @@ typedef struct
 #ifdef __OPENTENBASE__
     uint64      send_tuples;        /* number of tuples sent to remote */
     TimestampTz send_total_time;    /* total time to send tuples */
+    /* for EXPLAIN ANALYZE, see SetProducerInstrument */
+    bool        instrument;
+    instr_time  send_time;          /* handing rows to the consumer queues */
+    instr_time  stall_time;         /* paused on full consumer queues */
+    instr_time  stall_start;        /* start of the pause, zero if running */
 #endif
 } ProducerState;
 
@@ -83,6 +95,81 @@ producerStartupReceiver(DestReceiver *self, int operation, TupleDesc typeinfo)
         (*myState->consumer->rStartup) (myState->consumer, operation, typeinfo);
 }
 
+/*
+ * Hand a tuple over to the consumer
+ */
+static void
+producerDispatchSlot(ProducerState *myState, TupleTableSlot *slot,
+                     int consumerIdx)
+{
+    if (consumerIdx == SQ_CONS_NONE)
+    {
+        return;
+    }
+    else if (consumerIdx == SQ_CONS_SELF)
+    {
+        Assert(myState->consumer);
+        (*myState->consumer->receiveSlot) (slot, myState->consumer);
+        myState->selfcount++;
+    }
+    else if (myState->squeue)
+    {
+        /*
+         * If the tuple will not fit to the consumer queue it will be stored
+         * in the local tuplestore. The tuplestore should be in the portal
+         * context, because ExecutorContext may be destroyed when tuples
+         * are not yet pushed to the consumer queue.
+         */
+        MemoryContext savecontext;
+#ifdef __OPENTENBASE__
+        instr_time  start;
+
+        if (myState->instrument)
+            INSTR_TIME_SET_CURRENT(start);
+#endif
+        Assert(ActivePortal);
+        savecontext = MemoryContextSwitchTo(PortalGetHeapMemory(ActivePortal));
+        if (g_UseDataPump)
+        {
+            TimestampTz begin = 0;
+            TimestampTz end   = 0;
+
+            if (enable_statistic)
+            {
+                begin = GetCurrentTimestamp();
+            }
+            
+            SendDataRemote(myState->squeue, consumerIdx, slot, 
+                                                        &myState->tstores[consumerIdx], 
+                                                        myState->tmpcxt);
+
+            if (enable_statistic)
+            {
+                end   = GetCurrentTimestamp();
+
+                myState->send_tuples++;
+                myState->send_total_time += (end - begin);
+            }
+        }
+        else
+        {
+            SharedQueueWrite(myState->squeue, consumerIdx, slot,
+                             &myState->tstores[consumerIdx], myState->tmpcxt);
+        }
+        MemoryContextSwitchTo(savecontext);
+        myState->othercount++;
+#ifdef __OPENTENBASE__
+        if (myState->instrument)
+        {
+            instr_time  end;
+
+            INSTR_TIME_SET_CURRENT(end);
+            INSTR_TIME_ACCUM_DIFF(myState->send_time, end, start);
+        }
+#endif
+    }
+}
+
 /*
  * Receive a tuple from the executor and dispatch it to the proper consumer
  */
@@ -94,6 +181,33 @@ producerReceiveSlot(TupleTableSlot *slot, DestReceiver *self)
     bool        isnull;
     int         ncount, i;
 
+#ifdef __OPENTENBASE__
+    if (myState->adaptive == SQ_ADAPTIVE_LOCAL)
+    {
+        myState->tcount++;
+        producerDispatchSlot(myState, slot, myState->localConsumer);
+        return true;
+    }
+
+    /*
+     * One row more than the consumers may broadcast, so that every one of
+     * them sees whether there were more.
+     */
+    if (myState->adaptive == SQ_ADAPTIVE_BROADCAST &&
+        myState->tcount <= myState->adaptiveRows)
+    {
+        myState->tcount++;
+#ifdef __COLD_HOT__
+        ncount = GET_NODES(myState->bcastLocator, (Datum) 0, true, 0, true, NULL);
+#else
+        ncount = GET_NODES(myState->bcastLocator, (Datum) 0, true, NULL);
+#endif
+        for (i = 0; i < ncount; i++)
+            producerDispatchSlot(myState, slot, myState->bcastNodes[i]);
+        return true;
+    }
+#endif
+
     if (myState->distKey == InvalidAttrNumber)
     {
         value = (Datum) 0;
@@ -140,57 +254,7 @@ producerReceiveSlot(TupleTableSlot *slot, DestReceiver *self)
             consumerIdx = myState->distNodes[i];
         }
 
-        if (consumerIdx == SQ_CONS_NONE)
-        {
-            continue;
-        }
-        else if (consumerIdx == SQ_CONS_SELF)
-        {
-            Assert(myState->consumer);
-            (*myState->consumer->receiveSlot) (slot, myState->consumer);
-            myState->selfcount++;
-        }
-        else if (myState->squeue)
-        {
-            /*
-             * If the tuple will not fit to the consumer queue it will be stored
-             * in the local tuplestore. The tuplestore should be in the portal
-             * context, because ExecutorContext may be destroyed when tuples
-             * are not yet pushed to the consumer queue.
-             */
-            MemoryContext savecontext;
-            Assert(ActivePortal);
-            savecontext = MemoryContextSwitchTo(PortalGetHeapMemory(ActivePortal));
-            if (g_UseDataPump)
-            {
-                TimestampTz begin = 0;
-                TimestampTz end   = 0;
-
-                if (enable_statistic)
-                {
-                    begin = GetCurrentTimestamp();
-                }
-                
-                SendDataRemote(myState->squeue, consumerIdx, slot, 
-                                                            &myState->tstores[consumerIdx], 
-                                                            myState->tmpcxt);
-
-                if (enable_statistic)
-                {
-                    end   = GetCurrentTimestamp();
-
-                    myState->send_tuples++;
-                    myState->send_total_time += (end - begin);
-                }
-            }
-            else
-            {
-                SharedQueueWrite(myState->squeue, consumerIdx, slot,
-                                 &myState->tstores[consumerIdx], myState->tmpcxt);
-            }
-            MemoryContextSwitchTo(savecontext);
-            myState->othercount++;
-        }
+        producerDispatchSlot(myState, slot, consumerIdx);
     }
 
     return true;
@@ -278,6 +342,10 @@ producerDestroyReceiver(DestReceiver *self)
     /* Release workspace if any */
     if (myState->locator)
         freeLocator(myState->locator);
+#ifdef __OPENTENBASE__
+    if (myState->bcastLocator)
+        freeLocator(myState->bcastLocator);
+#endif
     pfree(myState);
 }
 
@@ -304,6 +372,12 @@ CreateProducerDestReceiver(void)
     self->send_tuples     = 0;
     self->send_total_time = 0;
     self->nodeMap = NULL;
+    self->adaptive = SQ_ADAPTIVE_NONE;
+    self->bcastLocator = NULL;
+    self->instrument = false;
+    INSTR_TIME_SET_ZERO(self->send_time);
+    INSTR_TIME_SET_ZERO(self->stall_time);
+    INSTR_TIME_SET_ZERO(self->stall_start);
 #endif
 
     return (DestReceiver *) self;
@@ -417,4 +491,132 @@ SetProducerNodeMap(DestReceiver *self, int16 *nodemap)
 
     memcpy(myState->nodeMap, nodemap, sizeof(int16) * MAX_NODES_NUMBER);
 }
+
+/*
+ * Set the exchange the consumers have chosen at run time instead of the
+ * planned distribution, see ExecRemoteSubplan. The consumers are given as
+ * the nodes of distNodes mapped to consMap.
+ *
+ * SQ_ADAPTIVE_BROADCAST sends the first rows + 1 rows to every consumer
+ * and distributes the rest as planned, so a consumer that gets more than
+ * rows rows from the producer knows that it distributes.
+ * SQ_ADAPTIVE_LOCAL sends every row to the consumer on the local node, if
+ * there is one.
+ */
+void
+SetProducerAdaptive(DestReceiver *self, char adaptive, int rows,
+                    List *distNodes, int *consMap)
+{
+    ProducerState *myState = (ProducerState *) self;
+    int            len = list_length(distNodes);
+
+    Assert(myState->pub.mydest == DestProducer);
+
+    if (adaptive == SQ_ADAPTIVE_BROADCAST)
+    {
+#ifdef _MIGRATE_
+        myState->bcastLocator = createLocator(LOCATOR_TYPE_REPLICATED,
+                                              RELATION_ACCESS_INSERT,
+                                              InvalidOid,
+                                              LOCATOR_LIST_INT,
+                                              len,
+                                              consMap,
+                                              NULL,
+                                              false,
+                                              InvalidOid, InvalidOid, InvalidOid,
+                                              InvalidAttrNumber, InvalidOid);
+#else
+        myState->bcastLocator = createLocator(LOCATOR_TYPE_REPLICATED,
+                                              RELATION_ACCESS_INSERT,
+                                              InvalidOid,
+                                              LOCATOR_LIST_INT,
+                                              len,
+                                              consMap,
+                                              NULL,
+                                              false);
+#endif
+        myState->bcastNodes = (int *) getLocatorResults(myState->bcastLocator);
+        myState->adaptiveRows = rows;
+        myState->adaptive = adaptive;
+    }
+    else if (adaptive == SQ_ADAPTIVE_LOCAL)
+    {
+        ListCell   *lc;
+        int         i = 0;
+
+        foreach(lc, distNodes)
+        {
+            if (lfirst_int(lc) == PGXCNodeId - 1)
+            {
+                /* the local node does not consume, distribute as planned */
+                if (consMap[i] != SQ_CONS_NONE)
+                {
+                    myState->localConsumer = consMap[i];
+                    myState->adaptive = adaptive;
+                }
+                break;
+            }
+            i++;
+        }
+    }
+}
+
+/*
+ * Measure the producer for EXPLAIN ANALYZE: the time spent handing rows to
+ * the consumer queues, and the time paused because all of them were full.
+ */
+void
+SetProducerInstrument(DestReceiver *self)
+{
+    ProducerState *myState = (ProducerState *) self;
+
+    Assert(myState->pub.mydest == DestProducer);
+    myState->instrument = true;
+}
+
+/*
+ * The producing portal pauses or resumes, see AdvanceProducingPortal.
+ */
+void
+ProducerReceiverPause(DestReceiver *self, bool paused)
+{
+    ProducerState *myState = (ProducerState *) self;
+
+    Assert(myState->pub.mydest == DestProducer);
+    if (!myState->instrument)
+        return;
+
+    if (paused)
+    {
+        if (INSTR_TIME_IS_ZERO(myState->stall_start))
+            INSTR_TIME_SET_CURRENT(myState->stall_start);
+    }
+    else if (!INSTR_TIME_IS_ZERO(myState->stall_start))
+    {
+        instr_time  end;
+
+        INSTR_TIME_SET_CURRENT(end);
+        INSTR_TIME_ACCUM_DIFF(myState->stall_time, end, myState->stall_start);
+        INSTR_TIME_SET_ZERO(myState->stall_start);
+    }
+}
+
+/*
+ * Get the measurements of an instrumented producer so far, times in msec.
+ * Returns false if the receiver is not one.
+ */
+bool
+GetProducerInstrument(DestReceiver *self, uint64 *rows,
+                      double *send_time, double *stall_time)
+{
+    ProducerState *myState = (ProducerState *) self;
+
+    if (self == NULL || self->mydest != DestProducer || !myState->instrument)
+        return false;
+
+    *rows = myState->othercount;
+    *send_time = INSTR_TIME_GET_MILLISEC(myState->send_time);
+    *stall_time = INSTR_TIME_GET_MILLISEC(myState->stall_time);
+    return true;
+}
 #endif
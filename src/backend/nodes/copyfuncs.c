@@ -1051,6 +1051,7 @@ _copyAgg(const Agg *from)
 	COPY_SCALAR_FIELD(entrySize);
 	COPY_SCALAR_FIELD(hybrid);
 	COPY_SCALAR_FIELD(noDistinct);
+	COPY_SCALAR_FIELD(adaptive);
 #endif
 
     return newnode;
@@ -1202,6 +1203,7 @@ _copyLimit(const Limit *from)
     COPY_NODE_FIELD(limitCount);
 #ifdef __OPENTENBASE__
 	COPY_SCALAR_FIELD(skipEarlyFinish);
+	COPY_SCALAR_FIELD(includeOffset);
 #endif
     return newnode;
 }
@@ -1429,6 +1431,8 @@ _copyRemoteSubplan(const RemoteSubplan *from)
 #ifdef __OPENTENBASE__
     COPY_SCALAR_FIELD(parallelWorkerSendTuple);
 	COPY_BITMAPSET_FIELD(initPlanParams);
+	COPY_SCALAR_FIELD(adaptive);
+	COPY_SCALAR_FIELD(adaptiveRows);
 #endif
     return newnode;
 }
@@ -1448,6 +1452,47 @@ _copyDistribution(const Distribution *from)
 
     return newnode;
 }
+
+/*
+ * _copyRemoteStmt
+ */
+static RemoteStmt *
+_copyRemoteStmt(const RemoteStmt *from)
+{
+    RemoteStmt *newnode = makeNode(RemoteStmt);
+
+    COPY_SCALAR_FIELD(commandType);
+    COPY_SCALAR_FIELD(hasReturning);
+#ifdef __OPENTENBASE__
+    COPY_SCALAR_FIELD(parallelModeNeeded);
+    COPY_SCALAR_FIELD(parallelWorkerSendTuple);
+#endif
+    COPY_NODE_FIELD(planTree);
+    COPY_NODE_FIELD(rtable);
+    COPY_NODE_FIELD(resultRelations);
+    COPY_NODE_FIELD(subplans);
+    COPY_SCALAR_FIELD(nParamExec);
+    COPY_SCALAR_FIELD(nParamRemote);
+    if (from->nParamRemote > 0)
+        COPY_POINTER_FIELD(remoteparams,
+                           from->nParamRemote * sizeof(RemoteParam));
+    COPY_NODE_FIELD(rowMarks);
+    COPY_SCALAR_FIELD(distributionType);
+    COPY_SCALAR_FIELD(distributionKey);
+    COPY_NODE_FIELD(distributionNodes);
+    COPY_NODE_FIELD(distributionRestrict);
+#ifdef __OPENTENBASE__
+    COPY_SCALAR_FIELD(haspart_tobe_modify);
+    COPY_SCALAR_FIELD(partrelindex);
+    COPY_BITMAPSET_FIELD(partpruning);
+#endif
+#ifdef __AUDIT__
+    COPY_STRING_FIELD(queryString);
+    COPY_NODE_FIELD(parseTree);
+#endif
+
+    return newnode;
+}
 #endif
 
 
@@ -5553,6 +5598,9 @@ copyObjectImpl(const void *from)
         case T_Distribution:
             retval = _copyDistribution(from);
             break;
+        case T_RemoteStmt:
+            retval = _copyRemoteStmt(from);
+            break;
 #endif
             /*
              * PRIMITIVE NODES
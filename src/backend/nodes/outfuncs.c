@@ -1337,6 +1337,7 @@ _outAgg(StringInfo str, const Agg *node)
 	WRITE_UINT_FIELD(entrySize);
 	WRITE_BOOL_FIELD(hybrid);
 	WRITE_BOOL_FIELD(noDistinct);
+	WRITE_BOOL_FIELD(adaptive);
 #endif
 }
 
@@ -1687,6 +1688,7 @@ _outLimit(StringInfo str, const Limit *node)
     WRITE_NODE_FIELD(limitCount);
 #ifdef __OPENTENBASE__
     WRITE_BOOL_FIELD(skipEarlyFinish);
+    WRITE_BOOL_FIELD(includeOffset);
 #endif
 }
 
@@ -1709,6 +1711,8 @@ _outRemoteSubplan(StringInfo str, const RemoteSubplan *node)
 	WRITE_INT64_FIELD(unique);
     WRITE_BOOL_FIELD(parallelWorkerSendTuple);
 	WRITE_BITMAPSET_FIELD(initPlanParams);
+	WRITE_CHAR_FIELD(adaptive);
+	WRITE_INT_FIELD(adaptiveRows);
 
 #ifdef __OPENTENBASE__
     if (IS_PGXC_COORDINATOR && !g_set_global_snapshot)
@@ -3339,6 +3343,7 @@ _outAggPath(StringInfo str, const AggPath *node)
 	WRITE_UINT_FIELD(entrySize);
 	WRITE_BOOL_FIELD(hybrid);
 	WRITE_BOOL_FIELD(noDistinct);
+	WRITE_BOOL_FIELD(adaptive);
 #endif
 }
 
@@ -3476,6 +3481,7 @@ _outLimitPath(StringInfo str, const LimitPath *node)
     WRITE_NODE_FIELD(limitCount);
 #ifdef __OPENTENBASE__
     WRITE_BOOL_FIELD(skipEarlyFinish);
+    WRITE_BOOL_FIELD(includeOffset);
 #endif
 }
 
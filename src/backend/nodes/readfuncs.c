@@ -3307,6 +3307,7 @@ _readAgg(void)
 	READ_UINT_FIELD(entrySize);
 	READ_BOOL_FIELD(hybrid);
 	READ_BOOL_FIELD(noDistinct);
+	READ_BOOL_FIELD(adaptive);
 #endif
 
     READ_DONE();
@@ -3685,6 +3686,7 @@ _readLimit(void)
     READ_NODE_FIELD(limitCount);
 #ifdef __OPENTENBASE__
 	READ_BOOL_FIELD(skipEarlyFinish);
+	READ_BOOL_FIELD(includeOffset);
 #endif
     READ_DONE();
 }
@@ -3835,6 +3837,8 @@ _readRemoteSubplan(void)
     READ_INT64_FIELD(unique);
     READ_BOOL_FIELD(parallelWorkerSendTuple);
 	READ_BITMAPSET_FIELD(initPlanParams);
+	READ_CHAR_FIELD(adaptive);
+	READ_INT_FIELD(adaptiveRows);
 
     READ_DONE();
 }
@@ -102,6 +102,7 @@
 #include "utils/tuplesort.h"
 #ifdef __OPENTENBASE__
 #include "optimizer/planner.h"
+#include "pgxc/netcost.h"
 #include "utils/ruleutils.h"
 #include "storage/lmgr.h"
 #endif
@@ -143,6 +144,7 @@ bool		enable_material = true;
 bool		enable_mergejoin = true;
 bool		enable_hashjoin = true;
 bool		enable_fast_query_shipping = true;
+bool		enable_fqs_generic_plan = false;
 bool		enable_gathermerge = true;
 bool        enable_partition_wise_join = false;
 bool		enable_nestloop_suppression = false;
@@ -5303,8 +5305,14 @@ cost_remote_subplan(Path *path,
               Cost input_startup_cost, Cost input_total_cost,
 			  double tuples, int width, int replication)
 {
-    Cost        startup_cost = input_startup_cost + remote_query_cost;
+    Cost        startup_cost;
     Cost        run_cost = input_total_cost - input_startup_cost;
+    double      byte_cost;
+    double      query_cost;
+
+    /* configured, or measured with enable_network_cost_calibration */
+    GetNetworkCost(&byte_cost, &query_cost);
+    startup_cost = input_startup_cost + query_cost;
 
 	path->rows = tuples * replication;
 
@@ -5316,7 +5324,7 @@ cost_remote_subplan(Path *path,
     /*
      * Estimate cost of sending data over network
      */
-	run_cost += network_byte_cost * tuples * width * replication;
+	run_cost += byte_cost * tuples * width * replication;
 
     path->startup_cost = startup_cost;
     path->total_cost = startup_cost + run_cost;
@@ -2375,6 +2375,7 @@ create_agg_plan(PlannerInfo *root, AggPath *best_path)
 	}
 
 	plan->noDistinct = best_path->noDistinct;
+	plan->adaptive = best_path->adaptive;
 #endif
 
     return plan;
@@ -3106,6 +3107,9 @@ create_limit_plan(PlannerInfo *root, LimitPath *best_path, int flags,
                       best_path->limitCount,
 					  offset_est, count_est,
 					  best_path->skipEarlyFinish);
+#ifdef __OPENTENBASE__
+	plan->includeOffset = best_path->includeOffset;
+#endif
 
     copy_generic_path_info(&plan->plan, (Path *) best_path);
 
@@ -3247,6 +3251,20 @@ create_remotescan_plan(PlannerInfo *root,
                               best_path->path.pathkeys);
 
 #ifdef __OPENTENBASE__
+	/*
+	 * The exchange of a hash join side may change at run time, unless the
+	 * rows are merged in order or sent by parallel workers directly.
+	 */
+	if (best_path->adaptive != REMOTE_ADAPTIVE_NONE &&
+		plan->sort == NULL && !plan->parallelWorkerSendTuple &&
+		(plan->distributionType == LOCATOR_TYPE_HASH ||
+		 plan->distributionType == LOCATOR_TYPE_SHARD ||
+		 plan->distributionType == LOCATOR_TYPE_MODULO))
+	{
+		plan->adaptive = best_path->adaptive;
+		plan->adaptiveRows = adaptive_broadcast_rows;
+	}
+
     if (olap_optimizer)
     {
         plan->scan.plan.startup_cost = ((Path *)best_path)->startup_cost;
@@ -8073,6 +8091,7 @@ make_agg(List *tlist, List *qual,
 	node->hybrid = false;
 	node->entrySize = 0;
 	node->noDistinct = false;
+	node->adaptive = false;
 #endif
     plan->qual = qual;
     plan->targetlist = tlist;
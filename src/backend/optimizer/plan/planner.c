@@ -25,6 +25,7 @@
 #include "access/parallel.h"
 #include "access/sysattr.h"
 #include "access/xact.h"
+#include "catalog/pg_aggregate.h"
 #include "catalog/pg_constraint_fn.h"
 #include "catalog/pg_proc.h"
 #include "catalog/pg_type.h"
@@ -245,6 +246,8 @@ static Path *adjust_modifytable_subpath(PlannerInfo *root, Query *parse, Path *p
 static bool can_distinct_agg_optimize(PlannerInfo *root, RelOptInfo *input_rel,
                                       RelOptInfo *grouped_rel, PathTarget *pathtarget,
                                       const AggClauseCosts *agg_costs);
+static bool can_push_down_limit_expr(Node *expr);
+static bool limit_expr_walker(Node *node, void *context);
 #endif
 
 /*****************************************************************************
@@ -2543,6 +2546,32 @@ grouping_planner(PlannerInfo *root, bool inheritance_update,
 					pushDown = true;
 #endif
                 }
+#ifdef __OPENTENBASE__
+				/*
+				 * A LIMIT or OFFSET given as a parameter, as in the generic
+				 * plan of a prepared statement, is pushed down as it is. The
+				 * remote Limit adds up the two when it is executed, so every
+				 * node still returns at most (limit + offset) rows, bounding
+				 * its sort as well.
+				 */
+				else if (parse->limitCount && count_est != 0 &&
+						 can_push_down_limit_expr(parse->limitCount) &&
+						 can_push_down_limit_expr(parse->limitOffset))
+				{
+					int64		remote_count_est = -1;
+
+					if (offset_est >= 0 && count_est > 0)
+						remote_count_est = offset_est + count_est;
+
+					path = (Path *) create_limit_path(root, final_rel, path,
+													  parse->limitOffset,
+													  parse->limitCount,
+													  0, remote_count_est,
+													  false);
+					((LimitPath *) path)->includeOffset = true;
+					pushDown = true;
+				}
+#endif
 
                 path = create_remotesubplan_path(root, path, NULL);
             }
@@ -4326,6 +4355,7 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
    bool        try_parallel_aggregation;
     bool		try_distributed_aggregation;
 	bool		try_distributed_distinct_agg_optimize;
+	bool		adaptive_partial_agg = false;
 	PathTarget *partial_grouping_target = NULL;
 
 	ListCell   *lc;
@@ -4799,6 +4829,19 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 														  agg_costs,
 														  dNumGroups);
 
+#ifdef __OPENTENBASE__
+			/*
+			 * A partial HashAgg that reduces the rows enough is worth it even
+			 * if its hashtable may not fit in work_mem: it passes the rest of
+			 * its input through to the final aggregation once the hashtable
+			 * grows too large or the groups turn out to reduce too little.
+			 */
+			if (enable_adaptive_partial_agg && !g_hybrid_hash_agg &&
+				cheapest_path->rows > 0 &&
+				dNumPartialGroups <= cheapest_path->rows * partial_agg_reduction_ratio)
+				adaptive_partial_agg = true;
+#endif
+
 			/*
 			 * Provided that the estimated size of the hashtable does not exceed
 			 * work_mem, we'll generate a HashAgg Path, although if we were unable
@@ -4807,7 +4850,7 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 			 */
 #ifdef __OPENTENBASE__
 			if (hashaggtablesize < work_mem * 1024L || g_hybrid_hash_agg ||
-				grouped_rel->pathlist == NIL)
+				adaptive_partial_agg || grouped_rel->pathlist == NIL)
 #else
 			if (hashaggtablesize < work_mem * 1024L ||
 				grouped_rel->pathlist == NIL)
@@ -4838,6 +4881,10 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 
 						aggpath->hybrid = true;
 					}
+
+					/* the producer side of the exchange, see agg_fill_hash_table */
+					if (enable_adaptive_partial_agg && !g_hybrid_hash_agg)
+						((AggPath *) agg_path)->adaptive = true;
 #endif
 
 #ifdef __OPENTENBASE__
@@ -4875,6 +4922,10 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
                             
 							aggpath->hybrid = true;
                         }
+
+						/* only the partial side adapts, the final one must fit */
+						if (hashaggtablesize < work_mem * 1024L ||
+							g_hybrid_hash_agg || !can_sort)
 #endif
 						add_path(grouped_rel, agg_path);
                     }
@@ -4940,7 +4991,69 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
         }
     }
 
-	if (try_distributed_distinct_agg_optimize)
+	if (try_distributed_distinct_agg_optimize && parse->groupClause)
+	{
+		Aggref *agg = get_optimize_distinct_agg(target);
+
+		/*
+		 * With GROUP BY, the rows are redistributed by the distinct argument,
+		 * so all the rows of a (group key, distinct value) pair meet on one
+		 * datanode. Each node then aggregates its groups with the duplicates
+		 * removed, and the partial states of a group from all the nodes are
+		 * combined where the group key is redistributed to. The same group
+		 * may come from every node, so the partial groups are not fewer.
+		 */
+		foreach (lc, input_rel->pathlist)
+		{
+			Path *path = (Path *)lfirst(lc);
+
+			/* check if we need redistribute */
+			if (!grouping_distribution_match(root, parse, path, agg->aggdistinct, agg->args))
+			{
+				path = create_redistribute_distinct_agg_path(root, parse, path, agg);
+			}
+
+			/* distinct aggregates are evaluated group by group */
+			if (!pathkeys_contained_in(root->group_pathkeys, path->pathkeys))
+			{
+				path = (Path *) create_sort_path(root,
+												 grouped_rel,
+												 path,
+												 root->group_pathkeys,
+												 -1.0);
+			}
+
+			path = (Path *)create_agg_path(root,
+			                               grouped_rel,
+			                               path,
+			                               partial_grouping_target,
+			                               AGG_SORTED,
+			                               AGGSPLIT_INITIAL_SERIAL,
+			                               parse->groupClause,
+			                               NIL,
+			                               &agg_partial_costs,
+			                               dNumPartialGroups);
+			/* partial is not parallel safe */
+			path->parallel_safe = false;
+
+			path = create_redistribute_grouping_path(root, parse, path);
+
+			path = (Path *)create_agg_path(root,
+			                               grouped_rel,
+			                               path,
+			                               target,
+			                               AGG_HASHED,
+			                               AGGSPLIT_FINAL_DESERIAL,
+			                               parse->groupClause,
+			                               NIL,
+			                               &agg_final_costs,
+			                               dNumGroups);
+			((AggPath *)path)->noDistinct = true;
+
+			add_path(grouped_rel, path);
+		}
+	}
+	else if (try_distributed_distinct_agg_optimize)
 	{
 		List *groupExprs = NIL;
 		Aggref *agg = get_optimize_distinct_agg(target);
@@ -8485,6 +8598,7 @@ can_distinct_agg_optimize(PlannerInfo *root, RelOptInfo *input_rel,
 {
 	ListCell *lc = NULL;
 	Query  *parse = NULL;
+	List   *aggrefs = NIL;
 	bool meet_distint_agg_clause = false;
 
 	parse = root->parse;
@@ -8492,13 +8606,57 @@ can_distinct_agg_optimize(PlannerInfo *root, RelOptInfo *input_rel,
     /* It's no use for 2phase agg on datanode */
 	if (!grouped_rel->consider_parallel || input_rel->partial_pathlist == NIL ||
 	    !agg_costs->hasOnlyDistinct || agg_costs->hasNonSerial || agg_costs->hasOrder ||
-	    parse->groupClause || parse->groupingSets || parse->havingQual ||
+	    parse->groupingSets || parse->havingQual ||
 	    parse->distinctClause || has_cold_hot_table || !olap_optimizer || !enable_distinct_optimizer ||
 	    IS_PGXC_DATANODE)
 	{
 		return false;
 	}
 
+	/*
+	 * The groups are deduplicated sorted on the datanodes, and combined hashed
+	 * where their key is redistributed to.
+	 */
+	if (parse->groupClause &&
+		(!grouping_is_sortable(parse->groupClause) ||
+		 !grouping_is_hashable(parse->groupClause)))
+	{
+		return false;
+	}
+
+	/*
+	 * Every aggregate is combined from the partial states of the nodes, the
+	 * distinct one as well.
+	 */
+	aggrefs = pull_var_clause((Node *) pathtarget->exprs,
+							  PVC_INCLUDE_AGGREGATES |
+							  PVC_RECURSE_WINDOWFUNCS |
+							  PVC_RECURSE_PLACEHOLDERS);
+	foreach (lc, aggrefs)
+	{
+		Aggref	   *aggref = (Aggref *) lfirst(lc);
+		HeapTuple	aggTuple;
+		bool		combinable;
+
+		if (!IsA(aggref, Aggref))
+			continue;
+
+		aggTuple = SearchSysCache1(AGGFNOID,
+								   ObjectIdGetDatum(aggref->aggfnoid));
+		if (!HeapTupleIsValid(aggTuple))
+			elog(ERROR, "cache lookup failed for aggregate %u",
+				 aggref->aggfnoid);
+		combinable = OidIsValid(((Form_pg_aggregate) GETSTRUCT(aggTuple))->aggcombinefn);
+		ReleaseSysCache(aggTuple);
+
+		if (!combinable)
+		{
+			list_free(aggrefs);
+			return false;
+		}
+	}
+	list_free(aggrefs);
+
 	foreach (lc, pathtarget->exprs)
 	{
 		Aggref *aggref = (Aggref *)lfirst(lc);
@@ -8581,4 +8739,36 @@ adjust_modifytable_subpath(PlannerInfo *root, Query *parse, Path *path)
 
     return path;
 }
+
+/*
+ * Can a LIMIT/OFFSET expression be evaluated on the remote nodes, giving the
+ * same value there as here? Constants and the parameters of the statement,
+ * which are sent along with the remote subplan, can.
+ */
+static bool
+can_push_down_limit_expr(Node *expr)
+{
+	if (expr == NULL)
+		return true;
+
+	if (contain_volatile_functions(expr))
+		return false;
+
+	return !limit_expr_walker(expr, NULL);
+}
+
+static bool
+limit_expr_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Param))
+		return ((Param *) node)->paramkind != PARAM_EXTERN;
+
+	if (IsA(node, Var) || IsA(node, SubLink) || IsA(node, SubPlan))
+		return true;
+
+	return expression_tree_walker(node, limit_expr_walker, context);
+}
 #endif
@@ -58,6 +58,7 @@
 #ifdef __OPENTENBASE__
 #include "optimizer/planmain.h"
 #include "catalog/pgxc_class.h"
+#include "pgxc/shardmap.h"
 #endif
 #ifdef __COLD_HOT__
 #include "catalog/pgxc_key_values.h"
@@ -117,7 +118,7 @@ preprocess_targetlist(PlannerInfo *root, List *tlist)
                 else
                     group = InvalidOid;
 
-                groupOids = list_append_unique_oid(groupOids, group);
+                groupOids = AppendShardMapGroup(groupOids, group);
 
 #ifdef __COLD_HOT__
                 if (AttributeNumberIsValid(ret_loc_info->secAttrNum) 
@@ -52,6 +52,8 @@
 #include "optimizer/pgxcship.h"
 #include "pgxc/groupmgr.h"
 #include "pgxc/pgxcnode.h"
+#include "pgxc/planner.h"
+#include "pgxc/shardmap.h"
 #include "utils/memutils.h"
 #endif
 
@@ -70,6 +72,10 @@ int replication_level;
 bool restrict_query = false;
 /* Support fast query shipping for subquery */
 bool enable_subquery_shipping = false;
+/* Choose between broadcast and redistribution of hash joins at run time */
+bool enable_adaptive_distribution = false;
+/* Largest inner side of such join still broadcast, in rows per producer */
+int adaptive_broadcast_rows = 1000;
 
 /* join will happen in these nodes forcibly */
 char  *g_constrain_group; /* the GUC variable */
@@ -1305,7 +1311,7 @@ set_scanpath_distribution(PlannerInfo *root, RelOptInfo *rel, Path *pathnode)
                 }
                 else
                 {
-                    groupOids = list_append_unique_oid(groupOids, group);
+                    groupOids = AppendShardMapGroup(groupOids, group);
                 }
             }
 #endif
@@ -1592,6 +1598,45 @@ redistribute_path(PlannerInfo *root, Path *subpath, List *pathkeys,
     }
 }
 
+#ifdef __OPENTENBASE__
+/*
+ * Add the groups whose shard maps may place the rows of the path to groups.
+ * A scan of a sharded table follows the map of its group. Rows redistributed
+ * by shard, here or below a join, follow the map of the first group of the
+ * query, and the rows of a subquery may come from any group of it.
+ */
+static List *
+path_shard_groups(PlannerInfo *root, Path *path, List *groups)
+{
+    int         relid = -1;
+    ListCell   *lc;
+
+    if (IsA(path, RemoteSubPath) || bms_membership(path->parent->relids) != BMS_SINGLETON)
+    {
+        if (groupOids)
+            groups = AppendShardMapGroup(groups, linitial_oid(groupOids));
+    }
+
+    while ((relid = bms_next_member(path->parent->relids, relid)) >= 0)
+    {
+        RangeTblEntry   *rte = planner_rt_fetch(relid, root);
+        RelationLocInfo *rel_loc_info;
+
+        if (rte->rtekind != RTE_RELATION)
+        {
+            foreach(lc, groupOids)
+                groups = AppendShardMapGroup(groups, lfirst_oid(lc));
+            continue;
+        }
+
+        rel_loc_info = GetRelationLocInfo(rte->relid);
+        if (rel_loc_info && rel_loc_info->locatorType == LOCATOR_TYPE_SHARD)
+            groups = AppendShardMapGroup(groups, GetRelGroup(rte->relid));
+    }
+
+    return groups;
+}
+#endif
 
 /*
  * Analyze join parameters and set distribution of the join node.
@@ -1805,7 +1850,14 @@ set_joinpath_distribution(PlannerInfo *root, JoinPath *pathnode)
 		innerd->distributionExpr &&
 		outerd->distributionExpr &&
 	    bms_equal(innerd->nodes, outerd->nodes) &&
-	    BMS_EQUAL_CONSTRAINT(innerd->nodes))
+	    BMS_EQUAL_CONSTRAINT(innerd->nodes)
+#ifdef __OPENTENBASE__
+	    /* the same nodes hold different shards in groups of other maps */
+	    && (innerd->distributionType != LOCATOR_TYPE_SHARD ||
+	        ShardGroupsColocated(path_shard_groups(root, pathnode->innerjoinpath,
+	                             path_shard_groups(root, pathnode->outerjoinpath, NIL))))
+#endif
+	    )
 	{
 		ListCell   *lc;
 
@@ -2435,6 +2487,7 @@ not_allowed_join:
 			double inner_size = inner_rel->rows * inner_rel->reltarget->width;
 			int outer_nodes = bms_num_members(outerd->nodes);
 			int inner_nodes = bms_num_members(innerd->nodes);
+			bool adaptive = false;
 #endif
 
             /* If we redistribute both parts do join on all nodes ... */
@@ -2470,11 +2523,23 @@ not_allowed_join:
 				 */
 				Assert(!keepResultRelLoc);
 
+				/*
+				 * A hash join may leave the choice to the executor: both
+				 * sides are redistributed, and the inner one is broadcast
+				 * instead if it turns out small enough, the outer one then
+				 * stays where it is. See ExecRemoteSubplan.
+				 */
+				adaptive = enable_adaptive_distribution &&
+					IsA(pathnode, HashPath) &&
+					pathnode->jointype != JOIN_RIGHT &&
+					pathnode->jointype != JOIN_FULL &&
+					!dml && !pathnode->inner_unique;
+
 				/*
 				 * if any side is smaller enough, replicate the smaller one
 				 * instead of redistribute both of them.
                  */
-                if(inner_size * outer_nodes < inner_size + outer_size &&
+                if(!adaptive && inner_size * outer_nodes < inner_size + outer_size &&
                     (pathnode->jointype != JOIN_RIGHT && pathnode->jointype != JOIN_FULL) &&
                     outerd->distributionType != LOCATOR_TYPE_REPLICATED && !redistribute_inner &&
                     get_num_connections(outer_nodes, nRemotePlans_inner + 1) < MaxConnections * REPLICATION_FACTOR &&
@@ -2485,7 +2550,7 @@ not_allowed_join:
                     nodes = bms_copy(outerd->nodes);
                 }
 
-				if(outer_size * inner_nodes < inner_size + outer_size &&
+				if(!adaptive && outer_size * inner_nodes < inner_size + outer_size &&
 					(pathnode->jointype != JOIN_LEFT &&
 					 pathnode->jointype != JOIN_FULL &&
 					 pathnode->jointype != JOIN_SEMI &&
@@ -2669,6 +2734,17 @@ not_allowed_join:
                 }
 #endif
             }
+#ifdef __OPENTENBASE__
+			if (adaptive &&
+				IsA(pathnode->innerjoinpath, RemoteSubPath) &&
+				IsA(pathnode->outerjoinpath, RemoteSubPath))
+			{
+				((RemoteSubPath *) pathnode->innerjoinpath)->adaptive = REMOTE_ADAPTIVE_BUILD;
+				((RemoteSubPath *) pathnode->outerjoinpath)->adaptive = REMOTE_ADAPTIVE_PROBE;
+			}
+			else
+				adaptive = false;
+#endif
             targetd = makeNode(Distribution);
             targetd->distributionType = distType;
             targetd->nodes = nodes;
@@ -2708,6 +2784,15 @@ not_allowed_join:
 #endif
                 targetd->distributionExpr =
                         pathnode->outerjoinpath->distribution->distributionExpr;
+#ifdef __OPENTENBASE__
+            /*
+             * If the executor keeps the outer side where it is, the result
+             * is not distributed by the join key, so its distribution is
+             * unknown.
+             */
+            if (adaptive)
+                targetd->distributionExpr = NULL;
+#endif
 
 			return alternate;
 		}
@@ -6231,6 +6316,7 @@ create_agg_path(PlannerInfo *root,
 #ifdef __OPENTENBASE__
 	pathnode->hybrid = false;
 	pathnode->entrySize = 0;
+	pathnode->adaptive = false;
 #endif
 
     cost_agg(&pathnode->path, root,
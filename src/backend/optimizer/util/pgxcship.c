@@ -47,6 +47,7 @@
 #include "catalog/pg_constraint.h"
 #include "access/htup_details.h"
 #include "optimizer/pathnode.h"
+#include "pgxc/shardmap.h"
 #endif
 /*
  * Shippability_context
@@ -1787,7 +1788,7 @@ pgxc_is_shard_in_same_group(Var *var1, Var *var2, List *rtable)
     if (rel_loc_info1->locatorType == LOCATOR_TYPE_SHARD &&
         rel_loc_info2->locatorType == LOCATOR_TYPE_SHARD)
     {
-        if (rel_loc_info1->groupId != rel_loc_info2->groupId ||
+        if (!ShardMapsIdentical(rel_loc_info1->groupId, rel_loc_info2->groupId) ||
             AttributeNumberIsValid(rel_loc_info1->secAttrNum) ||
             AttributeNumberIsValid(rel_loc_info2->secAttrNum))
         {
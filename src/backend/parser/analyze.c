@@ -144,6 +144,7 @@
 #include "pgstat.h"
 #include "optimizer/clauses.h"
 #include "utils/memutils.h"
+#include "pgxc/insertbatch.h"
 #endif
 
 
@@ -820,7 +821,12 @@ transformInsertStmt(ParseState *pstate, InsertStmt *stmt)
                                       icolumns, attrnos,
                                       false);
     }
+#ifdef __OPENTENBASE__
+    else if (list_length(selectStmt->valuesLists) > 1 ||
+             InsertBatchCandidate(stmt, selectStmt))
+#else
     else if (list_length(selectStmt->valuesLists) > 1)
+#endif
     {
         /*
          * Process INSERT ... VALUES with multiple VALUES sublists. We
@@ -860,7 +866,8 @@ transformInsertStmt(ParseState *pstate, InsertStmt *stmt)
          * distributed relation(by hash/shard/replication) without
          * on conflict/returning/with clause/triggers.
          */
-        if (g_transform_insert_to_copy && IS_PGXC_COORDINATOR &&
+        if ((g_transform_insert_to_copy ||
+             list_length(selectStmt->valuesLists) == 1) && IS_PGXC_COORDINATOR &&
             !stmt->onConflictClause && !stmt->returningList &&
             !stmt->withClause && !explain_stmt)
         {
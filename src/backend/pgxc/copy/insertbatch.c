@@ -0,0 +1,269 @@
+/*-------------------------------------------------------------------------
+ *
+ * insertbatch.c
+ *	  Single-row INSERTs buffered on the coordinator
+ *
+ * An application inserting row by row in a transaction pays a round trip
+ * to the target datanode for every row. With insert_batch_rows set, the
+ * coordinator keeps the rows of single-row INSERT ... VALUES of constants
+ * in a transaction block instead, and answers them at once. The rows are
+ * sent as one COPY, routed to their datanodes like the rows of a
+ * multi-values INSERT transformed into COPY, when
+ *
+ *	- insert_batch_rows rows are kept,
+ *	- an INSERT into another table or other columns comes,
+ *	- any other statement comes, as it may need to see the rows; this
+ *	  includes COMMIT and PREPARE TRANSACTION.
+ *
+ * So errors of the rows, like constraint violations, are reported by the
+ * statement that sends them rather than by the INSERT of the row. A
+ * ROLLBACK drops the rows, as does the abort of the (sub)transaction that
+ * kept them.
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/pgxc/copy/insertbatch.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/xact.h"
+#include "commands/copy.h"
+#include "nodes/makefuncs.h"
+#include "parser/parse_node.h"
+#include "parser/parsetree.h"
+#include "pgxc/insertbatch.h"
+#include "pgxc/pgxc.h"
+#include "tcop/tcopprot.h"
+#include "utils/memutils.h"
+#include "utils/snapmgr.h"
+
+/* GUC parameters */
+int			insert_batch_rows = 0;
+
+/* set while a simple query analyzes its statements */
+bool		insert_batch_analyzing = false;
+
+typedef struct InsertBatchData
+{
+	MemoryContext cxt;			/* the rows and what they go to */
+	Oid			relid;			/* target table */
+	RangeVar   *relation;
+	List	   *cols;			/* target columns as in the INSERTs */
+	int			ncolumns;
+	int			maxrows;		/* room in data_list */
+	int			nrows;
+	char	 ***data_list;		/* values of the rows, as in CopyStmt */
+} InsertBatchData;
+
+/* rows kept in the current transaction, NULL if none yet */
+static InsertBatchData *insert_batch = NULL;
+static bool insert_batch_callbacks = false;
+
+static void insert_batch_xact_callback(XactEvent event, void *arg);
+static void insert_batch_subxact_callback(SubXactEvent event,
+							  SubTransactionId mySubid,
+							  SubTransactionId parentSubid, void *arg);
+
+
+/*
+ * May the INSERT be kept? Called by parse analysis before the values are
+ * transformed: only a single row of constants is.
+ */
+bool
+InsertBatchCandidate(InsertStmt *stmt, SelectStmt *selectStmt)
+{
+	ListCell   *lc;
+
+	/* only the statements of a simple query, and not under EXPLAIN */
+	if (insert_batch_rows <= 0 || !IS_PGXC_COORDINATOR ||
+		!insert_batch_analyzing || explain_stmt ||
+		!IsTransactionBlock() || IsExtendedQuery())
+		return false;
+
+	if (stmt->onConflictClause || stmt->returningList || stmt->withClause ||
+		list_length(selectStmt->valuesLists) != 1)
+		return false;
+
+	foreach(lc, (List *) linitial(selectStmt->valuesLists))
+	{
+		Node	   *value = (Node *) lfirst(lc);
+
+		if (IsA(value, TypeCast))
+			value = ((TypeCast *) value)->arg;
+		if (!IsA(value, A_Const))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Keep the row of the INSERT, transformed into the data_list of a COPY by
+ * parse analysis. Returns false if it cannot be kept, and the INSERT must
+ * be executed; the rows kept before are sent first then.
+ */
+bool
+InsertBatchAdd(InsertStmt *stmt, Query *query)
+{
+	InsertBatchData *batch;
+	RangeTblEntry *rte;
+	MemoryContext oldcontext;
+	char	  **row;
+	int			i;
+
+	if (insert_batch_rows <= 0 || !IsTransactionBlock() ||
+		stmt->ndatarows != 1 || stmt->data_list == NULL)
+	{
+		InsertBatchFlush();
+		return false;
+	}
+
+	rte = rt_fetch(query->resultRelation, query->rtable);
+
+	/* the rows go to the same columns of the same table */
+	batch = insert_batch;
+	if (batch && batch->nrows > 0 &&
+		(batch->relid != rte->relid || !equal(batch->cols, stmt->cols)))
+		InsertBatchFlush();
+
+	if (batch == NULL)
+	{
+		if (!insert_batch_callbacks)
+		{
+			RegisterXactCallback(insert_batch_xact_callback, NULL);
+			RegisterSubXactCallback(insert_batch_subxact_callback, NULL);
+			insert_batch_callbacks = true;
+		}
+
+		batch = (InsertBatchData *)
+			MemoryContextAllocZero(TopTransactionContext, sizeof(InsertBatchData));
+		batch->cxt = AllocSetContextCreate(TopTransactionContext,
+										   "InsertBatch",
+										   ALLOCSET_DEFAULT_SIZES);
+		insert_batch = batch;
+	}
+
+	oldcontext = MemoryContextSwitchTo(batch->cxt);
+
+	if (batch->nrows == 0)
+	{
+		batch->relid = rte->relid;
+		batch->relation = copyObject(stmt->relation);
+		batch->cols = copyObject(stmt->cols);
+		batch->ncolumns = stmt->ninsert_columns;
+		batch->maxrows = insert_batch_rows;
+		batch->data_list = (char ***) palloc(sizeof(char **) * batch->maxrows);
+	}
+
+	row = (char **) palloc(sizeof(char *) * batch->ncolumns);
+	for (i = 0; i < batch->ncolumns; i++)
+		row[i] = stmt->data_list[0][i] ? pstrdup(stmt->data_list[0][i]) : NULL;
+	batch->data_list[batch->nrows++] = row;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (batch->nrows >= batch->maxrows || batch->nrows >= insert_batch_rows)
+		InsertBatchFlush();
+
+	return true;
+}
+
+/*
+ * Send the rows kept, as one COPY.
+ */
+void
+InsertBatchFlush(void)
+{
+	InsertBatchData *batch = insert_batch;
+	CopyStmt   *copy;
+	ParseState *pstate;
+	ListCell   *lc;
+	uint64		processed;
+
+	if (batch == NULL || batch->nrows == 0)
+		return;
+
+	copy = makeNode(CopyStmt);
+	copy->relation = batch->relation;
+	copy->is_from = true;
+	copy->filename = "Insert_into to Copy_from(Batched)";
+	copy->data_list = batch->data_list;
+	copy->ncolumns = batch->ncolumns;
+	copy->ndatarows = batch->nrows;
+	foreach(lc, batch->cols)
+	{
+		ResTarget  *target = (ResTarget *) lfirst(lc);
+
+		copy->attlist = lappend(copy->attlist, makeString(target->name));
+	}
+	copy->insert_into = true;
+
+	/* whatever happens, the rows are not sent twice */
+	batch->nrows = 0;
+
+	pstate = make_parsestate(NULL);
+	pstate->p_sourcetext = "";
+
+	PushActiveSnapshot(GetTransactionSnapshot());
+	DoCopy(pstate, copy, -1, 0, &processed);
+	PopActiveSnapshot();
+
+	free_parsestate(pstate);
+	MemoryContextReset(batch->cxt);
+
+	/* the statement to come sees the rows */
+	CommandCounterIncrement();
+}
+
+/*
+ * Drop the rows kept.
+ */
+void
+InsertBatchDiscard(void)
+{
+	if (insert_batch)
+	{
+		insert_batch->nrows = 0;
+		MemoryContextReset(insert_batch->cxt);
+	}
+}
+
+static void
+insert_batch_xact_callback(XactEvent event, void *arg)
+{
+	switch (event)
+	{
+		case XACT_EVENT_PRE_COMMIT:
+		case XACT_EVENT_PRE_PREPARE:
+			/* the statement ending the transaction block sends them */
+			if (insert_batch && insert_batch->nrows > 0)
+				elog(ERROR, "%d buffered INSERT rows were not sent",
+					 insert_batch->nrows);
+			break;
+
+		case XACT_EVENT_COMMIT:
+		case XACT_EVENT_ABORT:
+		case XACT_EVENT_PREPARE:
+			/* gone with TopTransactionContext */
+			insert_batch = NULL;
+			insert_batch_analyzing = false;
+			break;
+
+		default:
+			break;
+	}
+}
+
+static void
+insert_batch_subxact_callback(SubXactEvent event, SubTransactionId mySubid,
+							  SubTransactionId parentSubid, void *arg)
+{
+	/*
+	 * SAVEPOINT sends the rows kept before, so all of the rows belong to the
+	 * subtransaction aborted.
+	 */
+	if (event == SUBXACT_EVENT_ABORT_SUB)
+		InsertBatchDiscard();
+}
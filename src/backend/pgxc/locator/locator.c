@@ -2318,6 +2318,55 @@ GET_NODES(Locator *self, Datum value, bool isnull,
 }
 
 #ifdef __OPENTENBASE__
+/*
+ * Can GET_NODES_BATCH route the rows of the locator? Only the plain shard
+ * insert locator can, cold-hot tables are routed row by row.
+ */
+bool
+IsLocatorBatchable(Locator *self)
+{
+    return self->locatefunc == locate_shard_insert &&
+           !self->need_shardmap_router &&
+           self->listType == LOCATOR_LIST_POINTER;
+}
+
+/*
+ * GET_NODES for a batch of nvalues rows at once: the node of values[i] is
+ * written to results[i]. The values are hashed type by type and the shard
+ * map is looked up once for the batch. The locator must be batchable.
+ */
+void
+GET_NODES_BATCH(Locator *self, Datum *values, bool *nulls, int nvalues,
+                void **results)
+{
+    Datum  *hashes;
+    long   *hashvalues;
+    int32  *nodeindexes;
+    int     i;
+
+    Assert(IsLocatorBatchable(self));
+
+    hashes = (Datum *) palloc(sizeof(Datum) * nvalues);
+    hashvalues = (long *) palloc(sizeof(long) * nvalues);
+    nodeindexes = (int32 *) palloc(sizeof(int32) * nvalues);
+
+    compute_hash_batch(self->dataType, values, nulls, nvalues,
+                       LOCATOR_TYPE_SHARD, hashes);
+    for (i = 0; i < nvalues; i++)
+        hashvalues[i] = (long) hashes[i];
+
+    GetNodeIndexesByHashValues(self->groupid, hashvalues, nvalues, nodeindexes);
+
+    for (i = 0; i < nvalues; i++)
+    {
+        Assert(nodeindexes[i] >= 0);
+        results[i] = ((void **) self->nodeMap)[self->nodeindexMap[nodeindexes[i]]];
+    }
+
+    pfree(hashes);
+    pfree(hashvalues);
+    pfree(nodeindexes);
+}
 
 char
 getLocatorDisType(Locator *self)
@@ -1505,4 +1505,47 @@ pgxc_set_sec_en_expr(Oid tableoid, Index resultRelationIndex)
     return (Expr *) var;
 }
 #endif
+
+/*
+ * pgxc_fqs_key_param
+ * If the plan ships the whole query to the node the value of a parameter
+ * maps to, return the number of that parameter, 0 otherwise. The generic
+ * plan of such a query is as good as any custom plan, the node is found
+ * at execution by get_exec_connections().
+ */
+int
+pgxc_fqs_key_param(PlannedStmt *stmt)
+{
+    RemoteQuery *rq;
+    Expr        *expr;
+
+    if (stmt->commandType == CMD_UTILITY || stmt->planTree == NULL ||
+        !IsA(stmt->planTree, RemoteQuery) || stmt->subplans != NIL)
+        return 0;
+
+    rq = (RemoteQuery *) stmt->planTree;
+    if (rq->exec_type != EXEC_ON_DATANODES || rq->exec_nodes == NULL ||
+        rq->exec_nodes->en_expr == NULL)
+        return 0;
+
+#ifdef __COLD_HOT__
+    /* the second key must be routed by a parameter too */
+    if (rq->exec_nodes->sec_en_expr)
+    {
+        expr = rq->exec_nodes->sec_en_expr;
+        while (IsA(expr, RelabelType))
+            expr = ((RelabelType *) expr)->arg;
+        if (!IsA(expr, Param) || ((Param *) expr)->paramkind != PARAM_EXTERN)
+            return 0;
+    }
+#endif
+
+    expr = rq->exec_nodes->en_expr;
+    while (IsA(expr, RelabelType))
+        expr = ((RelabelType *) expr)->arg;
+    if (!IsA(expr, Param) || ((Param *) expr)->paramkind != PARAM_EXTERN)
+        return 0;
+
+    return ((Param *) expr)->paramid;
+}
 #endif
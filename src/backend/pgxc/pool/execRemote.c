@@ -22,6 +22,7 @@
 #include "postgres.h"
 #include "access/twophase.h"
 #include "access/gtm.h"
+#include "access/hash.h"
 #include "access/sysattr.h"
 #include "access/transam.h"
 #include "access/xact.h"
@@ -66,6 +67,7 @@
 #include "executor/nodeModifyTable.h"
 #include "nodes/print.h"
 #include "optimizer/pathnode.h"
+#include "pgxc/netcost.h"
 #include "pgxc/squeue.h"
 #include "postmaster/postmaster.h"
 #include "utils/syscache.h"
@@ -95,6 +97,11 @@ List *executed_node_list = NULL;
 #ifdef __OPENTENBASE__
 /* GUC parameter */
 int DataRowBufferSize = 0;  /* MBytes */
+bool enable_subplan_cache = false;
+int RemoteDMLBatchSize = 1;
+int RemoteReceiveThreads = 0;
+int CopySendThreads = 0;
+int CopySendQueueSize = 4096;    /* kB */
 
 #define DATA_ROW_BUFFER_SIZE(n) (DataRowBufferSize * 1024 * 1024 * (n))
 #endif
@@ -135,7 +142,8 @@ static PGXCNodeAllHandles *get_exec_connections(RemoteQueryState *planstate,
 
 
 static bool pgxc_start_command_on_connection(PGXCNodeHandle *connection,
-                    RemoteQueryState *remotestate, Snapshot snapshot);
+                    RemoteQueryState *remotestate, Snapshot snapshot,
+                    PGXCNodeSendTemplate *tmpl);
 
 static void pgxc_node_remote_count(int *dnCount, int dnNodeIds[],
         int *coordCount, int coordNodeIds[]);
@@ -156,6 +164,8 @@ static int pgxc_node_remote_commit_internal(PGXCNodeAllHandles *handles, Transca
 #endif
 
 static void pgxc_connections_cleanup(ResponseCombiner *combiner);
+static void pgxc_dml_batch_drain(RemoteQueryState *node, PGXCNodeHandle *conn);
+static void report_fragment_transfer(PGXCNodeHandle *conn);
 
 static bool determine_param_types(Plan *plan,  struct find_params_context *context);
 
@@ -759,9 +769,16 @@ HandleDataRow(ResponseCombiner *combiner, char *msg_body, size_t len, Oid node)
 
     /*
      * We are copying message because it points into connection buffer, and
-     * will be overwritten on next socket read
+     * will be overwritten on next socket read.  Allocate it where the result
+     * slot keeps its tuples, so CopyDataRowTupleToSlot can hand the row over
+     * without copying it a second time.
      */
-    combiner->currentRow = (RemoteDataRow) palloc(sizeof(RemoteDataRowData) + len);
+    if (combiner->ss.ps.ps_ResultTupleSlot)
+        combiner->currentRow = (RemoteDataRow)
+            MemoryContextAlloc(combiner->ss.ps.ps_ResultTupleSlot->tts_mcxt,
+                               sizeof(RemoteDataRowData) + len);
+    else
+        combiner->currentRow = (RemoteDataRow) palloc(sizeof(RemoteDataRowData) + len);
     memcpy(combiner->currentRow->msg, msg_body, len);
     combiner->currentRow->msglen = len;
     combiner->currentRow->msgnode = node;
@@ -1176,6 +1193,13 @@ BufferConnection(PGXCNodeHandle *conn, bool need_prefetch)
         return;
     }
 
+    /* rows pipelined by ExecRemoteDML, they only need their answers read */
+    if (conn->dml_pipelined > 0)
+    {
+        pgxc_dml_batch_drain((RemoteQueryState *) combiner, conn);
+        return;
+    }
+
     elog(DEBUG2, "Buffer connection %u to step %s", conn->nodeoid, combiner->cursor);
 
     /*
@@ -1968,13 +1992,22 @@ bool PreFetchConnection(PGXCNodeHandle *conn, int32 node_index)
 
 /*
  * copy the datarow from combiner to the given slot, in the slot's memory
- * context
+ * context.  Rows already allocated in that context (the common case, see
+ * HandleDataRow) are handed over to the slot as is.
  */
 static void
 CopyDataRowTupleToSlot(ResponseCombiner *combiner, TupleTableSlot *slot)
 {
     RemoteDataRow     datarow;
     MemoryContext    oldcontext;
+
+    if (GetMemoryChunkContext(combiner->currentRow) == slot->tts_mcxt)
+    {
+        ExecStoreDataRowTuple(combiner->currentRow, slot, true);
+        combiner->currentRow = NULL;
+        return;
+    }
+
     oldcontext = MemoryContextSwitchTo(slot->tts_mcxt);
     datarow = (RemoteDataRow) palloc(sizeof(RemoteDataRowData) + combiner->currentRow->msglen);
     datarow->msgnode = combiner->currentRow->msgnode;
@@ -2074,6 +2107,24 @@ FetchTuple(ResponseCombiner *combiner)
     {
         begin = GetCurrentTimestamp();
     }
+
+    /*
+     * Let reader threads drain the other data nodes while the rows of one
+     * are processed.
+     */
+    if (RemoteReceiveThreads > 0 && combiner->conn_count > 1)
+    {
+        int i;
+
+        for (i = 0; i < combiner->conn_count; i++)
+        {
+            PGXCNodeHandle *handle = combiner->connections[i];
+
+            if (handle && handle->recv_pump == NULL &&
+                handle->state == DN_CONNECTION_STATE_QUERY)
+                pgxc_node_start_receive_pump(handle);
+        }
+    }
 #endif
     /*
      * Get current connection
@@ -3158,6 +3209,21 @@ pgxc_node_receive_responses(const int conn_count, PGXCNodeHandle ** connections,
     return func_ret;
 }
 
+/*
+ * Report the data rows received from the connection since the first one to
+ * the network cost calibration, and start counting anew.
+ */
+static void
+report_fragment_transfer(PGXCNodeHandle *conn)
+{
+    if (conn->fragment_measured && conn->fragment_rows_start != 0)
+        NetworkCostReportTransfer(conn->nodeoid, conn->fragment_bytes,
+                                  conn->fragment_rows_start,
+                                  GetCurrentTimestamp());
+    conn->fragment_rows_start = 0;
+    conn->fragment_bytes = 0;
+}
+
 /*
  * Read next message from the connection and update the combiner
  * and connection state accordingly
@@ -3239,6 +3305,7 @@ handle_response(PGXCNodeHandle *conn, ResponseCombiner *combiner)
 				"fatal_conn->sock_fatal_occurred=%d, conn->backend_pid=%d, fatal_conn->error=%s", 
 				conn, conn->nodename, conn->sock, conn->read_only, conn->transaction_status,
 				conn->sock_fatal_occurred, conn->backend_pid,  conn->error);
+            pgxc_node_stop_receive_pump(conn);
 #endif
             closesocket(conn->sock);
             conn->sock = NO_SOCKET;
@@ -3267,6 +3334,10 @@ handle_response(PGXCNodeHandle *conn, ResponseCombiner *combiner)
             case 'C':            /* CommandComplete */
                 HandleCommandComplete(combiner, msg, msg_len, conn);
                 conn->combiner = NULL;
+#ifdef __OPENTENBASE__
+                report_fragment_transfer(conn);
+                conn->fragment_measured = false;
+#endif
                 /* 
                  * In case of simple query protocol, wait for the ReadyForQuery
                  * before marking connection as Idle
@@ -3304,6 +3375,17 @@ handle_response(PGXCNodeHandle *conn, ResponseCombiner *combiner)
                     conn->recv_datarows++;
                     combiner->recv_datarows++;
                 }
+                if (conn->fragment_measured)
+                {
+                    if (conn->fragment_rows_start == 0)
+                        conn->fragment_rows_start = GetCurrentTimestamp();
+                    /* with the message type and length */
+                    conn->fragment_bytes += msg_len + 5;
+                }
+                if (IsA(combiner, RemoteSubplanState) &&
+                    ((RemoteSubplanState *) combiner)->measure_exchange)
+                    ((RemoteSubplanState *) combiner)->exchange.recv_bytes +=
+                        msg_len + 5;
 #endif
                 /* Do not return if data row has not been actually handled */
                 if (HandleDataRow(combiner, msg, msg_len, conn->nodeoid))
@@ -3316,10 +3398,23 @@ handle_response(PGXCNodeHandle *conn, ResponseCombiner *combiner)
             case 's':            /* PortalSuspended */
                 /* No activity is expected on the connection until next query */
                 PGXCNodeSetConnectionState(conn, DN_CONNECTION_STATE_IDLE);
+#ifdef __OPENTENBASE__
+                /* the time until the next Execute is not transfer time */
+                report_fragment_transfer(conn);
+#endif
                 return RESPONSE_SUSPENDED;
                 
-            case '1': /* ParseComplete */
             case '2': /* BindComplete */
+#ifdef __OPENTENBASE__
+                if (conn->fragment_sent != 0)
+                {
+                    NetworkCostReportStartup(conn->nodeoid, conn->fragment_sent,
+                                             GetCurrentTimestamp());
+                    conn->fragment_sent = 0;
+                }
+#endif
+                break;
+            case '1': /* ParseComplete */
             case '3': /* CloseComplete */
             case 'n': /* NoData */
                 /* simple notifications, continue reading */
@@ -3367,6 +3462,10 @@ handle_response(PGXCNodeHandle *conn, ResponseCombiner *combiner)
                 {
                     conn->needSync = true;
                 }
+                /* PLAN messages may have been skipped along, resend them */
+                pgxc_node_forget_subplans(conn);
+                conn->fragment_sent = 0;
+                conn->fragment_measured = false;
 #ifdef     _PG_REGRESS_
                 elog(LOG, "HandleError from node %s, remote pid %d, errorMessage:%s", 
                         conn->nodename, conn->backend_pid, combiner->errorMessage);
@@ -3393,6 +3492,10 @@ handle_response(PGXCNodeHandle *conn, ResponseCombiner *combiner)
                 conn->transaction_status = msg[0];
                 PGXCNodeSetConnectionState(conn, DN_CONNECTION_STATE_IDLE);
                 conn->combiner = NULL;
+                /* everything sent before the Sync is answered */
+                conn->dml_pipelined = 0;
+                /* nothing more to drain until the next command */
+                pgxc_node_stop_receive_pump(conn);
 
 				elog(DEBUG5, "remote_node %s remote_pid %d, conn->transaction_status %c", conn->nodename, conn->backend_pid, conn->transaction_status);
 #ifdef DN_CONNECTION_DEBUG
@@ -3500,6 +3603,9 @@ is_data_node_ready(PGXCNodeHandle * conn)
         if (data_len >= (MaxAllocSize>>1))
         {
             elog(LOG, "size:%lu too big in buffer, close socket on node:%u now", data_len, conn->nodeoid);
+#ifdef __OPENTENBASE__
+            pgxc_node_stop_receive_pump(conn);
+#endif
             close(conn->sock);
             conn->sock = NO_SOCKET;
             return true;
@@ -6146,6 +6252,21 @@ DataNodeCopyIn(char *data_row, int len,
                 if (DN_CONNECTION_STATE_ERROR(handle))
                     return EOF;
 
+#ifdef __OPENTENBASE__
+                /*
+                 * With writer threads, the rows are queued for the node and
+                 * the backend goes on with the next ones. It waits only once
+                 * the node lags copy_send_queue_size behind.
+                 */
+                if (handle->send_pump == NULL && CopySendThreads > 0)
+                    pgxc_node_start_send_pump(handle);
+                if (handle->send_pump)
+                {
+                    if (pgxc_node_send_pump_push(handle) < 0)
+                        return EOF;
+                }
+                else
+#endif
                 /*
                  * Try to send down buffered data if we have
                  */
@@ -6335,6 +6456,38 @@ get_exec_connections_all_dn(bool is_global_session)
 
 #endif
 
+/*
+ * Get the value of an external parameter the target nodes are determined
+ * by, without initializing and evaluating it as an expression. Return
+ * false if expr is not such a parameter or the value is not available.
+ */
+static bool
+get_key_param_value(Expr *expr, ParamListInfo params, Datum *value, bool *isnull)
+{
+    Param            *param;
+    ParamExternData  *prm;
+
+    while (IsA(expr, RelabelType))
+        expr = ((RelabelType *) expr)->arg;
+
+    if (!IsA(expr, Param) || ((Param *) expr)->paramkind != PARAM_EXTERN)
+        return false;
+
+    param = (Param *) expr;
+    if (params == NULL || param->paramid <= 0 || param->paramid > params->numParams)
+        return false;
+
+    prm = &params->params[param->paramid - 1];
+    if (!OidIsValid(prm->ptype) && params->paramFetch != NULL)
+        (*params->paramFetch) (params, param->paramid);
+    if (prm->ptype != param->paramtype)
+        return false;
+
+    *value = prm->value;
+    *isnull = prm->isnull;
+    return true;
+}
+
 /*
  * Get Node connections depending on the connection type:
  * Datanodes Only, Coordinators only or both types
@@ -6411,6 +6564,13 @@ get_exec_connections(RemoteQueryState *planstate,
 				partvalue = exec_nodes->rewrite_value;
 				isnull = exec_nodes->isnull;
 			}
+			else if (planstate->eflags != EXEC_FLAG_EXPLAIN_ONLY &&
+					 get_key_param_value(exec_nodes->en_expr,
+										 planstate->combiner.ss.ps.state->es_param_list_info,
+										 &partvalue, &isnull))
+			{
+				/* point query routed by a parameter, nothing to evaluate */
+			}
 			else
 			{
 				estate = ExecInitExpr(exec_nodes->en_expr,
@@ -6701,10 +6861,16 @@ get_exec_connections(RemoteQueryState *planstate,
 }
 
 
+/*
+ * Send the command of remotestate to connection. If tmpl is not NULL the
+ * Extended Query protocol messages are encoded once and shared with the other
+ * connections the command is sent to with the same tmpl.
+ */
 static bool
 pgxc_start_command_on_connection(PGXCNodeHandle *connection,
                                     RemoteQueryState *remotestate,
-                                    Snapshot snapshot)
+                                    Snapshot snapshot,
+                                    PGXCNodeSendTemplate *tmpl)
 {// #lizard forgives
     CommandId    cid;
     ResponseCombiner *combiner = (ResponseCombiner *) remotestate;
@@ -6783,7 +6949,21 @@ pgxc_start_command_on_connection(PGXCNodeHandle *connection,
 #endif
         combiner->extended_query = true;
 
-        if (pgxc_node_send_query_extended(connection,
+        if (tmpl)
+        {
+            if (pgxc_node_send_query_extended_template(connection, tmpl,
+                                prepared ? NULL : step->sql_statement,
+                                step->statement,
+                                step->cursor,
+                                remotestate->rqs_num_params,
+                                remotestate->rqs_param_types,
+                                remotestate->paramval_len,
+                                remotestate->paramval_data,
+                                step->has_row_marks ? true : step->read_only,
+                                fetch) != 0)
+                return false;
+        }
+        else if (pgxc_node_send_query_extended(connection,
                             prepared ? NULL : step->sql_statement,
                             step->statement,
                             step->cursor,
@@ -7512,6 +7692,9 @@ SetDataRowForExtParams(ParamListInfo paraminfo, RemoteQueryState *rq_state)
 void
 AtEOXact_Remote(void)
 {
+#ifdef __OPENTENBASE__
+    pgxc_node_batch_send_reset();
+#endif
     PGXCNodeResetParams(true);
     reset_transaction_handles();
 }
@@ -7647,6 +7830,11 @@ PreAbort_Remote(TranscationType txn_type, bool need_release_handle)
     struct rusage        start_r;
     struct timeval        start_t;
 
+#ifdef __OPENTENBASE__
+    /* the cleanup below must really send what it writes */
+    pgxc_node_batch_send_reset();
+#endif
+
 	if (!is_pgxc_handles_init())
 	{
 		return true;
@@ -9150,7 +9338,7 @@ ExecRemoteQuery(PlanState *pstate)
 			/* If explicit transaction is needed gxid is already sent */
 			if (!pgxc_start_command_on_connection(primaryconnection,
 												  node,
-												  snapshot))
+												  snapshot, NULL))
 			{
 				pgxc_node_remote_abort(TXN_TYPE_RollbackTxn, true);
 				pfree_pgxc_all_handles(pgxc_connections);
@@ -9217,9 +9405,33 @@ ExecRemoteQuery(PlanState *pstate)
 						(errcode(ERRCODE_INTERNAL_ERROR),
 						 errmsg("Could not begin transaction on data node:%s.",
 								 connections[i]->nodename)));
+		}
 
-			/* If explicit transaction is needed gxid is already sent */
-			if (!pgxc_start_command_on_connection(connections[i], node, snapshot))
+		/*
+		 * Encode the command once for all the data nodes and write it out to
+		 * all of them together, instead of one node after the other.
+		 */
+		{
+			PGXCNodeSendTemplate tmpl;
+			bool                 sent = true;
+
+			memset(&tmpl, 0, sizeof(tmpl));
+			pgxc_node_batch_send_begin();
+			for (i = 0; i < regular_conn_count; i++)
+			{
+				/* If explicit transaction is needed gxid is already sent */
+				if (!pgxc_start_command_on_connection(connections[i], node, snapshot, &tmpl))
+				{
+					sent = false;
+					break;
+				}
+				connections[i]->combiner = combiner;
+			}
+			if (pgxc_node_batch_send_end() != 0)
+				sent = false;
+			pgxc_node_free_send_template(&tmpl);
+
+			if (!sent)
 			{
 				pgxc_node_remote_abort(TXN_TYPE_RollbackTxn, true);
 				pfree_pgxc_all_handles(pgxc_connections);
@@ -9227,7 +9439,6 @@ ExecRemoteQuery(PlanState *pstate)
 						(errcode(ERRCODE_INTERNAL_ERROR),
 						 errmsg("Failed to send command to data nodes")));
 			}
-			connections[i]->combiner = combiner;
 		}
 
 		if (step->cursor)
@@ -10077,6 +10288,8 @@ ExecInitRemoteSubplan(RemoteSubplan *node, EState *estate, int eflags)
 		                                        &ctl, HASH_ELEM | HASH_BLOBS);
 	}
 	combiner->remote_parallel_estimated = false;
+	remotestate->measure_exchange =
+		(estate->es_instrument & INSTRUMENT_EXCHANGE) != 0;
 #endif
     combiner->ss.ps.qual = NULL;
 
@@ -10453,6 +10666,15 @@ ExecInitRemoteSubplan(RemoteSubplan *node, EState *estate, int eflags)
             }
 #endif
             remotestate->subplanstr = nodeToString(&rstmt);
+            if (enable_subplan_cache)
+            {
+                remotestate->subplankey = DatumGetUInt64(
+                        hash_any_extended((unsigned char *) remotestate->subplanstr,
+                                          strlen(remotestate->subplanstr), 0));
+                /* zero key means not cached */
+                if (remotestate->subplankey == 0)
+                    remotestate->subplankey = 1;
+            }
 #ifdef __AUDIT__
             rstmt.queryString = NULL;
             rstmt.parseTree = NULL;
@@ -10683,7 +10905,8 @@ ExecFinishInitRemoteSubplan(RemoteSubplanState *node)
                      errmsg("Failed to send command ID to data nodes")));
         }
         pgxc_node_send_plan(connection, cursor, "Remote Subplan",
-							node->subplanstr, node->nParamRemote, paramtypes, estate->es_instrument);
+							node->subplanstr, node->nParamRemote, paramtypes, estate->es_instrument,
+							node->subplankey);
 
 		if (enable_statistic)
 		{
@@ -10879,6 +11102,177 @@ encode_epqcontext(PlanState *planstate, char **result)
 	return buf.len;
 }
 
+#ifdef __OPENTENBASE__
+/*
+ * Let the outer and inner RemoteSubplan of a hash join choose their
+ * exchange together, if both are planned adaptive.
+ */
+void
+ExecLinkAdaptiveRemoteSubplans(PlanState *probe, PlanState *build)
+{
+	RemoteSubplanState *probestate;
+	RemoteSubplanState *buildstate;
+
+	if (probe == NULL || build == NULL ||
+		!IsA(probe, RemoteSubplanState) || !IsA(build, RemoteSubplanState))
+		return;
+
+	probestate = (RemoteSubplanState *) probe;
+	buildstate = (RemoteSubplanState *) build;
+	if (((RemoteSubplan *) probe->plan)->adaptive != REMOTE_ADAPTIVE_PROBE ||
+		((RemoteSubplan *) build->plan)->adaptive != REMOTE_ADAPTIVE_BUILD)
+		return;
+
+	probestate->adaptive_peer = buildstate;
+	buildstate->adaptive_peer = probestate;
+}
+
+/*
+ * Exchange to ask of the producers of an adaptive hash join side when
+ * binding them.
+ *
+ * The build side asks to have the first adaptiveRows + 1 rows of every
+ * producer broadcast, and counts the rows of each producer while they
+ * arrive. If no producer sent more than adaptiveRows, every consumer has got
+ * all the rows of the build side, and every one of them sees that. The probe
+ * side then keeps its rows on the node they are produced on. Otherwise it is
+ * redistributed as planned, which is right however the build rows came.
+ *
+ * The producers follow the first consumer that binds them, so the build
+ * side asks the same of them on every node: the conditions here do not
+ * depend on the node or on the data.
+ *
+ * The hash join does not fetch from a linked probe side before it has built
+ * its hash table (see ExecHashJoin), as a probe side bound while the build
+ * side is still being counted is always redistributed.
+ */
+static char
+adaptive_exchange_for_bind(RemoteSubplanState *node)
+{
+	ResponseCombiner *combiner = (ResponseCombiner *) node;
+	RemoteSubplan  *plan = (RemoteSubplan *) combiner->ss.ps.plan;
+	EState		   *estate = combiner->ss.ps.state;
+	PGXCNodeHandle **connections;
+	int				count;
+	int				i;
+
+	if (plan->adaptive == REMOTE_ADAPTIVE_PROBE)
+	{
+		if (node->adaptive_peer &&
+			node->adaptive_peer->adaptive_exchange == ADAPTIVE_EXCHANGE_BROADCAST)
+		{
+			node->adaptive_exchange = ADAPTIVE_EXCHANGE_LOCAL;
+			return SQ_ADAPTIVE_LOCAL;
+		}
+		node->adaptive_exchange = ADAPTIVE_EXCHANGE_DISTRIBUTE;
+		return SQ_ADAPTIVE_NONE;
+	}
+
+	if (plan->adaptive != REMOTE_ADAPTIVE_BUILD)
+		return SQ_ADAPTIVE_NONE;
+
+	node->adaptive_exchange = ADAPTIVE_EXCHANGE_DISTRIBUTE;
+
+	/* the producers share a queue only between data nodes */
+	if (node->adaptive_peer == NULL || !IS_PGXC_DATANODE ||
+		list_length(plan->distributionRestrict) < 2 ||
+		estate->es_epqTuple != NULL)
+		return SQ_ADAPTIVE_NONE;
+
+	/* with these the producers serve every consumer separately */
+	for (i = 0; i < node->nParamRemote; i++)
+	{
+		if (node->remoteparams[i].paramkind == PARAM_EXEC &&
+			node->remoteparams[i].paramused != REMOTE_PARAM_INITPLAN)
+			return SQ_ADAPTIVE_NONE;
+	}
+
+	if (combiner->cursor)
+	{
+		connections = combiner->cursor_connections;
+		count = combiner->cursor_count;
+	}
+	else
+	{
+		connections = combiner->connections;
+		count = combiner->conn_count;
+	}
+
+	if (node->adaptive_nodes == NULL)
+	{
+		MemoryContext oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+
+		node->adaptive_nodes = (Oid *) palloc(count * sizeof(Oid));
+		node->adaptive_counts = (int *) palloc(count * sizeof(int));
+		MemoryContextSwitchTo(oldcontext);
+	}
+	else if (count > node->adaptive_nnodes)
+	{
+		node->adaptive_nodes = (Oid *) repalloc(node->adaptive_nodes,
+												count * sizeof(Oid));
+		node->adaptive_counts = (int *) repalloc(node->adaptive_counts,
+												 count * sizeof(int));
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		node->adaptive_nodes[i] = connections[i]->nodeoid;
+		node->adaptive_counts[i] = 0;
+	}
+	node->adaptive_nnodes = count;
+	node->adaptive_exchange = ADAPTIVE_EXCHANGE_COUNTING;
+
+	return SQ_ADAPTIVE_BROADCAST;
+}
+
+/*
+ * Count a row of the build side against its producer, the side is
+ * distributed once a producer sent more rows than it broadcasts.
+ */
+static void
+adaptive_count_row(RemoteSubplanState *node, TupleTableSlot *slot)
+{
+	RemoteSubplan  *plan = (RemoteSubplan *) node->combiner.ss.ps.plan;
+	int				i;
+
+	if (slot->tts_datarow)
+	{
+		for (i = 0; i < node->adaptive_nnodes; i++)
+		{
+			if (node->adaptive_nodes[i] == slot->tts_datarow->msgnode)
+			{
+				if (++node->adaptive_counts[i] > plan->adaptiveRows)
+					break;
+				return;
+			}
+		}
+	}
+
+	/* a row of an unknown producer cannot tell either */
+	node->adaptive_exchange = ADAPTIVE_EXCHANGE_DISTRIBUTE;
+}
+#endif
+
+#ifdef __OPENTENBASE__
+/*
+ * Add the time since wait_start, if set, to the wait of the consumer of the
+ * exchange, and start anew.
+ */
+static inline void
+exchange_wait_done(RemoteSubplanState *node, instr_time *wait_start)
+{
+    instr_time  now;
+
+    if (INSTR_TIME_IS_ZERO(*wait_start))
+        return;
+
+    INSTR_TIME_SET_CURRENT(now);
+    node->exchange.recv_wait += INSTR_TIME_GET_MILLISEC(now) -
+        INSTR_TIME_GET_MILLISEC(*wait_start);
+    *wait_start = now;
+}
+#endif
+
 TupleTableSlot *
 ExecRemoteSubplan(PlanState *pstate)
 {// #lizard forgives
@@ -10891,6 +11285,7 @@ ExecRemoteSubplan(PlanState *pstate)
     struct timeval        start_t;
 #ifdef __OPENTENBASE__
     int count = 0;
+    instr_time  wait_start;
 #endif
 #ifdef __OPENTENBASE__
 	if ((node->eflags & EXEC_FLAG_EXPLAIN_ONLY) != 0)
@@ -10946,6 +11341,7 @@ primary_mode_phase_two:
         char cursor[NAMEDATALEN];
 #ifdef __OPENTENBASE__
 		StringInfo shardmap = NULL;
+		char		adaptive = SQ_ADAPTIVE_NONE;
 #endif
 
         if (plan->cursor)
@@ -11025,6 +11421,9 @@ primary_mode_phase_two:
 					shardmap = SerializeShardmap();
 			}
 		}
+
+		if (plan->adaptive != REMOTE_ADAPTIVE_NONE && !primary_mode)
+			adaptive = adaptive_exchange_for_bind(node);
 #endif
         /*
          * The subplan being rescanned, need to restore connections and
@@ -11065,7 +11464,8 @@ primary_mode_phase_two:
 
                 /* rebind */
                 pgxc_node_send_bind(conn, combiner->cursor, combiner->cursor,
-									paramlen, paramdata, epqctxlen, epqctxdata, shardmap);
+									paramlen, paramdata, epqctxlen, epqctxdata, shardmap,
+									adaptive, plan->adaptiveRows);
                 if (enable_statistic)
                 {
                     elog(LOG, "Bind Message:pid:%d,remote_pid:%d,remote_ip:%s,remote_port:%d,fd:%d,cursor:%s",
@@ -11154,7 +11554,8 @@ primary_mode_phase_two:
 
                 /* bind */
 				pgxc_node_send_bind(conn, cursor, cursor, paramlen, paramdata,
-				                    epqctxlen, epqctxdata, shardmap);
+				                    epqctxlen, epqctxdata, shardmap,
+				                    adaptive, plan->adaptiveRows);
 
                 if (enable_statistic)
                 {
@@ -11247,11 +11648,23 @@ primary_mode_phase_two:
             node->bound = true;
     }
 
+#ifdef __OPENTENBASE__
+    /* measure the wait for the rows of the producers */
+    if (node->measure_exchange && combiner->ss.ps.instrument->need_timer &&
+        !node->local_exec)
+        INSTR_TIME_SET_CURRENT(wait_start);
+    else
+        INSTR_TIME_SET_ZERO(wait_start);
+#endif
+
     if (combiner->tuplesortstate)
     {
         if (tuplesort_gettupleslot((Tuplesortstate *) combiner->tuplesortstate,
                                    true, true, resultslot, NULL))
         {
+#ifdef __OPENTENBASE__
+            exchange_wait_done(node, &wait_start);
+#endif
             if (log_remotesubplan_stats)
                 ShowUsageCommon("ExecRemoteSubplan", &start_r, &start_t);
             return resultslot;
@@ -11260,8 +11673,15 @@ primary_mode_phase_two:
     else
     {
         TupleTableSlot *slot = FetchTuple(combiner);
+#ifdef __OPENTENBASE__
+        exchange_wait_done(node, &wait_start);
+#endif
         if (!TupIsNull(slot))
         {
+#ifdef __OPENTENBASE__
+            if (node->adaptive_exchange == ADAPTIVE_EXCHANGE_COUNTING)
+                adaptive_count_row(node, slot);
+#endif
             if (log_remotesubplan_stats)
                 ShowUsageCommon("ExecRemoteSubplan", &start_r, &start_t);
             return slot;
@@ -11270,9 +11690,18 @@ primary_mode_phase_two:
             /* phase1 is successfully completed, run on other nodes */
             goto primary_mode_phase_two;
     }
+#ifdef __OPENTENBASE__
+    exchange_wait_done(node, &wait_start);
+#endif
     if (combiner->errorMessage)
         pgxc_node_report_error(combiner);
 
+#ifdef __OPENTENBASE__
+    /* no producer sent more rows than it broadcasts */
+    if (node->adaptive_exchange == ADAPTIVE_EXCHANGE_COUNTING)
+        node->adaptive_exchange = ADAPTIVE_EXCHANGE_BROADCAST;
+#endif
+
     if (log_remotesubplan_stats)
         ShowUsageCommon("ExecRemoteSubplan", &start_r, &start_t);
 
@@ -11361,6 +11790,7 @@ ExecShutdownRemoteSubplan(RemoteSubplanState *node)
 		ctx.node_idx_List = ((RemoteSubplan *) plan)->nodeList;
 		ctx.printed_nodes = NULL;
 		AttachRemoteInstr(ps->lefttree, &ctx);
+		AttachRemoteProducerInstr(node, &ctx);
 		
 		MemoryContextSwitchTo(oldcontext);
 	}
@@ -12689,6 +13119,163 @@ is_node_prepared(RemoteQueryState *rstate, int node)
     return BIT_SET(rstate->dml_prepared_mask[wordindex], wordoffset) != 0;
 }
 
+/*
+ * Can rows of the DML be sent to the datanodes without waiting for the
+ * outcome of each?  Only if nothing done for the row on the coordinator after
+ * it was applied depends on whether it was found: no AFTER ROW triggers or
+ * transition tables, no RETURNING, no UPSERT.  Replicated tables are excluded
+ * because every node must report the same row count for every row.
+ */
+static bool
+remote_dml_batchable(ModifyTableState *mtstate, RemoteQueryState *node,
+                     ResultRelInfo *resultRelInfo)
+{
+    ResponseCombiner *combiner = (ResponseCombiner *) node;
+    TriggerDesc *trigdesc = resultRelInfo->ri_TrigDesc;
+
+    if (RemoteDMLBatchSize <= 1)
+        return false;
+
+    if (combiner->combine_type != COMBINE_TYPE_SUM ||
+        resultRelInfo->ri_projectReturning ||
+        mtstate->mt_transition_capture)
+        return false;
+
+    switch (mtstate->operation)
+    {
+        case CMD_INSERT:
+            return mtstate->mt_onconflict == ONCONFLICT_NONE &&
+                !(trigdesc && trigdesc->trig_insert_after_row);
+        case CMD_UPDATE:
+            return !(trigdesc && trigdesc->trig_update_after_row);
+        case CMD_DELETE:
+            return !(trigdesc && trigdesc->trig_delete_after_row);
+        default:
+            return false;
+    }
+}
+
+/*
+ * Read the answers to the rows ExecRemoteDML pipelined to the connection.
+ * Each row is answered by CommandComplete, or by ErrorResponse after which
+ * the node ignores the rest until Sync.  Errors are left in the combiner to
+ * be reported by the caller.
+ */
+static void
+pgxc_dml_batch_drain(RemoteQueryState *node, PGXCNodeHandle *conn)
+{
+    ResponseCombiner *combiner = (ResponseCombiner *) node;
+    int        sent = conn->dml_pipelined;
+    int32    processed = combiner->DML_processed;
+    bool    synced = false;
+
+    while (conn->dml_pipelined > 0)
+    {
+        int res;
+
+        if (conn->state == DN_CONNECTION_STATE_ERROR_FATAL)
+        {
+            conn->dml_pipelined = 0;
+            ereport(ERROR,
+                    (errcode(ERRCODE_CONNECTION_FAILURE),
+                     errmsg("Lost connection to node %s while executing DML, remote pid %d",
+                            conn->nodename, conn->backend_pid)));
+        }
+
+        /* every CommandComplete puts the connection to idle */
+        PGXCNodeSetConnectionState(conn, DN_CONNECTION_STATE_QUERY);
+        conn->combiner = combiner;
+
+        res = handle_response(conn, combiner);
+        if (res == RESPONSE_EOF)
+        {
+            if (pgxc_node_receive(1, &conn, NULL))
+            {
+                conn->dml_pipelined = 0;
+                ereport(ERROR,
+                        (errcode(ERRCODE_INTERNAL_ERROR),
+                         errmsg("Failed to receive DML results from node %s, remote pid %d",
+                                conn->nodename, conn->backend_pid)));
+            }
+        }
+        else if (res == RESPONSE_COMPLETE)
+        {
+            /* after an error only ReadyForQuery tells the rows are done */
+            if (!synced)
+                conn->dml_pipelined--;
+        }
+        else if (res == RESPONSE_ERROR)
+        {
+            if (!synced)
+            {
+                if (pgxc_node_send_sync(conn) != 0)
+                {
+                    conn->dml_pipelined = 0;
+                    ereport(ERROR,
+                            (errcode(ERRCODE_INTERNAL_ERROR),
+                             errmsg("Failed to sync msg to node %s backend_pid:%d",
+                                    conn->nodename, conn->backend_pid)));
+                }
+                synced = true;
+            }
+        }
+        else if (res == RESPONSE_DATAROW)
+        {
+            /* not expected without RETURNING, skip it */
+            pfree(combiner->currentRow);
+            combiner->currentRow = NULL;
+        }
+    }
+    conn->combiner = NULL;
+
+    if (synced || combiner->errorMessage)
+        return;
+
+    processed = combiner->DML_processed - processed;
+    if (processed > sent)
+        elog(ERROR, "RemoteDML affects %d rows, more than %d rows.", processed, sent);
+
+    /* the rows not found were counted as processed when they were sent */
+    if (node->dml_batch_estate)
+        node->dml_batch_estate->es_processed -= sent - processed;
+}
+
+/*
+ * ExecFinishRemoteDML
+ *        Wait for the rows of the ModifyTable still pipelined to the datanodes
+ *        and report their errors.
+ */
+void
+ExecFinishRemoteDML(ModifyTableState *mtstate)
+{
+    ModifyTable *plan = (ModifyTable *) mtstate->ps.plan;
+    int            nremote_plans = list_length(plan->remote_plans);
+    int            i;
+    int            j;
+
+    for (i = 0; i < nremote_plans; i++)
+    {
+        RemoteQueryState *node = (RemoteQueryState *) mtstate->mt_remoterels[i];
+        ResponseCombiner *combiner = (ResponseCombiner *) node;
+
+        if (node == NULL)
+            continue;
+
+        for (j = 0; j < node->dml_batch_nconns; j++)
+        {
+            PGXCNodeHandle *conn = node->dml_batch_conns[j];
+
+            if (conn->dml_pipelined > 0 &&
+                conn->combiner == combiner)
+                pgxc_dml_batch_drain(node, conn);
+        }
+        node->dml_batch_nconns = 0;
+
+        if (combiner->errorMessage)
+            pgxc_node_report_error(combiner);
+    }
+}
+
 /*
   *   ExecRemoteDML----execute DML on coordinator
   *   return true if insert/update/delete successfully, else false.
@@ -12790,10 +13377,58 @@ ExecRemoteDML(ModifyTableState *mtstate, ItemPointer tupleid, HeapTuple oldtuple
       * unexepected, but it does happen, goto step 1.
       * We have to repeat step 1 and step 2, until finish.
       */
+    if (remote_dml_batchable(mtstate, node, resultRelInfo))
+    {
+        PGXCNodeHandle *conn = connections[i];
+        int                j;
+
+        /* a drain done on behalf of someone else may have found an error */
+        if (combiner->errorMessage)
+            pgxc_node_report_error(combiner);
+
+        /*
+         * Queue the row after the ones still unanswered, the connection is
+         * ours while they are, see BufferConnection.
+         */
+        if (conn->dml_pipelined > 0)
+            PGXCNodeSetConnectionState(conn, DN_CONNECTION_STATE_IDLE);
+
+        if (!pgxc_start_command_on_connection(conn, node, snapshot, NULL))
+        {
+            pgxc_node_remote_abort(TXN_TYPE_RollbackTxn, true);
+            pfree_pgxc_all_handles(pgxc_connections);
+            elog(ERROR, "Failed to send command to datanode in ExecRemoteDML, nodeid:%d.",
+                        conn->nodeid);
+        }
+
+        if (node->dml_batch_conns == NULL)
+            node->dml_batch_conns = (PGXCNodeHandle **)
+                MemoryContextAlloc(combiner->ss.ps.state->es_query_cxt,
+                                   NumDataNodes * sizeof(PGXCNodeHandle *));
+        for (j = 0; j < node->dml_batch_nconns; j++)
+        {
+            if (node->dml_batch_conns[j] == conn)
+                break;
+        }
+        if (j == node->dml_batch_nconns)
+            node->dml_batch_conns[node->dml_batch_nconns++] = conn;
+        node->dml_batch_estate = canSetTag ? estate : NULL;
+
+        /* assume the row is found, pgxc_dml_batch_drain corrects the count */
+        if (++conn->dml_pipelined >= RemoteDMLBatchSize)
+        {
+            pgxc_dml_batch_drain(node, conn);
+            if (combiner->errorMessage)
+                pgxc_node_report_error(combiner);
+        }
+
+        return true;
+    }
+
     if (operation == CMD_UPDATE || operation == CMD_DELETE ||
         (operation == CMD_INSERT && mtstate->mt_onconflict != ONCONFLICT_UPDATE))
     {
-        if (!pgxc_start_command_on_connection(connections[i], node, snapshot))
+        if (!pgxc_start_command_on_connection(connections[i], node, snapshot, NULL))
         {
             pgxc_node_remote_abort(TXN_TYPE_RollbackTxn, true);
             pfree_pgxc_all_handles(pgxc_connections);
@@ -12828,7 +13463,7 @@ UPSERT:
                 step->sql_statement = step->sql_select;
                 step->statement = step->select_cursor;
 
-                if (!pgxc_start_command_on_connection(connections[i], node, snapshot))
+                if (!pgxc_start_command_on_connection(connections[i], node, snapshot, NULL))
                 {
                     pgxc_node_remote_abort(TXN_TYPE_RollbackTxn, true);
                     pfree_pgxc_all_handles(pgxc_connections);
@@ -12848,7 +13483,7 @@ UPSERT:
             /* no conflict tuple found, try to insert */
             case UPSERT_INSERT:
             {
-                if (!pgxc_start_command_on_connection(connections[i], node, snapshot))
+                if (!pgxc_start_command_on_connection(connections[i], node, snapshot, NULL))
                 {
                     pgxc_node_remote_abort(TXN_TYPE_RollbackTxn, true);
                     pfree_pgxc_all_handles(pgxc_connections);
@@ -0,0 +1,348 @@
+/*-------------------------------------------------------------------------
+ *
+ * netcost.c
+ *	  Network costs measured from the remote fragments executed
+ *
+ * The planner charges remote_query_cost for setting up a remote fragment
+ * and network_byte_cost for every byte it sends. Both are configured
+ * values. Here the node measures them from the fragments it executes
+ * remotely: the startup latency as the time from sending a fragment to the
+ * BindComplete of the remote portal, the transfer rate as the bytes of the
+ * data rows received over the time they took to arrive. The measurements
+ * are kept per remote node in shared memory as moving averages, and with
+ * enable_network_cost_calibration the planner uses them converted to cost
+ * units by network_cost_time_unit.
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/pgxc/pool/netcost.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "access/xact.h"
+#include "catalog/pg_type.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "optimizer/cost.h"
+#include "pgxc/netcost.h"
+#include "pgxc/nodemgr.h"
+#include "pgxc/pgxc.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
+#include "utils/builtins.h"
+
+/* GUC parameters */
+bool		enable_network_cost_calibration = false;
+double		network_cost_time_unit = 10.0;	/* microseconds */
+
+/* weight of a new measurement in the moving averages */
+#define NETCOST_WEIGHT			0.1
+/* fewer bytes do not tell the transfer rate */
+#define NETCOST_MIN_BYTES		(64 * 1024)
+
+#define NETCOST_MAX_NODES \
+	(OPENTENBASE_MAX_DATANODE_NUMBER + OPENTENBASE_MAX_COORDINATOR_NUMBER)
+
+typedef struct NetworkCostEntry
+{
+	Oid			nodeoid;		/* remote node, InvalidOid if unused */
+	uint64		startup_samples;
+	double		startup_usec;	/* average fragment startup latency */
+	uint64		transfer_samples;
+	uint64		transfer_bytes; /* bytes of all the samples */
+	double		usec_per_byte;	/* average transfer time of a byte */
+	TimestampTz last_update;
+} NetworkCostEntry;
+
+typedef struct NetworkCostShmemStruct
+{
+	slock_t		mutex;			/* protects everything below */
+	int			nentries;
+	NetworkCostEntry entries[NETCOST_MAX_NODES];
+} NetworkCostShmemStruct;
+
+static NetworkCostShmemStruct *NetworkCostShmem = NULL;
+
+/* averages over the nodes, computed once per statement */
+static TimestampTz cached_stmt_start = 0;
+static double cached_byte_cost = -1;
+static double cached_query_cost = -1;
+
+static NetworkCostEntry *network_cost_entry(Oid nodeoid);
+
+
+Size
+NetworkCostShmemSize(void)
+{
+	return sizeof(NetworkCostShmemStruct);
+}
+
+void
+NetworkCostShmemInit(void)
+{
+	bool		found;
+
+	NetworkCostShmem = (NetworkCostShmemStruct *)
+		ShmemInitStruct("Network Cost Calibration",
+						NetworkCostShmemSize(),
+						&found);
+
+	if (!found)
+	{
+		SpinLockInit(&NetworkCostShmem->mutex);
+		NetworkCostShmem->nentries = 0;
+	}
+}
+
+/*
+ * Entry of the node, a new one if it has none. NULL if there is no room.
+ * Called with the mutex held.
+ */
+static NetworkCostEntry *
+network_cost_entry(Oid nodeoid)
+{
+	NetworkCostEntry *entry;
+	int			i;
+
+	for (i = 0; i < NetworkCostShmem->nentries; i++)
+	{
+		if (NetworkCostShmem->entries[i].nodeoid == nodeoid)
+			return &NetworkCostShmem->entries[i];
+	}
+
+	if (NetworkCostShmem->nentries >= NETCOST_MAX_NODES)
+		return NULL;
+
+	entry = &NetworkCostShmem->entries[NetworkCostShmem->nentries++];
+	memset(entry, 0, sizeof(NetworkCostEntry));
+	entry->nodeoid = nodeoid;
+	return entry;
+}
+
+/*
+ * A fragment sent to the node at sent got its portal bound at answered.
+ */
+void
+NetworkCostReportStartup(Oid nodeoid, TimestampTz sent, TimestampTz answered)
+{
+	NetworkCostEntry *entry;
+	double		usec = (double) (answered - sent);
+
+	if (NetworkCostShmem == NULL || usec < 0)
+		return;
+
+	SpinLockAcquire(&NetworkCostShmem->mutex);
+	entry = network_cost_entry(nodeoid);
+	if (entry)
+	{
+		if (entry->startup_samples == 0)
+			entry->startup_usec = usec;
+		else
+			entry->startup_usec += NETCOST_WEIGHT * (usec - entry->startup_usec);
+		entry->startup_samples++;
+		entry->last_update = answered;
+	}
+	SpinLockRelease(&NetworkCostShmem->mutex);
+}
+
+/*
+ * The node sent bytes of data rows from start to end.
+ */
+void
+NetworkCostReportTransfer(Oid nodeoid, uint64 bytes,
+						  TimestampTz start, TimestampTz end)
+{
+	NetworkCostEntry *entry;
+	double		usec = (double) (end - start);
+	double		usec_per_byte;
+
+	if (NetworkCostShmem == NULL || bytes < NETCOST_MIN_BYTES || usec <= 0)
+		return;
+
+	usec_per_byte = usec / (double) bytes;
+
+	SpinLockAcquire(&NetworkCostShmem->mutex);
+	entry = network_cost_entry(nodeoid);
+	if (entry)
+	{
+		if (entry->transfer_samples == 0)
+			entry->usec_per_byte = usec_per_byte;
+		else
+			entry->usec_per_byte += NETCOST_WEIGHT *
+				(usec_per_byte - entry->usec_per_byte);
+		entry->transfer_samples++;
+		entry->transfer_bytes += bytes;
+		entry->last_update = end;
+	}
+	SpinLockRelease(&NetworkCostShmem->mutex);
+}
+
+/*
+ * Costs the planner charges for sending a byte and for setting up a remote
+ * fragment. The averages over the nodes measured if calibration is enabled,
+ * the configured values for what is not measured yet.
+ */
+void
+GetNetworkCost(double *byte_cost, double *query_cost)
+{
+	TimestampTz stmt_start;
+
+	*byte_cost = network_byte_cost;
+	*query_cost = remote_query_cost;
+
+	if (!enable_network_cost_calibration || NetworkCostShmem == NULL ||
+		network_cost_time_unit <= 0)
+		return;
+
+	/* the paths of a statement are costed alike */
+	stmt_start = GetCurrentStatementStartTimestamp();
+	if (stmt_start != cached_stmt_start)
+	{
+		double		startup_sum = 0;
+		double		byte_sum = 0;
+		int			nstartup = 0;
+		int			nbyte = 0;
+		int			i;
+
+		SpinLockAcquire(&NetworkCostShmem->mutex);
+		for (i = 0; i < NetworkCostShmem->nentries; i++)
+		{
+			NetworkCostEntry *entry = &NetworkCostShmem->entries[i];
+
+			if (entry->startup_samples > 0)
+			{
+				startup_sum += entry->startup_usec;
+				nstartup++;
+			}
+			if (entry->transfer_samples > 0)
+			{
+				byte_sum += entry->usec_per_byte;
+				nbyte++;
+			}
+		}
+		SpinLockRelease(&NetworkCostShmem->mutex);
+
+		cached_query_cost = nstartup > 0 ?
+			startup_sum / nstartup / network_cost_time_unit : -1;
+		cached_byte_cost = nbyte > 0 ?
+			byte_sum / nbyte / network_cost_time_unit : -1;
+		cached_stmt_start = stmt_start;
+	}
+
+	if (cached_byte_cost >= 0)
+		*byte_cost = cached_byte_cost;
+	if (cached_query_cost >= 0)
+		*query_cost = cached_query_cost;
+}
+
+/*
+ * Show the measurements of the remote nodes, and the costs they calibrate.
+ */
+Datum
+opentenbase_network_cost(PG_FUNCTION_ARGS)
+{
+#define NETCOST_COLUMNS 9
+	FuncCallContext *funcctx;
+	NetworkCostEntry *entries;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(NETCOST_COLUMNS, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "node_name",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "startup_samples",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "startup_usec",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "transfer_samples",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "transfer_bytes",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 6, "bytes_per_sec",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 7, "remote_query_cost",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 8, "network_byte_cost",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 9, "last_update",
+						   TIMESTAMPTZOID, -1, 0);
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		/* work on a copy, the names are looked up without the mutex */
+		entries = (NetworkCostEntry *) palloc(sizeof(NetworkCostEntry) * NETCOST_MAX_NODES);
+		funcctx->max_calls = 0;
+		if (NetworkCostShmem)
+		{
+			SpinLockAcquire(&NetworkCostShmem->mutex);
+			funcctx->max_calls = NetworkCostShmem->nentries;
+			memcpy(entries, NetworkCostShmem->entries,
+				   sizeof(NetworkCostEntry) * NetworkCostShmem->nentries);
+			SpinLockRelease(&NetworkCostShmem->mutex);
+		}
+		funcctx->user_fctx = entries;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	entries = (NetworkCostEntry *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		NetworkCostEntry *entry = &entries[funcctx->call_cntr];
+		Datum		values[NETCOST_COLUMNS];
+		bool		nulls[NETCOST_COLUMNS];
+		NodeDefinition *node = PgxcNodeGetDefinition(entry->nodeoid);
+		HeapTuple	tuple;
+
+		MemSet(nulls, 0, sizeof(nulls));
+
+		/* the node may be dropped since */
+		if (node)
+			values[0] = CStringGetTextDatum(NameStr(node->nodename));
+		else
+			nulls[0] = true;
+		values[1] = Int64GetDatum((int64) entry->startup_samples);
+		values[3] = Int64GetDatum((int64) entry->transfer_samples);
+		values[4] = Int64GetDatum((int64) entry->transfer_bytes);
+		if (entry->startup_samples > 0)
+		{
+			values[2] = Float8GetDatum(entry->startup_usec);
+			values[6] = Float8GetDatum(network_cost_time_unit > 0 ?
+									   entry->startup_usec / network_cost_time_unit :
+									   remote_query_cost);
+		}
+		else
+		{
+			nulls[2] = true;
+			nulls[6] = true;
+		}
+		if (entry->transfer_samples > 0 && entry->usec_per_byte > 0)
+		{
+			values[5] = Float8GetDatum(1000000.0 / entry->usec_per_byte);
+			values[7] = Float8GetDatum(network_cost_time_unit > 0 ?
+									   entry->usec_per_byte / network_cost_time_unit :
+									   network_byte_cost);
+		}
+		else
+		{
+			nulls[5] = true;
+			nulls[7] = true;
+		}
+		values[8] = TimestampTzGetDatum(entry->last_update);
+
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
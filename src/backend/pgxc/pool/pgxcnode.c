@@ -22,6 +22,9 @@
 
 #include "postgres.h"
 #include <poll.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 
 #ifdef __sun
 #include <sys/filio.h>
@@ -30,6 +33,9 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/ioctl.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -50,6 +56,9 @@
 #include "pgxc/nodemgr.h"
 #include "pgxc/pgxc.h"
 #include "pgxc/poolmgr.h"
+#include "pgxc/squeue.h"
+#include "port/atomics.h"
+#include "portability/instr_time.h"
 #include "tcop/dest.h"
 #include "storage/lwlock.h"
 #include "utils/builtins.h"
@@ -118,6 +127,137 @@ pgxc_check_socket_health(int sock, int forRead, int forWrite, time_t end_time);
 
 static int	pgxc_coordinator_proc_pid = 0;
 static TransactionId pgxc_coordinator_proc_vxid = InvalidTransactionId;
+
+/*
+ * Handles whose flush is deferred to pgxc_node_batch_send_end(), see
+ * pgxc_node_batch_send_begin().
+ */
+static bool            batch_send_active = false;
+static PGXCNodeHandle **batch_send_handles = NULL;
+static int             batch_send_count = 0;
+static int             batch_send_size = 0;
+
+#ifdef HAVE_SYS_EPOLL_H
+/*
+ * Per session epoll set the sockets of the handles waited for by
+ * pgxc_node_receive() are registered in. A socket stays registered while
+ * its handle keeps it, epoll_owner maps registered sockets to their handle.
+ */
+static int             receive_epoll_fd = -1;
+static uint32          receive_epoll_gen = 0;
+static PGXCNodeHandle **epoll_owner = NULL;
+static int             epoll_owner_size = 0;
+
+static int  pgxc_node_epoll_wait(PGXCNodeHandle **wanted, int nwanted, long timeout_ms,
+                                 struct pollfd *pool_fd, int *ready_idx);
+static void pgxc_node_epoll_forget(int sock);
+static void pgxc_node_epoll_reset(void);
+#endif
+
+/*
+ * Input of a handle received by a reader thread, see
+ * pgxc_node_start_receive_pump(). The thread appends to the ring and
+ * advances head, the backend consumes and advances tail, both positions
+ * only grow. The structure is malloc'ed, the thread can not palloc.
+ */
+#define RECEIVE_PUMP_RING_SIZE (256 * 1024)		/* power of 2 */
+#define RECEIVE_PUMP_MIN_SPACE 8192
+
+struct PGXCNodeReceivePump
+{
+    int             sock;
+    int             reader;         /* index in receive_readers */
+    char           *ring;
+    volatile uint64 head;           /* set by the reader thread */
+    volatile uint64 tail;           /* set by the backend */
+    volatile bool   eof;            /* peer closed the connection */
+    volatile int    err;            /* errno of a failed recv() */
+    volatile bool   full;           /* reader waits for ring space */
+};
+typedef struct PGXCNodeReceivePump PGXCNodeReceivePump;
+
+/*
+ * Reader thread, receiving into the rings of the pumps assigned to it.
+ * The pump list is protected by lock, gen changes whenever it does and
+ * wake_fd wakes the thread up to look at it again.
+ */
+typedef struct
+{
+    pthread_mutex_t         lock;
+    int                     wake_fd[2];
+    uint32                  gen;
+    PGXCNodeReceivePump   **pumps;
+    int                     npumps;
+    int                     maxpumps;
+} PGXCNodeReceiveReader;
+
+static PGXCNodeReceiveReader receive_readers[MAX_REMOTE_RECEIVE_THREADS];
+static int             receive_nreaders = 0;
+/* readers write a byte to it when a ring gets input, the backend waits on it */
+static int             receive_notify_fd[2] = {-1, -1};
+static int             receive_pumps = 0;
+
+static bool pgxc_node_receive_readers_init(void);
+static void *pgxc_node_receive_reader(void *arg);
+static void pgxc_node_pump_fill(PGXCNodeReceivePump *pump);
+static bool pgxc_node_pump_readable(PGXCNodeReceivePump *pump);
+static int  pgxc_node_pump_recv(PGXCNodeHandle *conn, char *buf, size_t len);
+static void pgxc_node_pipe_drain(int fd);
+
+/*
+ * Output of a handle sent by a writer thread, see
+ * pgxc_node_start_send_pump(). The backend appends to the ring and advances
+ * head, the thread sends and advances tail, both positions only grow. The
+ * ring bounds how far the node may lag behind the backend. The structure
+ * is malloc'ed, the thread can not palloc.
+ */
+#define SEND_PUMP_MIN_RING_SIZE (64 * 1024)
+
+struct PGXCNodeSendPump
+{
+    int             sock;
+    int             writer;         /* index in send_writers */
+    char           *ring;
+    size_t          size;           /* power of 2 */
+    volatile uint64 head;           /* set by the backend */
+    volatile uint64 tail;           /* set by the writer thread */
+    volatile int    err;            /* errno of a failed send() */
+    volatile bool   idle;           /* writer waits for output */
+    volatile bool   waiting;        /* backend waits for ring space */
+};
+typedef struct PGXCNodeSendPump PGXCNodeSendPump;
+
+/*
+ * Writer thread, sending from the rings of the pumps assigned to it. The
+ * pump list is protected like the one of a reader.
+ */
+typedef struct
+{
+    pthread_mutex_t         lock;
+    int                     wake_fd[2];
+    uint32                  gen;
+    PGXCNodeSendPump      **pumps;
+    int                     npumps;
+    int                     maxpumps;
+} PGXCNodeSendWriter;
+
+static PGXCNodeSendWriter send_writers[MAX_COPY_SEND_THREADS];
+static int             send_nwriters = 0;
+/* writers write a byte to it when a ring gets space, the backend waits on it */
+static int             send_notify_fd[2] = {-1, -1};
+
+static bool pgxc_node_send_writers_init(void);
+static void *pgxc_node_send_writer(void *arg);
+static void pgxc_node_pump_drain(PGXCNodeSendPump *pump);
+static void pgxc_node_send_pump_wait(PGXCNodeSendPump *pump);
+
+static int send_error(PGXCNodeHandle *handle);
+static int send_nowait(PGXCNodeHandle *handle);
+static int pgxc_node_build_query_extended(PGXCNodeHandle *handle, const char *query,
+							  const char *statement, const char *portal,
+							  int num_params, Oid *param_types,
+							  int paramlen, char *params,
+							  bool send_describe, int fetch_size);
 #endif
 
 /* Current size of dn_handles and co_handles */
@@ -185,6 +325,17 @@ init_pgxc_handle(PGXCNodeHandle *pgxc_handle)
      * Indicate the handle is not initialized yet
      */
     pgxc_handle->sock = NO_SOCKET;
+#ifdef __OPENTENBASE__
+    pgxc_handle->epoll_sock = NO_SOCKET;
+    pgxc_node_forget_subplans(pgxc_handle);
+    pgxc_handle->dml_pipelined = 0;
+    pgxc_handle->recv_pump = NULL;
+    pgxc_handle->send_pump = NULL;
+    pgxc_handle->fragment_sent = 0;
+    pgxc_handle->fragment_rows_start = 0;
+    pgxc_handle->fragment_bytes = 0;
+    pgxc_handle->fragment_measured = false;
+#endif
 
     /* Initialise buffers */
     pgxc_handle->error[0] = '\0';
@@ -621,11 +772,24 @@ PGXCNodeConnected(NODE_CONNECTION *conn)
 static void
 pgxc_node_free(PGXCNodeHandle *handle)
 {
+#ifdef __OPENTENBASE__
+    /* the reader must be done with the socket before it is closed */
+    pgxc_node_stop_receive_pump(handle);
+    pgxc_node_stop_send_pump(handle, true);
+#endif
     if (handle->sock != NO_SOCKET)
     {
+#ifdef HAVE_SYS_EPOLL_H
+        /* closing the socket drops it from the epoll set */
+        if (handle->epoll_sock == handle->sock)
+            pgxc_node_epoll_forget(handle->sock);
+#endif
         close(handle->sock);
     }
     handle->sock = NO_SOCKET;
+#ifdef __OPENTENBASE__
+    handle->epoll_sock = NO_SOCKET;
+#endif
 }
 
 /*
@@ -671,6 +835,13 @@ pgxc_node_all_free(void)
     co_handles = NULL;
     dn_handles = NULL;
     sdn_handles = NULL;
+#ifdef HAVE_SYS_EPOLL_H
+    pgxc_node_epoll_reset();
+#endif
+#ifdef __OPENTENBASE__
+    batch_send_active = false;
+    batch_send_count = 0;
+#endif
     HandlesInvalidatePending = false;
     HandlesRefreshPending = false;
 }
@@ -686,6 +857,17 @@ pgxc_node_init(PGXCNodeHandle *handle, int sock, bool global_session, int pid)
     char *init_str;
 
     handle->sock = sock;
+#ifdef __OPENTENBASE__
+    handle->epoll_sock = NO_SOCKET;
+    pgxc_node_forget_subplans(handle);
+    handle->dml_pipelined = 0;
+    pgxc_node_stop_receive_pump(handle);
+    pgxc_node_stop_send_pump(handle, true);
+    handle->fragment_sent = 0;
+    handle->fragment_rows_start = 0;
+    handle->fragment_bytes = 0;
+    handle->fragment_measured = false;
+#endif
     handle->backend_pid = pid;
     handle->transaction_status = 'I';
     PGXCNodeSetConnectionState(handle, DN_CONNECTION_STATE_IDLE);
@@ -794,6 +976,25 @@ pgxc_node_receive(const int conn_count,
     bool    is_msg_buffered;
     long     timeout_ms;
     struct    pollfd pool_fd[conn_count];
+    int        ready_idx[conn_count];
+    int        nready = 0;
+#ifdef HAVE_SYS_EPOLL_H
+    PGXCNodeHandle *wanted[conn_count];
+#endif
+    int        npumped = 0;
+    bool       pumped_input = false;
+
+#ifdef __OPENTENBASE__
+    /* answers can not come before the deferred requests are sent */
+    if (batch_send_active)
+    {
+        pgxc_node_batch_send_end();
+    }
+
+    /* the rings are looked at below, older wake ups are stale */
+    if (receive_pumps > 0)
+        pgxc_node_pipe_drain(receive_notify_fd[0]);
+#endif
 
     /* sockets to be polled index */
     sockets_to_poll = 0;
@@ -820,11 +1021,31 @@ pgxc_node_receive(const int conn_count,
             continue;
         }
 
+#ifdef __OPENTENBASE__
+        /* input of a pumped handle arrives in its ring, wait for the readers */
+        if (connections[i]->recv_pump && connections[i]->sock > 0)
+        {
+            pool_fd[i].fd = receive_notify_fd[0];
+            pool_fd[i].events = POLLIN;
+            pool_fd[i].revents = 0;
+            if (pgxc_node_pump_readable(connections[i]->recv_pump))
+                pumped_input = true;
+            npumped++;
+            sockets_to_poll++;
+            continue;
+        }
+#endif
+
         /* prepare select params */
         if (connections[i]->sock > 0)
         {
             pool_fd[i].fd = connections[i]->sock;
             pool_fd[i].events = POLLIN | POLLPRI | POLLRDNORM | POLLRDBAND;
+            pool_fd[i].revents = 0;
+#ifdef HAVE_SYS_EPOLL_H
+            connections[i]->epoll_idx = i;
+            wanted[sockets_to_poll] = connections[i];
+#endif
             sockets_to_poll++;
         }
         else
@@ -869,7 +1090,52 @@ pgxc_node_receive(const int conn_count,
 
 retry:
 	CHECK_FOR_INTERRUPTS();
-    poll_val  = poll(pool_fd, conn_count, timeout_ms);
+#ifdef HAVE_SYS_EPOLL_H
+    /*
+     * wait in the epoll set, O(ready handles), fall back to poll() if unusable
+     * or if the notification pipe of the reader threads is waited for as well
+     */
+    poll_val = npumped > 0 ? -2 :
+        pgxc_node_epoll_wait(wanted, sockets_to_poll, timeout_ms, pool_fd, ready_idx);
+    if (poll_val == -2)
+#endif
+    {
+        /* do not wait if a ring already has input */
+        poll_val = poll(pool_fd, conn_count, pumped_input ? 0 : timeout_ms);
+        if (poll_val >= 0)
+        {
+            for (i = 0; i < conn_count; i++)
+            {
+                if (pool_fd[i].fd == -1)
+                    continue;
+                if (connections[i]->recv_pump ?
+                    pgxc_node_pump_readable(connections[i]->recv_pump) :
+                    pool_fd[i].revents != 0)
+                    ready_idx[nready++] = i;
+            }
+#ifdef __OPENTENBASE__
+            /* a wake up for input already consumed waits again */
+            if (poll_val > 0 && nready == 0)
+            {
+                pgxc_node_pipe_drain(receive_notify_fd[0]);
+                for (i = 0; i < conn_count; i++)
+                {
+                    if (pool_fd[i].fd != -1 && connections[i]->recv_pump &&
+                        pgxc_node_pump_readable(connections[i]->recv_pump))
+                        pumped_input = true;
+                }
+                goto retry;
+            }
+#endif
+            poll_val = nready;
+        }
+    }
+#ifdef HAVE_SYS_EPOLL_H
+    else if (poll_val > 0)
+    {
+        nready = poll_val;
+    }
+#endif
     if (poll_val < 0)
     {
         /* error - retry if EINTR */
@@ -920,13 +1186,31 @@ retry:
     }
 
     /* read data */
-    for (i = 0; i < conn_count; i++)
+    for (poll_val = 0; poll_val < nready; poll_val++)
     {
-        PGXCNodeHandle *conn = connections[i];
+        PGXCNodeHandle *conn;
+
+        i = ready_idx[poll_val];
+        conn = connections[i];
 
         if( pool_fd[i].fd == -1 )
             continue;
 
+#ifdef __OPENTENBASE__
+        if (conn->recv_pump)
+        {
+            if (pgxc_node_read_data(conn, true) < 0)
+            {
+                PGXCNodeSetConnectionState(conn,
+                        DN_CONNECTION_STATE_ERROR_FATAL);
+                add_error_message(conn, "unexpected EOF on datanode connection.");
+                elog(LOG, "unexpected EOF on node:%s pid:%d received by a reader thread", conn->nodename, conn->backend_pid);
+                return DNStatus_ERR;
+            }
+            continue;
+        }
+#endif
+
         if ( pool_fd[i].fd == conn->sock )
         {
             if( pool_fd[i].revents & POLLIN )
@@ -981,13 +1265,989 @@ retry:
             }
         }
     }
-#ifdef __OPENTENBASE__
-    return DNStatus_OK;            
-#else
-    return NO_ERROR_OCCURED;
-#endif
-}
+#ifdef __OPENTENBASE__
+    return DNStatus_OK;            
+#else
+    return NO_ERROR_OCCURED;
+#endif
+}
+
+
+#ifdef HAVE_SYS_EPOLL_H
+/*
+ * Wait for input on the wanted handles in the epoll set. The set is updated
+ * only for the handles whose socket is not registered yet, or registered for
+ * another handle. Registered handles that fire while nobody waits for them
+ * are dropped from the set, so that they do not wake up every wait.
+ *
+ * The revents of the ready handles are stored in pool_fd at their epoll_idx
+ * and the indexes in ready_idx. Return the number of ready handles, 0 on
+ * timeout, -1 with errno set on error and -2 if epoll can not be used.
+ * Wakeups for handles not waited for do not extend timeout_ms.
+ */
+static int
+pgxc_node_epoll_wait(PGXCNodeHandle **wanted, int nwanted, long timeout_ms,
+                     struct pollfd *pool_fd, int *ready_idx)
+{
+    struct epoll_event events[nwanted];
+    int                i;
+    int                nevents;
+    int                nready = 0;
+    long               cur_timeout = timeout_ms;
+    instr_time         start_time;
+    instr_time         cur_time;
+
+    if (receive_epoll_fd < 0)
+    {
+        receive_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (receive_epoll_fd < 0)
+        {
+            elog(LOG, "epoll_create1() failed for error: %d, %s, use poll()", errno, strerror(errno));
+            return -2;
+        }
+    }
+
+    receive_epoll_gen++;
+    for (i = 0; i < nwanted; i++)
+    {
+        PGXCNodeHandle *handle = wanted[i];
+        int             sock = handle->sock;
+
+        handle->epoll_gen = receive_epoll_gen;
+        if (handle->epoll_sock == sock)
+            continue;
+
+        if (sock >= epoll_owner_size)
+        {
+            int newsize = Max(sock + 1, epoll_owner_size * 2);
+
+            epoll_owner = epoll_owner ?
+                (PGXCNodeHandle **) repalloc(epoll_owner, newsize * sizeof(PGXCNodeHandle *)) :
+                (PGXCNodeHandle **) MemoryContextAlloc(TopMemoryContext, newsize * sizeof(PGXCNodeHandle *));
+            memset(epoll_owner + epoll_owner_size, 0, (newsize - epoll_owner_size) * sizeof(PGXCNodeHandle *));
+            epoll_owner_size = newsize;
+        }
+
+        /* the socket may be left registered for a handle which lost it */
+        if (epoll_owner[sock] && epoll_owner[sock] != handle &&
+            epoll_owner[sock]->epoll_sock == sock)
+        {
+            epoll_owner[sock]->epoll_sock = NO_SOCKET;
+        }
+
+        events[0].events = EPOLLIN | EPOLLPRI;
+        events[0].data.fd = sock;
+        if (epoll_ctl(receive_epoll_fd, EPOLL_CTL_ADD, sock, &events[0]) < 0 &&
+            (errno != EEXIST ||
+             epoll_ctl(receive_epoll_fd, EPOLL_CTL_MOD, sock, &events[0]) < 0))
+        {
+            elog(LOG, "epoll_ctl() failed for error: %d, %s, use poll()", errno, strerror(errno));
+            return -2;
+        }
+        epoll_owner[sock] = handle;
+        handle->epoll_sock = sock;
+    }
+
+    if (timeout_ms > 0)
+        INSTR_TIME_SET_CURRENT(start_time);
+
+    for (;;)
+    {
+        nevents = epoll_wait(receive_epoll_fd, events, nwanted, cur_timeout);
+        if (nevents <= 0)
+            return nevents;
+
+        for (i = 0; i < nevents; i++)
+        {
+            int             sock = events[i].data.fd;
+            PGXCNodeHandle *handle = sock < epoll_owner_size ? epoll_owner[sock] : NULL;
+
+            if (NULL == handle || handle->sock != sock || handle->epoll_sock != sock ||
+                handle->epoll_gen != receive_epoll_gen)
+            {
+                /* not waited for, do not let it wake up the next waits */
+                pgxc_node_epoll_forget(sock);
+                epoll_ctl(receive_epoll_fd, EPOLL_CTL_DEL, sock, &events[i]);
+                continue;
+            }
+
+            pool_fd[handle->epoll_idx].revents =
+                ((events[i].events & EPOLLIN) ? POLLIN : 0) |
+                ((events[i].events & EPOLLPRI) ? POLLPRI : 0) |
+                ((events[i].events & EPOLLERR) ? POLLERR : 0) |
+                ((events[i].events & EPOLLHUP) ? POLLHUP : 0);
+            ready_idx[nready++] = handle->epoll_idx;
+        }
+
+        if (nready > 0)
+            return nready;
+
+        /* wait only for what is left of the timeout */
+        if (timeout_ms > 0)
+        {
+            INSTR_TIME_SET_CURRENT(cur_time);
+            INSTR_TIME_SUBTRACT(cur_time, start_time);
+            cur_timeout = timeout_ms - (long) INSTR_TIME_GET_MILLISEC(cur_time);
+            if (cur_timeout <= 0)
+                return 0;
+        }
+        else if (timeout_ms == 0)
+        {
+            return 0;
+        }
+    }
+}
+
+/*
+ * Forget the registration of sock, called when it is closed or found not
+ * to be waited for.
+ */
+static void
+pgxc_node_epoll_forget(int sock)
+{
+    if (sock >= 0 && sock < epoll_owner_size && epoll_owner[sock])
+    {
+        if (epoll_owner[sock]->epoll_sock == sock)
+            epoll_owner[sock]->epoll_sock = NO_SOCKET;
+        epoll_owner[sock] = NULL;
+    }
+}
+
+/*
+ * Drop the epoll set, the handles registered in it are freed.
+ */
+static void
+pgxc_node_epoll_reset(void)
+{
+    if (receive_epoll_fd >= 0)
+    {
+        close(receive_epoll_fd);
+        receive_epoll_fd = -1;
+    }
+    if (epoll_owner)
+        memset(epoll_owner, 0, epoll_owner_size * sizeof(PGXCNodeHandle *));
+}
+#endif
+
+/*
+ * Receive the input of a handle with a reader thread from now on.
+ *
+ * While the backend processes the rows of a handle the data node keeps
+ * sending: without a reader its socket buffer fills up and the data node
+ * stalls until the backend comes back to that handle. A reader thread
+ * drains the socket into a ring and pgxc_node_read_data() takes the input
+ * from the ring. Nothing but the input is handed over to the thread, the
+ * messages are processed by the backend as before.
+ *
+ * Silently does nothing if remote_receive_threads is 0 or the readers can
+ * not be set up, the backend receives then.
+ */
+void
+pgxc_node_start_receive_pump(PGXCNodeHandle *handle)
+{
+    PGXCNodeReceivePump   *pump;
+    PGXCNodeReceiveReader *reader;
+    int                    nreaders;
+    int                    i;
+
+    if (handle->recv_pump || handle->sock == NO_SOCKET ||
+        RemoteReceiveThreads <= 0)
+        return;
+
+    if (!pgxc_node_receive_readers_init())
+        return;
+
+    pump = (PGXCNodeReceivePump *) malloc(sizeof(PGXCNodeReceivePump));
+    if (pump == NULL)
+        return;
+    pump->ring = (char *) malloc(RECEIVE_PUMP_RING_SIZE);
+    if (pump->ring == NULL)
+    {
+        free(pump);
+        return;
+    }
+    pump->sock = handle->sock;
+    pump->head = 0;
+    pump->tail = 0;
+    pump->eof = false;
+    pump->err = 0;
+    pump->full = false;
+
+    /* the least loaded reader */
+    nreaders = Min(RemoteReceiveThreads, receive_nreaders);
+    pump->reader = 0;
+    for (i = 1; i < nreaders; i++)
+    {
+        if (receive_readers[i].npumps < receive_readers[pump->reader].npumps)
+            pump->reader = i;
+    }
+    reader = &receive_readers[pump->reader];
+
+    pthread_mutex_lock(&reader->lock);
+    if (reader->npumps == reader->maxpumps)
+    {
+        int                   newmax = Max(reader->maxpumps * 2, 16);
+        PGXCNodeReceivePump **pumps;
+
+        pumps = (PGXCNodeReceivePump **) realloc(reader->pumps,
+                                                 newmax * sizeof(PGXCNodeReceivePump *));
+        if (pumps == NULL)
+        {
+            pthread_mutex_unlock(&reader->lock);
+            free(pump->ring);
+            free(pump);
+            return;
+        }
+        reader->pumps = pumps;
+        reader->maxpumps = newmax;
+    }
+    reader->pumps[reader->npumps++] = pump;
+    reader->gen++;
+    pthread_mutex_unlock(&reader->lock);
+
+    handle->recv_pump = pump;
+    receive_pumps++;
+    (void) write(reader->wake_fd[1], "w", 1);
+}
+
+/*
+ * Receive the input of a handle in the backend again. Once the reader has
+ * dropped the handle, what it received ahead is appended to the input
+ * buffer, so that it is read before anything else from the socket.
+ */
+void
+pgxc_node_stop_receive_pump(PGXCNodeHandle *handle)
+{
+    PGXCNodeReceivePump   *pump = handle->recv_pump;
+    PGXCNodeReceiveReader *reader;
+    size_t                 avail;
+    int                    i;
+
+    if (pump == NULL)
+        return;
+
+    reader = &receive_readers[pump->reader];
+    pthread_mutex_lock(&reader->lock);
+    for (i = 0; i < reader->npumps; i++)
+    {
+        if (reader->pumps[i] == pump)
+        {
+            reader->pumps[i] = reader->pumps[--reader->npumps];
+            break;
+        }
+    }
+    reader->gen++;
+    pthread_mutex_unlock(&reader->lock);
+    (void) write(reader->wake_fd[1], "w", 1);
+
+    handle->recv_pump = NULL;
+    receive_pumps--;
+
+    avail = (size_t) (pump->head - pump->tail);
+    if (avail > 0)
+    {
+        if (handle->inStart >= handle->inEnd)
+            handle->inStart = handle->inCursor = handle->inEnd = 0;
+        if (ensure_in_buffer_capacity(handle->inEnd + avail, handle) == 0)
+        {
+            size_t  pos = (size_t) (pump->tail & (RECEIVE_PUMP_RING_SIZE - 1));
+            size_t  first = Min(avail, RECEIVE_PUMP_RING_SIZE - pos);
+
+            memcpy(handle->inBuffer + handle->inEnd, pump->ring + pos, first);
+            memcpy(handle->inBuffer + handle->inEnd + first, pump->ring, avail - first);
+            handle->inEnd += avail;
+        }
+        else
+        {
+            /* the input can not be continued, do not use the connection */
+            add_error_message(handle, "can not allocate buffer");
+            PGXCNodeSetConnectionState(handle, DN_CONNECTION_STATE_ERROR_FATAL);
+        }
+    }
+
+    free(pump->ring);
+    free(pump);
+}
+
+/*
+ * Create the notification pipe and the reader threads not created yet,
+ * up to remote_receive_threads. Return false if there is no reader.
+ */
+static bool
+pgxc_node_receive_readers_init(void)
+{
+    int target = Min(RemoteReceiveThreads, MAX_REMOTE_RECEIVE_THREADS);
+
+    if (receive_notify_fd[0] < 0)
+    {
+        if (pipe(receive_notify_fd) != 0)
+        {
+            elog(LOG, "could not create pipe for receive threads: %m");
+            receive_notify_fd[0] = receive_notify_fd[1] = -1;
+            return false;
+        }
+        fcntl(receive_notify_fd[0], F_SETFL, O_NONBLOCK);
+        fcntl(receive_notify_fd[1], F_SETFL, O_NONBLOCK);
+        fcntl(receive_notify_fd[0], F_SETFD, FD_CLOEXEC);
+        fcntl(receive_notify_fd[1], F_SETFD, FD_CLOEXEC);
+    }
+
+    while (receive_nreaders < target)
+    {
+        PGXCNodeReceiveReader *reader = &receive_readers[receive_nreaders];
+        int                    ret;
+
+        if (pipe(reader->wake_fd) != 0)
+        {
+            elog(LOG, "could not create pipe for receive thread: %m");
+            break;
+        }
+        fcntl(reader->wake_fd[0], F_SETFL, O_NONBLOCK);
+        fcntl(reader->wake_fd[1], F_SETFL, O_NONBLOCK);
+        fcntl(reader->wake_fd[0], F_SETFD, FD_CLOEXEC);
+        fcntl(reader->wake_fd[1], F_SETFD, FD_CLOEXEC);
+        pthread_mutex_init(&reader->lock, NULL);
+        reader->gen = 0;
+        reader->pumps = NULL;
+        reader->npumps = 0;
+        reader->maxpumps = 0;
+
+        ret = CreateThread(pgxc_node_receive_reader, (void *) reader, MT_THR_DETACHED);
+        if (ret != 0)
+        {
+            elog(LOG, "could not create receive thread: %s", strerror(ret));
+            close(reader->wake_fd[0]);
+            close(reader->wake_fd[1]);
+            pthread_mutex_destroy(&reader->lock);
+            break;
+        }
+        receive_nreaders++;
+    }
+
+    return receive_nreaders > 0;
+}
+
+/*
+ * Reader thread main loop, lives as long as the backend. Must not palloc,
+ * elog or otherwise touch backend state.
+ */
+static void *
+pgxc_node_receive_reader(void *arg)
+{
+    PGXCNodeReceiveReader *reader = (PGXCNodeReceiveReader *) arg;
+    struct pollfd         *fds = NULL;
+    PGXCNodeReceivePump  **polled = NULL;
+    int                    maxfds = 0;
+    sigset_t               mask;
+
+    /* signals are for the backend */
+    sigfillset(&mask);
+    (void) pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+    for (;;)
+    {
+        uint32  gen;
+        int     nfds = 1;
+        int     i;
+
+        pthread_mutex_lock(&reader->lock);
+        if (reader->npumps + 1 > maxfds)
+        {
+            int     newmax = reader->maxpumps + 1;
+            void   *newfds = realloc(fds, newmax * sizeof(struct pollfd));
+            void   *newpolled;
+
+            if (newfds)
+                fds = (struct pollfd *) newfds;
+            newpolled = newfds ? realloc(polled, newmax * sizeof(PGXCNodeReceivePump *)) : NULL;
+            if (newpolled)
+            {
+                polled = (PGXCNodeReceivePump **) newpolled;
+                maxfds = newmax;
+            }
+        }
+        gen = reader->gen;
+        for (i = 0; i < reader->npumps && nfds < maxfds; i++)
+        {
+            PGXCNodeReceivePump *pump = reader->pumps[i];
+
+            if (pump->eof || pump->err)
+                continue;
+            if (RECEIVE_PUMP_RING_SIZE - (pump->head - pump->tail) < RECEIVE_PUMP_MIN_SPACE)
+            {
+                /* the backend wakes us up when it makes space */
+                pump->full = true;
+                pg_memory_barrier();
+                if (RECEIVE_PUMP_RING_SIZE - (pump->head - pump->tail) < RECEIVE_PUMP_MIN_SPACE)
+                    continue;
+                pump->full = false;
+            }
+            fds[nfds].fd = pump->sock;
+            fds[nfds].events = POLLIN;
+            fds[nfds].revents = 0;
+            polled[nfds++] = pump;
+        }
+        pthread_mutex_unlock(&reader->lock);
+
+        if (fds == NULL)
+        {
+            /* no memory to wait in, try again later */
+            pg_usleep(10000L);
+            continue;
+        }
+        fds[0].fd = reader->wake_fd[0];
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+
+        if (poll(fds, nfds, -1) <= 0)
+            continue;
+
+        if (fds[0].revents)
+            pgxc_node_pipe_drain(reader->wake_fd[0]);
+
+        /* the pumps polled are valid as long as the list did not change */
+        pthread_mutex_lock(&reader->lock);
+        if (gen == reader->gen)
+        {
+            for (i = 1; i < nfds; i++)
+            {
+                if (fds[i].revents)
+                    pgxc_node_pump_fill(polled[i]);
+            }
+        }
+        pthread_mutex_unlock(&reader->lock);
+    }
+
+    return NULL;
+}
+
+/*
+ * Receive into the free space of the ring, called by the reader thread.
+ */
+static void
+pgxc_node_pump_fill(PGXCNodeReceivePump *pump)
+{
+    bool    notify = false;
+
+    for (;;)
+    {
+        uint64  used = pump->head - pump->tail;
+        size_t  pos = (size_t) (pump->head & (RECEIVE_PUMP_RING_SIZE - 1));
+        size_t  space = Min(RECEIVE_PUMP_RING_SIZE - used, RECEIVE_PUMP_RING_SIZE - pos);
+        ssize_t nread;
+
+        if (space == 0)
+            break;
+
+        nread = recv(pump->sock, pump->ring + pos, space, 0);
+        if (nread > 0)
+        {
+            /* the data must be visible before the backend sees the new head */
+            pg_write_barrier();
+            pump->head += nread;
+            notify = true;
+            continue;
+        }
+        if (nread == 0)
+        {
+            pg_write_barrier();
+            pump->eof = true;
+            notify = true;
+        }
+        else if (errno == EINTR)
+            continue;
+        else if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            pg_write_barrier();
+            pump->err = errno;
+            notify = true;
+        }
+        break;
+    }
+
+    if (notify)
+        (void) write(receive_notify_fd[1], "n", 1);
+}
+
+/*
+ * Whether pgxc_node_read_data() gets input or the end of it from the ring.
+ */
+static bool
+pgxc_node_pump_readable(PGXCNodeReceivePump *pump)
+{
+    return pump->eof || pump->err != 0 || pump->head != pump->tail;
+}
+
+/*
+ * recv() from the ring of a handle, the same return values and errno.
+ */
+static int
+pgxc_node_pump_recv(PGXCNodeHandle *conn, char *buf, size_t len)
+{
+    PGXCNodeReceivePump *pump = conn->recv_pump;
+    bool    eof = pump->eof;
+    int     err = pump->err;
+    size_t  avail;
+    size_t  pos;
+    size_t  first;
+
+    /* anything received before the end is visible once the end is */
+    pg_read_barrier();
+    avail = (size_t) (pump->head - pump->tail);
+    if (avail == 0)
+    {
+        if (err)
+        {
+            errno = err;
+            return -1;
+        }
+        if (eof)
+            return 0;
+        errno = EAGAIN;
+        return -1;
+    }
+
+    pg_read_barrier();
+    avail = Min(avail, len);
+    pos = (size_t) (pump->tail & (RECEIVE_PUMP_RING_SIZE - 1));
+    first = Min(avail, RECEIVE_PUMP_RING_SIZE - pos);
+    memcpy(buf, pump->ring + pos, first);
+    memcpy(buf + first, pump->ring, avail - first);
+
+    /* the space is reused once the reader sees the new tail */
+    pg_memory_barrier();
+    pump->tail += avail;
+    pg_memory_barrier();
+    if (pump->full)
+    {
+        pump->full = false;
+        (void) write(receive_readers[pump->reader].wake_fd[1], "w", 1);
+    }
+
+    return (int) avail;
+}
+
+/*
+ * Consume the wake up bytes written to a non-blocking pipe.
+ */
+static void
+pgxc_node_pipe_drain(int fd)
+{
+    char    buf[64];
+
+    while (read(fd, buf, sizeof(buf)) > 0)
+        ;
+}
+
+/*
+ * Hand the output of the handle to a writer thread, so that the backend
+ * goes on producing rows while the data node receives: the output buffer
+ * is moved to the ring by pgxc_node_send_pump_push(), and the backend
+ * waits only once the ring of copy_send_queue_size is full. Output is
+ * kept in order, as the thread sends the ring before any later output.
+ *
+ * Silently does nothing if copy_send_threads is 0 or the writers can not
+ * be set up, the backend sends then.
+ */
+void
+pgxc_node_start_send_pump(PGXCNodeHandle *handle)
+{
+    PGXCNodeSendPump   *pump;
+    PGXCNodeSendWriter *writer;
+    size_t              size = SEND_PUMP_MIN_RING_SIZE;
+    int                 nwriters;
+    int                 i;
+
+    if (handle->send_pump || handle->sock == NO_SOCKET ||
+        CopySendThreads <= 0)
+        return;
+
+    if (!pgxc_node_send_writers_init())
+        return;
+
+    while (size * 2 <= (size_t) CopySendQueueSize * 1024)
+        size *= 2;
+
+    pump = (PGXCNodeSendPump *) malloc(sizeof(PGXCNodeSendPump));
+    if (pump == NULL)
+        return;
+    pump->ring = (char *) malloc(size);
+    if (pump->ring == NULL)
+    {
+        free(pump);
+        return;
+    }
+    pump->sock = handle->sock;
+    pump->size = size;
+    pump->head = 0;
+    pump->tail = 0;
+    pump->err = 0;
+    pump->idle = false;
+    pump->waiting = false;
+
+    /* the least loaded writer */
+    nwriters = Min(CopySendThreads, send_nwriters);
+    pump->writer = 0;
+    for (i = 1; i < nwriters; i++)
+    {
+        if (send_writers[i].npumps < send_writers[pump->writer].npumps)
+            pump->writer = i;
+    }
+    writer = &send_writers[pump->writer];
+
+    pthread_mutex_lock(&writer->lock);
+    if (writer->npumps == writer->maxpumps)
+    {
+        int                newmax = Max(writer->maxpumps * 2, 16);
+        PGXCNodeSendPump **pumps;
+
+        pumps = (PGXCNodeSendPump **) realloc(writer->pumps,
+                                              newmax * sizeof(PGXCNodeSendPump *));
+        if (pumps == NULL)
+        {
+            pthread_mutex_unlock(&writer->lock);
+            free(pump->ring);
+            free(pump);
+            return;
+        }
+        writer->pumps = pumps;
+        writer->maxpumps = newmax;
+    }
+    writer->pumps[writer->npumps++] = pump;
+    writer->gen++;
+    pthread_mutex_unlock(&writer->lock);
+
+    handle->send_pump = pump;
+}
+
+/*
+ * Send the output of a handle in the backend again. Unless discard is set,
+ * waits for the writer to send what is in the ring, so that the output
+ * buffer goes after it. Return EOF if the writer failed to send.
+ */
+int
+pgxc_node_stop_send_pump(PGXCNodeHandle *handle, bool discard)
+{
+    PGXCNodeSendPump   *pump = handle->send_pump;
+    PGXCNodeSendWriter *writer;
+    int                 result = 0;
+    int                 i;
+
+    if (pump == NULL)
+        return 0;
+
+    writer = &send_writers[pump->writer];
+    if (!discard)
+    {
+        while (pump->head != pump->tail && pump->err == 0)
+            pgxc_node_send_pump_wait(pump);
+    }
+
+    pthread_mutex_lock(&writer->lock);
+    for (i = 0; i < writer->npumps; i++)
+    {
+        if (writer->pumps[i] == pump)
+        {
+            writer->pumps[i] = writer->pumps[--writer->npumps];
+            break;
+        }
+    }
+    writer->gen++;
+    pthread_mutex_unlock(&writer->lock);
+    (void) write(writer->wake_fd[1], "w", 1);
+
+    handle->send_pump = NULL;
+
+    if (pump->err && !discard)
+    {
+        errno = pump->err;
+        add_error_message(handle, "failed to send data to datanode");
+        /* the stream is broken, nothing else may follow */
+        handle->outEnd = 0;
+        result = EOF;
+    }
+
+    free(pump->ring);
+    free(pump);
+    return result;
+}
+
+/*
+ * Move the output buffer of the handle to the ring of its writer, waiting
+ * for space as long as the ring is full. Return EOF if the writer failed
+ * to send.
+ */
+int
+pgxc_node_send_pump_push(PGXCNodeHandle *handle)
+{
+    PGXCNodeSendPump *pump = handle->send_pump;
+    char             *data = handle->outBuffer;
+    size_t            len = handle->outEnd;
+
+    while (len > 0)
+    {
+        uint64  used;
+        size_t  pos;
+        size_t  chunk;
+
+        if (pump->err)
+        {
+            errno = pump->err;
+            add_error_message(handle, "failed to send data to datanode");
+            handle->outEnd = 0;
+            return EOF;
+        }
+
+        used = pump->head - pump->tail;
+        if (used == pump->size)
+        {
+            pgxc_node_send_pump_wait(pump);
+            continue;
+        }
+
+        /* the space is free once the writer's tail is seen */
+        pg_read_barrier();
+        pos = (size_t) (pump->head & (pump->size - 1));
+        chunk = Min(len, Min(pump->size - used, pump->size - pos));
+        memcpy(pump->ring + pos, data, chunk);
+
+        /* the data must be visible before the writer sees the new head */
+        pg_write_barrier();
+        pump->head += chunk;
+        data += chunk;
+        len -= chunk;
+
+        pg_memory_barrier();
+        if (pump->idle)
+        {
+            pump->idle = false;
+            (void) write(send_writers[pump->writer].wake_fd[1], "w", 1);
+        }
+    }
+
+    handle->outEnd = 0;
+    return 0;
+}
+
+/*
+ * Wait for the writer to send some of the ring.
+ */
+static void
+pgxc_node_send_pump_wait(PGXCNodeSendPump *pump)
+{
+    struct pollfd pfd;
+    uint64        tail = pump->tail;
+
+    pump->waiting = true;
+    pg_memory_barrier();
+    if (pump->tail == tail && pump->err == 0)
+    {
+        pfd.fd = send_notify_fd[0];
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        /* Use a small timeout of 1s to avoid infinite wait */
+        (void) poll(&pfd, 1, 1000);
+    }
+    pump->waiting = false;
+    pgxc_node_pipe_drain(send_notify_fd[0]);
+}
+
+/*
+ * Create the notification pipe and the writer threads not created yet,
+ * up to copy_send_threads. Return false if there is no writer.
+ */
+static bool
+pgxc_node_send_writers_init(void)
+{
+    int target = Min(CopySendThreads, MAX_COPY_SEND_THREADS);
+
+    if (send_notify_fd[0] < 0)
+    {
+        if (pipe(send_notify_fd) != 0)
+        {
+            elog(LOG, "could not create pipe for send threads: %m");
+            send_notify_fd[0] = send_notify_fd[1] = -1;
+            return false;
+        }
+        fcntl(send_notify_fd[0], F_SETFL, O_NONBLOCK);
+        fcntl(send_notify_fd[1], F_SETFL, O_NONBLOCK);
+        fcntl(send_notify_fd[0], F_SETFD, FD_CLOEXEC);
+        fcntl(send_notify_fd[1], F_SETFD, FD_CLOEXEC);
+    }
+
+    while (send_nwriters < target)
+    {
+        PGXCNodeSendWriter *writer = &send_writers[send_nwriters];
+        int                 ret;
+
+        if (pipe(writer->wake_fd) != 0)
+        {
+            elog(LOG, "could not create pipe for send thread: %m");
+            break;
+        }
+        fcntl(writer->wake_fd[0], F_SETFL, O_NONBLOCK);
+        fcntl(writer->wake_fd[1], F_SETFL, O_NONBLOCK);
+        fcntl(writer->wake_fd[0], F_SETFD, FD_CLOEXEC);
+        fcntl(writer->wake_fd[1], F_SETFD, FD_CLOEXEC);
+        pthread_mutex_init(&writer->lock, NULL);
+        writer->gen = 0;
+        writer->pumps = NULL;
+        writer->npumps = 0;
+        writer->maxpumps = 0;
+
+        ret = CreateThread(pgxc_node_send_writer, (void *) writer, MT_THR_DETACHED);
+        if (ret != 0)
+        {
+            elog(LOG, "could not create send thread: %s", strerror(ret));
+            close(writer->wake_fd[0]);
+            close(writer->wake_fd[1]);
+            pthread_mutex_destroy(&writer->lock);
+            break;
+        }
+        send_nwriters++;
+    }
+
+    return send_nwriters > 0;
+}
+
+/*
+ * Writer thread main loop, lives as long as the backend. Must not palloc,
+ * elog or otherwise touch backend state.
+ */
+static void *
+pgxc_node_send_writer(void *arg)
+{
+    PGXCNodeSendWriter *writer = (PGXCNodeSendWriter *) arg;
+    struct pollfd      *fds = NULL;
+    PGXCNodeSendPump  **polled = NULL;
+    int                 maxfds = 0;
+    sigset_t            mask;
+
+    /* signals are for the backend */
+    sigfillset(&mask);
+    (void) pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+    for (;;)
+    {
+        uint32  gen;
+        int     nfds = 1;
+        int     i;
+
+        pthread_mutex_lock(&writer->lock);
+        if (writer->npumps + 1 > maxfds)
+        {
+            int     newmax = writer->maxpumps + 1;
+            void   *newfds = realloc(fds, newmax * sizeof(struct pollfd));
+            void   *newpolled;
+
+            if (newfds)
+                fds = (struct pollfd *) newfds;
+            newpolled = newfds ? realloc(polled, newmax * sizeof(PGXCNodeSendPump *)) : NULL;
+            if (newpolled)
+            {
+                polled = (PGXCNodeSendPump **) newpolled;
+                maxfds = newmax;
+            }
+        }
+        gen = writer->gen;
+        for (i = 0; i < writer->npumps && nfds < maxfds; i++)
+        {
+            PGXCNodeSendPump *pump = writer->pumps[i];
+
+            if (pump->err)
+                continue;
+            if (pump->head == pump->tail)
+            {
+                /* the backend wakes us up when it adds output */
+                pump->idle = true;
+                pg_memory_barrier();
+                if (pump->head == pump->tail)
+                    continue;
+                pump->idle = false;
+            }
+            fds[nfds].fd = pump->sock;
+            fds[nfds].events = POLLOUT;
+            fds[nfds].revents = 0;
+            polled[nfds++] = pump;
+        }
+        pthread_mutex_unlock(&writer->lock);
+
+        if (fds == NULL)
+        {
+            /* no memory to wait in, try again later */
+            pg_usleep(10000L);
+            continue;
+        }
+        fds[0].fd = writer->wake_fd[0];
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+
+        if (poll(fds, nfds, -1) <= 0)
+            continue;
+
+        if (fds[0].revents)
+            pgxc_node_pipe_drain(writer->wake_fd[0]);
+
+        /* the pumps polled are valid as long as the list did not change */
+        pthread_mutex_lock(&writer->lock);
+        if (gen == writer->gen)
+        {
+            for (i = 1; i < nfds; i++)
+            {
+                if (fds[i].revents)
+                    pgxc_node_pump_drain(polled[i]);
+            }
+        }
+        pthread_mutex_unlock(&writer->lock);
+    }
+
+    return NULL;
+}
+
+/*
+ * Send from the ring what the socket accepts, called by the writer thread.
+ */
+static void
+pgxc_node_pump_drain(PGXCNodeSendPump *pump)
+{
+    bool    notify = false;
+
+    for (;;)
+    {
+        uint64  used = pump->head - pump->tail;
+        size_t  pos = (size_t) (pump->tail & (pump->size - 1));
+        size_t  len = Min(used, pump->size - pos);
+        ssize_t sent;
+
+        if (len == 0)
+            break;
+
+        /* the output is read once the new head is seen */
+        pg_read_barrier();
+        sent = send(pump->sock, pump->ring + pos, len, MSG_DONTWAIT);
+        if (sent > 0)
+        {
+            pg_memory_barrier();
+            pump->tail += sent;
+            notify = true;
+            continue;
+        }
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            pg_write_barrier();
+            pump->err = errno;
+            notify = true;
+        }
+        break;
+    }
 
+    pg_memory_barrier();
+    if (notify && pump->waiting)
+        (void) write(send_notify_fd[1], "n", 1);
+}
 
 void
 pgxc_print_pending_data(PGXCNodeHandle *handle, bool reset)
@@ -1068,6 +2328,7 @@ pgxc_print_pending_data(PGXCNodeHandle *handle, bool reset)
                 break;
             case 'E':            /* ErrorResponse */
                 elog(LOG, "LEFT_OVER ErrorResponse found");
+                pgxc_node_forget_subplans(handle);
                 break;
             case 'A':            /* NotificationResponse */
             case 'N':            /* NoticeResponse */
@@ -1149,6 +2410,11 @@ pgxc_node_is_data_enqueued(PGXCNodeHandle *conn)
     ret = ioctl(conn->sock, FIONREAD, &enqueued);
     if (ret != 0)
         return 0;
+#ifdef __OPENTENBASE__
+    /* or in the ring of a reader thread */
+    if (conn->recv_pump)
+        enqueued += (int) (conn->recv_pump->head - conn->recv_pump->tail);
+#endif
 
     return enqueued;
 }
@@ -1169,6 +2435,13 @@ pgxc_node_read_data(PGXCNodeHandle *conn, bool close_if_error)
         return EOF;
     }
 
+#ifdef __OPENTENBASE__
+    if (batch_send_active)
+    {
+        pgxc_node_batch_send_end();
+    }
+#endif
+
     /* Left-justify any data in the buffer to make room */
     if (conn->inStart < conn->inEnd)
     {
@@ -1212,6 +2485,12 @@ pgxc_node_read_data(PGXCNodeHandle *conn, bool close_if_error)
     }
 
 retry:
+#ifdef __OPENTENBASE__
+    if (conn->recv_pump)
+        nread = pgxc_node_pump_recv(conn, conn->inBuffer + conn->inEnd,
+                                    conn->inSize - conn->inEnd);
+    else
+#endif
     nread = recv(conn->sock, conn->inBuffer + conn->inEnd,
                  conn->inSize - conn->inEnd, 0);
 
@@ -1251,6 +2530,8 @@ retry:
 					"fatal_conn->sock_fatal_occurred=%d, conn->backend_pid=%d, fatal_conn->error=%s", 
 					conn, conn->nodename, conn->sock, conn->read_only, conn->transaction_status,
 					conn->sock_fatal_occurred, conn->backend_pid,  conn->error);
+				pgxc_node_stop_receive_pump(conn);
+				pgxc_node_stop_send_pump(conn, true);
 #endif
                 closesocket(conn->sock);
                 conn->sock = NO_SOCKET;
@@ -1432,6 +2713,12 @@ release_handles(bool force)
             return;
         }
     }
+
+#ifdef __OPENTENBASE__
+    /* a batch interrupted by an error, the handles are going away */
+    batch_send_active = false;
+    batch_send_count = 0;
+#endif
     
     /* Free Datanodes handles */
     for (i = 0; i < NumDataNodes; i++)
@@ -1907,16 +3194,78 @@ ensure_out_buffer_capacity(size_t bytes_needed, PGXCNodeHandle *handle)
 }
 
 
+/*
+ * Handle a failed send() on the connection. Return 1 if the send can be
+ * retried at once, 0 if the socket is not ready for writing and -1 if the
+ * connection is broken, in which case the outgoing buffer is discarded.
+ */
+static int
+send_error(PGXCNodeHandle *handle)
+{
+    /*
+     * Anything except EAGAIN/EWOULDBLOCK/EINTR is trouble. If it's
+     * EPIPE or ECONNRESET, assume we've lost the backend connection
+     * permanently.
+     */
+    switch (errno)
+    {
+#ifdef EAGAIN
+        case EAGAIN:
+            return 0;
+#endif
+#if defined(EWOULDBLOCK) && (!defined(EAGAIN) || (EWOULDBLOCK != EAGAIN))
+        case EWOULDBLOCK:
+            return 0;
+#endif
+        case EINTR:
+            return 1;
+
+        case EPIPE:
+#ifdef ECONNRESET
+        case ECONNRESET:
+#endif
+            add_error_message(handle, "server closed the connection unexpectedly\n"
+            "\tThis probably means the server terminated abnormally\n"
+                      "\tbefore or while processing the request.\n");
+			PGXCNodeSetConnectionState(handle,
+					DN_CONNECTION_STATE_ERROR_FATAL);
+            /*
+             * We used to close the socket here, but that's a bad idea
+             * since there might be unread data waiting (typically, a
+             * NOTICE message from the backend telling us it's
+             * committing hara-kiri...).  Leave the socket open until
+             * pqReadData finds no more data can be read.  But abandon
+             * attempt to send data.
+             */
+            handle->outEnd = 0;
+            return -1;
+
+        default:
+            add_error_message(handle, "could not send data to server");
+            /* We don't assume it's a fatal error... */
+            handle->outEnd = 0;
+            return -1;
+    }
+}
+
 /*
  * Send specified amount of data from the outgoing buffer over the connection
  */
 int
 send_some(PGXCNodeHandle *handle, int len)
 {// #lizard forgives
-    char       *ptr = handle->outBuffer;
-    int            remaining = handle->outEnd;
+    char       *ptr;
+    int            remaining;
     int            result = 0;
 
+#ifdef __OPENTENBASE__
+    /* what the writer thread has is sent first */
+    if (handle->send_pump && pgxc_node_stop_send_pump(handle, false) < 0)
+        return -1;
+#endif
+    ptr = handle->outBuffer;
+    remaining = handle->outEnd;
+
     /* while there's still data to send */
     while (len > 0)
     {
@@ -1935,50 +3284,12 @@ send_some(PGXCNodeHandle *handle, int len)
 
         if (sent < 0)
         {
-            /*
-             * Anything except EAGAIN/EWOULDBLOCK/EINTR is trouble. If it's
-             * EPIPE or ECONNRESET, assume we've lost the backend connection
-             * permanently.
-             */
-            switch (errno)
-            {
-#ifdef EAGAIN
-                case EAGAIN:
-                    break;
-#endif
-#if defined(EWOULDBLOCK) && (!defined(EAGAIN) || (EWOULDBLOCK != EAGAIN))
-                case EWOULDBLOCK:
-                    break;
-#endif
-                case EINTR:
-                    continue;
-
-                case EPIPE:
-#ifdef ECONNRESET
-                case ECONNRESET:
-#endif
-                    add_error_message(handle, "server closed the connection unexpectedly\n"
-                    "\tThis probably means the server terminated abnormally\n"
-                              "\tbefore or while processing the request.\n");
-					PGXCNodeSetConnectionState(handle,
-							DN_CONNECTION_STATE_ERROR_FATAL);
-                    /*
-                     * We used to close the socket here, but that's a bad idea
-                     * since there might be unread data waiting (typically, a
-                     * NOTICE message from the backend telling us it's
-                     * committing hara-kiri...).  Leave the socket open until
-                     * pqReadData finds no more data can be read.  But abandon
-                     * attempt to send data.
-                     */
-                    handle->outEnd = 0;
-                    return -1;
+            int res = send_error(handle);
 
-                default:
-                    add_error_message(handle, "could not send data to server");
-                    /* We don't assume it's a fatal error... */
-                    handle->outEnd = 0;
-                    return -1;
-            }
+            if (res < 0)
+                return -1;
+            if (res > 0)
+                continue;
         }
         else
         {
@@ -2158,7 +3469,8 @@ pgxc_node_send_parse(PGXCNodeHandle * handle, const char* statement,
 int
 pgxc_node_send_plan(PGXCNodeHandle * handle, const char *statement,
                     const char *query, const char *planstr,
-					short num_params, Oid *param_types, int instrument_options)
+					short num_params, Oid *param_types, int instrument_options,
+					uint64 plan_key)
 {
     int            stmtLen;
     int            queryLen;
@@ -2168,16 +3480,41 @@ pgxc_node_send_plan(PGXCNodeHandle * handle, const char *statement,
     char      **paramTypes = (char **)palloc(sizeof(char *) * num_params);
     int            i;
     short        tmp_num_params;
+    short        slot = -1;
+    uint32        n32;
 
     /* Invalid connection state, return error */
     if (handle->state != DN_CONNECTION_STATE_IDLE)
         return EOF;
 
+    /*
+     * If the remote session already stores the fragment send the key only,
+     * otherwise ask it to store the fragment in the slot replaced next.
+     */
+    if (plan_key != 0)
+    {
+        for (i = 0; i < SUBPLAN_CACHE_SLOTS; i++)
+        {
+            if (handle->subplan_keys[i] == plan_key)
+            {
+                slot = i;
+                planstr = "";
+                break;
+            }
+        }
+        if (slot < 0)
+        {
+            slot = handle->subplan_next;
+            handle->subplan_keys[slot] = plan_key;
+            handle->subplan_next = (slot + 1) % SUBPLAN_CACHE_SLOTS;
+        }
+    }
+
     /* statement name size (do not allow NULL) */
     stmtLen = strlen(statement) + 1;
     /* source query size (do not allow NULL) */
     queryLen = strlen(query) + 1;
-    /* query plan size (do not allow NULL) */
+    /* query plan size (do not allow NULL), empty if remote has it cached */
     planLen = strlen(planstr) + 1;
     /* 2 bytes for number of parameters, preceding the type names */
     paramTypeLen = 2;
@@ -2187,8 +3524,13 @@ pgxc_node_send_plan(PGXCNodeHandle * handle, const char *statement,
         paramTypes[i] = format_type_be(param_types[i]);
         paramTypeLen += strlen(paramTypes[i]) + 1;
     }
-	/* size + pnameLen + queryLen + parameters + instrument_options */
+	/*
+	 * size + pnameLen + queryLen + parameters + instrument_options, and
+	 * cache slot + plan key if the fragment is cached
+	 */
 	msgLen = 4 + queryLen + stmtLen + planLen + paramTypeLen + 4;
+	if (plan_key != 0)
+		msgLen += 2 + 8;
 
     /* msgType + msgLen */
     if (ensure_out_buffer_capacity(handle->outEnd + 1 + msgLen, handle) != 0)
@@ -2232,6 +3574,26 @@ pgxc_node_send_plan(PGXCNodeHandle * handle, const char *statement,
 	instrument_options = htonl(instrument_options);
 	memcpy(handle->outBuffer + handle->outEnd, &instrument_options, 4);
 	handle->outEnd += 4;
+	if (plan_key != 0)
+	{
+		/* cache slot */
+		slot = htons(slot);
+		memcpy(handle->outBuffer + handle->outEnd, &slot, 2);
+		handle->outEnd += 2;
+		/* plan key, high half first */
+		n32 = htonl((uint32) (plan_key >> 32));
+		memcpy(handle->outBuffer + handle->outEnd, &n32, 4);
+		handle->outEnd += 4;
+		n32 = htonl((uint32) plan_key);
+		memcpy(handle->outBuffer + handle->outEnd, &n32, 4);
+		handle->outEnd += 4;
+	}
+
+	/* measured until the portal is bound and its rows are received */
+	handle->fragment_sent = GetCurrentTimestamp();
+	handle->fragment_rows_start = 0;
+	handle->fragment_bytes = 0;
+	handle->fragment_measured = true;
 
     handle->last_command = 'a';
 
@@ -2239,13 +3601,26 @@ pgxc_node_send_plan(PGXCNodeHandle * handle, const char *statement,
      return 0;
 }
 
+/*
+ * Forget the fragments the remote session was asked to store.  Used when the
+ * handle is attached to another session, and when the remote session may
+ * have skipped some of our PLAN messages because of an error.
+ */
+void
+pgxc_node_forget_subplans(PGXCNodeHandle *handle)
+{
+    MemSet(handle->subplan_keys, 0, sizeof(handle->subplan_keys));
+    handle->subplan_next = 0;
+}
+
 /*
  * Send BIND message down to the Datanode
  */
 int
 pgxc_node_send_bind(PGXCNodeHandle * handle, const char *portal,
 					const char *statement, int paramlen, const char *params,
-					int epqctxlen, const char *epqctx, StringInfo shardmap)
+					int epqctxlen, const char *epqctx, StringInfo shardmap,
+					char adaptive, int adaptive_rows)
 {
     int            pnameLen;
     int            stmtLen;
@@ -2274,9 +3649,9 @@ pgxc_node_send_bind(PGXCNodeHandle * handle, const char *portal,
 	epqCtxLen = epqctxlen ? epqctxlen : 2;
 	/* size of shard map information */
 	shardMapLen = shardmap ? shardmap->len + 1 : 1;
-	/* size + pnameLen + stmtLen + parameters + epqctx + shardmap */
+	/* size + pnameLen + stmtLen + parameters + epqctx + shardmap + adaptive */
 	msgLen = 4 + pnameLen + stmtLen + paramCodeLen + paramValueLen +
-	         paramOutLen + epqCtxLen + shardMapLen;
+	         paramOutLen + epqCtxLen + shardMapLen + 5;
 
     /* msgType + msgLen */
     if (ensure_out_buffer_capacity(handle->outEnd + 1 + msgLen, handle) != 0)
@@ -2344,6 +3719,12 @@ pgxc_node_send_bind(PGXCNodeHandle * handle, const char *portal,
 	else
 		handle->outBuffer[handle->outEnd++] = '\0';
 
+	/* exchange chosen for the producers at run time, see ExecRemoteSubplan */
+	handle->outBuffer[handle->outEnd++] = adaptive;
+	adaptive_rows = htonl(adaptive_rows);
+	memcpy(handle->outBuffer + handle->outEnd, &adaptive_rows, 4);
+	handle->outEnd += 4;
+
     handle->in_extended_query = true;
      return 0;
 }
@@ -2623,10 +4004,11 @@ pgxc_node_send_apply(PGXCNodeHandle * handle, char * buf, int len, bool ignore_p
 #endif
 
 /*
- * Send series of Extended Query protocol messages to the data node
+ * Put series of Extended Query protocol messages into the outgoing buffer,
+ * up to the sync message
  */
-int
-pgxc_node_send_query_extended(PGXCNodeHandle *handle, const char *query,
+static int
+pgxc_node_build_query_extended(PGXCNodeHandle *handle, const char *query,
                               const char *statement, const char *portal,
                               int num_params, Oid *param_types,
                               int paramlen, char *params,
@@ -2636,7 +4018,8 @@ pgxc_node_send_query_extended(PGXCNodeHandle *handle, const char *query,
     if (query)
         if (pgxc_node_send_parse(handle, statement, query, num_params, param_types))
             return EOF;
-	if (pgxc_node_send_bind(handle, portal, statement, paramlen, params, 0, NULL, NULL))
+	if (pgxc_node_send_bind(handle, portal, statement, paramlen, params, 0, NULL, NULL,
+							SQ_ADAPTIVE_NONE, 0))
         return EOF;
     if (send_describe)
         if (pgxc_node_send_describe(handle, false, portal))
@@ -2644,12 +4027,252 @@ pgxc_node_send_query_extended(PGXCNodeHandle *handle, const char *query,
     if (fetch_size >= 0)
         if (pgxc_node_send_execute(handle, portal, fetch_size))
             return EOF;
+
+    return 0;
+}
+
+/*
+ * Send series of Extended Query protocol messages to the data node
+ */
+int
+pgxc_node_send_query_extended(PGXCNodeHandle *handle, const char *query,
+                              const char *statement, const char *portal,
+                              int num_params, Oid *param_types,
+                              int paramlen, char *params,
+                              bool send_describe, int fetch_size)
+{
+    if (pgxc_node_build_query_extended(handle, query, statement, portal,
+                                       num_params, param_types, paramlen, params,
+                                       send_describe, fetch_size))
+        return EOF;
+	if (pgxc_node_send_my_sync(handle))
+        return EOF;
+
+    return 0;
+}
+
+/*
+ * Same as pgxc_node_send_query_extended, but the messages are encoded only
+ * once for all the handles sharing tmpl, and copied into the outgoing buffer
+ * of the other handles. Whether Parse is sent may differ by handle, so tmpl
+ * keeps one encoding with and one without it.
+ */
+int
+pgxc_node_send_query_extended_template(PGXCNodeHandle *handle,
+                              PGXCNodeSendTemplate *tmpl, const char *query,
+                              const char *statement, const char *portal,
+                              int num_params, Oid *param_types,
+                              int paramlen, char *params,
+                              bool send_describe, int fetch_size)
+{
+    int idx = query ? 1 : 0;
+
+    if (NULL == tmpl->data[idx])
+    {
+        size_t start = handle->outEnd;
+
+        if (pgxc_node_build_query_extended(handle, query, statement, portal,
+                                           num_params, param_types, paramlen, params,
+                                           send_describe, fetch_size))
+            return EOF;
+
+        tmpl->len[idx] = handle->outEnd - start;
+        tmpl->data[idx] = (char *) palloc(tmpl->len[idx]);
+        memcpy(tmpl->data[idx], handle->outBuffer + start, tmpl->len[idx]);
+    }
+    else
+    {
+        /* same checks and state changes as the messages built above */
+        if (handle->state != DN_CONNECTION_STATE_IDLE)
+            return EOF;
+
+        if (ensure_out_buffer_capacity(handle->outEnd + tmpl->len[idx], handle) != 0)
+        {
+            add_error_message(handle, "out of memory");
+            return EOF;
+        }
+        memcpy(handle->outBuffer + handle->outEnd, tmpl->data[idx], tmpl->len[idx]);
+        handle->outEnd += tmpl->len[idx];
+
+        if (fetch_size >= 0)
+            PGXCNodeSetConnectionState(handle, DN_CONNECTION_STATE_QUERY);
+        handle->in_extended_query = true;
+    }
+
 	if (pgxc_node_send_my_sync(handle))
         return EOF;
 
     return 0;
 }
 
+void
+pgxc_node_free_send_template(PGXCNodeSendTemplate *tmpl)
+{
+    int i;
+
+    for (i = 0; i < lengthof(tmpl->data); i++)
+    {
+        if (tmpl->data[i])
+        {
+            pfree(tmpl->data[i]);
+            tmpl->data[i] = NULL;
+        }
+    }
+}
+
+/*
+ * Start batching the sends to the nodes. Until pgxc_node_batch_send_end()
+ * pgxc_node_flush() only queues the handle, so that the buffers of a fan-out
+ * are then written out together instead of draining one socket after the
+ * other. Nothing must wait for answers in between, reading from a node ends
+ * the batch.
+ */
+void
+pgxc_node_batch_send_begin(void)
+{
+    Assert(!batch_send_active && batch_send_count == 0);
+    batch_send_active = true;
+}
+
+/*
+ * Write out the buffers of all the handles queued since
+ * pgxc_node_batch_send_begin(). Non-blocking sends are issued to every
+ * socket in turn, and one poll() waits for all those that are not drained
+ * yet. Return EOF if sending to any of the handles failed, the error is
+ * recorded in the handle like pgxc_node_flush() does.
+ */
+int
+pgxc_node_batch_send_end(void)
+{
+    int            result = 0;
+    int            pending;
+    int            i;
+    struct pollfd *pfds = NULL;
+
+    batch_send_active = false;
+    if (batch_send_count == 0)
+        return 0;
+
+    pending = batch_send_count;
+    while (pending > 0)
+    {
+        int npoll = 0;
+
+        for (i = 0; i < batch_send_count; i++)
+        {
+            PGXCNodeHandle *handle = batch_send_handles[i];
+
+            if (NULL == handle)
+                continue;
+
+            if (handle->outEnd && send_nowait(handle) < 0)
+            {
+                elog(LOG, "pgxc_node_batch_send_end data to datanode:%u fd:%d failed for %s",
+                     handle->nodeoid, handle->sock, strerror(errno));
+                add_error_message(handle, "failed to send data to datanode");
+                result = EOF;
+            }
+
+            if (0 == handle->outEnd)
+            {
+                batch_send_handles[i] = NULL;
+                pending--;
+            }
+        }
+
+        if (pending == 0)
+            break;
+
+        /* wait for any of the sockets to accept more data */
+        if (NULL == pfds)
+            pfds = (struct pollfd *) palloc(batch_send_count * sizeof(struct pollfd));
+        for (i = 0; i < batch_send_count; i++)
+        {
+            if (batch_send_handles[i])
+            {
+                pfds[npoll].fd = batch_send_handles[i]->sock;
+                pfds[npoll].events = POLLOUT;
+                pfds[npoll].revents = 0;
+                npoll++;
+            }
+        }
+
+        /* Use a small timeout of 1s to avoid infinite wait */
+        if (poll(pfds, npoll, 1000) < 0 && errno != EAGAIN && errno != EINTR)
+        {
+            for (i = 0; i < batch_send_count; i++)
+            {
+                if (batch_send_handles[i])
+                {
+                    add_error_message(batch_send_handles[i], "poll failed ");
+                    batch_send_handles[i]->outEnd = 0;
+                }
+            }
+            result = EOF;
+            break;
+        }
+    }
+
+    if (pfds)
+        pfree(pfds);
+    batch_send_count = 0;
+
+    return result;
+}
+
+/*
+ * Forget a batch interrupted by an error. Called on (sub)transaction abort,
+ * before anything is sent to the nodes to clean up: the buffers of the
+ * handles queued are still there and are flushed with the next sends.
+ */
+void
+pgxc_node_batch_send_reset(void)
+{
+    batch_send_active = false;
+    batch_send_count = 0;
+}
+
+/*
+ * Send as much of the outgoing buffer as the socket accepts without
+ * blocking. Return -1 if the connection is broken.
+ */
+static int
+send_nowait(PGXCNodeHandle *handle)
+{
+    size_t sent_total = 0;
+
+    /* what the writer thread has is sent first */
+    if (handle->send_pump && pgxc_node_stop_send_pump(handle, false) < 0)
+        return -1;
+
+    while (sent_total < handle->outEnd)
+    {
+        int sent = send(handle->sock, handle->outBuffer + sent_total,
+                        handle->outEnd - sent_total, MSG_DONTWAIT);
+
+        if (sent < 0)
+        {
+            int res = send_error(handle);
+
+            if (res < 0)
+                return -1;
+            if (res == 0)
+                break;
+            continue;
+        }
+        sent_total += sent;
+    }
+
+    /* shift the remaining contents of the buffer */
+    if (sent_total > 0)
+    {
+        if (sent_total < handle->outEnd)
+            memmove(handle->outBuffer, handle->outBuffer + sent_total, handle->outEnd - sent_total);
+        handle->outEnd -= sent_total;
+    }
+    return 0;
+}
+
 
 /*
  * This method won't return until connection buffer is empty or error occurs
@@ -2658,6 +4281,29 @@ pgxc_node_send_query_extended(PGXCNodeHandle *handle, const char *query,
 int
 pgxc_node_flush(PGXCNodeHandle *handle)
 {
+#ifdef __OPENTENBASE__
+    if (batch_send_active && handle->outEnd)
+    {
+        int i;
+
+        for (i = 0; i < batch_send_count; i++)
+        {
+            if (batch_send_handles[i] == handle)
+                return 0;
+        }
+
+        if (batch_send_count == batch_send_size)
+        {
+            batch_send_size = batch_send_size ? batch_send_size * 2 : 64;
+            batch_send_handles = batch_send_handles ?
+                (PGXCNodeHandle **) repalloc(batch_send_handles, batch_send_size * sizeof(PGXCNodeHandle *)) :
+                (PGXCNodeHandle **) MemoryContextAlloc(TopMemoryContext, batch_send_size * sizeof(PGXCNodeHandle *));
+        }
+        batch_send_handles[batch_send_count++] = handle;
+        return 0;
+    }
+#endif
+
     while (handle->outEnd)
     {
         if (send_some(handle, handle->outEnd) < 0)
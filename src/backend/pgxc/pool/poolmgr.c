@@ -48,6 +48,7 @@
 #include "pgxc/poolmgr.h"
 #include "utils/builtins.h"
 #include "utils/guc.h"
+#include "utils/hashutils.h"
 #include "utils/memutils.h"
 #include "utils/lsyscache.h"
 #include "utils/resowner.h"
@@ -59,6 +60,7 @@
 #include "pgxc/pgxc.h"
 #include "pgxc/nodemgr.h"
 #include "pgxc/poolutils.h"
+#include "access/hash.h"
 #include "../interfaces/libpq/libpq-fe.h"
 #include "../interfaces/libpq/libpq-int.h"
 #include "postmaster/postmaster.h"        /* For Unix_socket_directories */
@@ -96,6 +98,9 @@ int         PoolCheckSlotTimeout   = -1;   /* Pooler check slot. One slot can on
 int         PoolPrintStatTimeout   = -1;
     
 bool        PersistentConnections    = false;
+bool        PoolSessionFingerprint   = false;  /* reuse connections by session parameter fingerprint */
+bool        PoolDemandPrediction     = false;  /* grow node pools ahead of their hourly demand peaks */
+int         PoolDemandPrewarmLead    = 15;     /* minutes, how early to grow a pool before a predicted peak */
 char        *g_PoolerWarmBufferInfo  = "postgres:postgres";
 
 char        *g_unpooled_database     = "template1";
@@ -139,6 +144,7 @@ typedef struct PoolerStatistics
     int32 acquire_conn_from_hashtab;    /* immediate get conn from hashtab */
     int32 acquire_conn_from_hashtab_and_set; /* get conn from hashtab, but need to set by sync thread */
     int32 acquire_conn_from_thread;        /* can't get conn from hashtab, need to conn by sync thread */
+    int32 acquire_conn_fingerprint_hit;    /* get conn from hashtab whose session fingerprint matches, no set needed */
     unsigned long acquire_conn_time;    /* time cost for all conn process by sync thread */
 }PoolerStatistics;
 
@@ -166,7 +172,9 @@ unsigned char g_pooler_cmd[POOLER_CMD_COUNT] =
     't',                    /* Close pooler connections*/
     'x',                    /* Get command statistics */
     'y',                    /* Reset command statistics */
-    'z'                     /* Get connection statistics */
+    'z',                    /* Get connection statistics */
+    'D',                    /* Get demand statistics */
+    'T'                     /* Get node pool telemetry */
 };
 
 /* a map used to change msgtype to id */
@@ -216,6 +224,8 @@ typedef struct
     int32             size;        /* total pool size */
     int32               validSize;  /* valid data element number */    
     bool              failed;
+    struct  timeval   start_time; /* when the build is dispatched */
+    struct  timeval   end_time;   /* when the build is done */
     PGXCNodePoolSlot  slot[1];    /* var length array */
 } PGXCPoolConnectReq;
 
@@ -267,9 +277,24 @@ typedef struct PoolerSetDesc
 {
     int   tag_len;
     int   total_len;
+    uint32 hash;       /* hash of command, used to build session fingerprint */
     char  *command;    
 }PoolerSetDesc;
 
+/* reset all the session parameters of a pooled connection */
+#define POOL_SESSION_RESET_COMMAND "SET SESSION AUTHORIZATION DEFAULT;RESET ALL;"
+
+/* a fingerprint is never 0, 0 is reserved for connections with no SET applied */
+#define POOL_SESSION_HASH_COMBINE(hash, cmdhash) \
+    (hash_combine((hash), (cmdhash)) ? hash_combine((hash), (cmdhash)) : 1)
+
+/* weight of the latest observed peak when folded into the hourly demand profile */
+#define POOL_DEMAND_DECAY 0.3
+
+/* whether the session state of slot is the one agent expects, ncmd < 0 means unknown state */
+#define POOL_SESSION_MATCHED(agent, slot) \
+    ((slot)->session_ncmd >= 0 && (slot)->session_hash == (agent)->session_hash)
+
 /* The root memory context */
 static MemoryContext PoolerMemoryContext = NULL;
 /*
@@ -504,6 +529,9 @@ static int  agent_set_command(PoolAgent *agent,
 static int  agent_temp_command(PoolAgent *agent);
 static PoolerSetDesc *agent_compress_command(char *set_command, PoolerSetDesc *set_desc, bool *need_free,int *len);
 static void agent_handle_set_command(PoolAgent *agent, char *set_command, PoolCommandType command_type);
+static uint32 agent_session_fingerprint(List *guc_list);
+static char *pooler_build_session_command(PoolAgent *agent, PGXCNodePoolSlot *slot);
+static void  pooler_mark_session_applied(PoolAgent *agent, PGXCNodePoolSlot *slot);
 
 static DatabasePool *create_database_pool(const char *database, const char *user_name, const char *pgoptions);
 static void insert_database_pool(DatabasePool *pool);
@@ -515,7 +543,8 @@ static int agent_acquire_connections(PoolAgent *agent, List *datanodelist, List
 									 bool raise_error, int32 *num, int **fd_result, int **pid_result);
 static int send_local_commands(PoolAgent *agent, List *datanodelist, List *coordlist);
 static int cancel_query_on_connections(PoolAgent *agent, List *datanodelist, List *coordlist, int signal);
-static PGXCNodePoolSlot *acquire_connection(DatabasePool *dbPool, PGXCNodePool **pool,int32 nodeidx, Oid node, bool bCoord);
+static PGXCNodePoolSlot *acquire_connection(DatabasePool *dbPool, PGXCNodePool **pool,int32 nodeidx, Oid node, bool bCoord,
+											uint32 session_hash);
 static void agent_release_connections(PoolAgent *agent, bool force_destroy, bool sync);
 static void agent_return_connections(PoolAgent *agent);
 
@@ -528,6 +557,13 @@ static void destroy_slot_ex(int32 nodeidx, Oid node, PGXCNodePoolSlot *slot, boo
 static void close_slot(int32 nodeidx, Oid node, PGXCNodePoolSlot *slot);
 
 static PGXCNodePool *grow_pool(DatabasePool *dbPool, int32 nodeidx, Oid node, bool bCoord);
+static void pool_demand_init(PGXCNodePool *nodePool);
+static void pool_demand_record(PGXCNodePool *nodePool, time_t now);
+static int32 pool_demand_predict(PGXCNodePool *nodePool, time_t now);
+static void pool_demand_prewarm(DatabasePool *dbPool, PGXCNodePool *nodePool, int32 nodeidx, int32 predicted);
+static int  pool_telemetry_bucket(uint64 value, int nbuckets);
+static void pool_record_latency(PGXCNodePool *nodePool, PoolLatencyKind kind, struct timeval *start_time, struct timeval *end_time);
+static void pool_record_build_fail(PGXCNodePool *nodePool, PoolBuildFailCause cause);
 static void destroy_node_pool(PGXCNodePool *node_pool);
 static void destroy_node_pool_free_slots(PGXCNodePool *node_pool);
 
@@ -619,6 +655,8 @@ static void reset_pooler_cmd_statistics(void);
 static void update_pooler_cmd_statistics(unsigned char qtype, uint64 costtime);
 static void handle_get_cmd_statistics(PoolAgent *agent);
 static void handle_get_conn_statistics(PoolAgent *agent);
+static void handle_get_demand_statistics(PoolAgent *agent);
+static void handle_get_node_telemetry(PoolAgent *agent);
 
 #define IncreaseSlotRefCount(slot,filename,linenumber)\
 do\
@@ -1067,6 +1105,7 @@ agent_create(int new_fd)
     agent->coord_connections = NULL;
     agent->session_params = NULL;
     agent->local_params = NULL;
+    agent->session_hash = 0;
     agent->is_temp = false;
     agent->pid = 0;
     agent->agentindex = agentindex;
@@ -1610,6 +1649,74 @@ PoolManagerGetConnStatistics(StringInfo s)
     return 0;
 }
 
+/*
+ * get latency histograms, build failures and slot ages of node pools
+ */
+int
+PoolManagerGetNodeTelemetry(StringInfo s)
+{
+    int qtype = 0;
+    char msgtype = 'T';
+    HOLD_POOLER_RELOAD();
+
+    if (poolHandle == NULL)
+    {
+        ConnectPoolManager();
+    }
+
+    /* Message type */
+    pool_putbytes(&poolHandle->port, &msgtype, 1);
+    pool_flush(&poolHandle->port);
+
+    qtype = pool_getbyte(&poolHandle->port);
+    if (qtype == EOF || (unsigned char)qtype != msgtype)
+    {
+        elog(ERROR, POOL_MGR_PREFIX"get node telemetry error, qtype:%d", qtype);
+        RESUME_POOLER_RELOAD();
+        return -1;
+    }
+
+    /* get all the messages left */
+    pool_getmessage(&poolHandle->port, s, 0);
+
+    RESUME_POOLER_RELOAD();
+    return 0;
+}
+
+/*
+ * get pooler demand statistics of node pools
+ */
+int
+PoolManagerGetDemandStatistics(StringInfo s)
+{
+    int qtype = 0;
+    char msgtype = 'D';
+    HOLD_POOLER_RELOAD();
+
+    if (poolHandle == NULL)
+    {
+        ConnectPoolManager();
+    }
+
+    /* Message type */
+    pool_putbytes(&poolHandle->port, &msgtype, 1);
+    pool_flush(&poolHandle->port);
+
+    qtype = pool_getbyte(&poolHandle->port);
+    if (qtype == EOF || (unsigned char)qtype != msgtype)
+    {
+        elog(ERROR, POOL_MGR_PREFIX"get demand statistics error, qtype:%d", qtype);
+        RESUME_POOLER_RELOAD();
+        return -1;
+    }
+
+    /* get all the messages left */
+    pool_getmessage(&poolHandle->port, s, 0);
+
+    RESUME_POOLER_RELOAD();
+    return 0;
+}
+
 /*
  * Init PoolAgent
  */
@@ -2296,6 +2403,14 @@ agent_handle_input(PoolAgent * agent, StringInfo s)
                 handle_get_conn_statistics(agent);
                 break;
 
+            case 'D':          /* get demand statistics */
+                handle_get_demand_statistics(agent);
+                break;
+
+            case 'T':          /* get node pool telemetry */
+                handle_get_node_telemetry(agent);
+                break;
+
             case EOF:            /* EOF */
                 agent_destroy(agent);
                 return;    
@@ -2627,6 +2742,8 @@ RECHECK:
                 oldcontext          = MemoryContextSwitchTo(agent->mcxt);
                 guc_desc->command   = pstrdup(guc_pointer[i].command);
                 guc_desc->total_len = guc_pointer[i].total_len;
+                guc_desc->hash      = DatumGetUInt32(hash_any((unsigned char *) guc_desc->command,
+                                                              guc_desc->total_len));
                 guc_list            = lappend(guc_list, guc_desc);
                 MemoryContextSwitchTo(oldcontext);
                 need_reform =  true;
@@ -2641,6 +2758,8 @@ RECHECK:
             new_item->tag_len = guc_pointer[i].tag_len;
             new_item->total_len = guc_pointer[i].total_len;
             new_item->command = pstrdup(guc_pointer[i].command);
+            new_item->hash = DatumGetUInt32(hash_any((unsigned char *) new_item->command,
+                                                     new_item->total_len));
             guc_list = lappend(guc_list, new_item);
             MemoryContextSwitchTo(oldcontext);
             need_reform =  true;
@@ -2678,6 +2797,7 @@ RECHECK:
                 pfree(agent->session_params);
             }
             agent->session_params = guc_str;
+            agent->session_hash   = agent_session_fingerprint(guc_list);
         }
         else if (POOL_CMD_LOCAL_SET == command_type)
         {
@@ -2704,6 +2824,126 @@ RECHECK:
 }
     
 
+/*
+ * Compute the fingerprint of a session parameter list. The fingerprint
+ * depends on the order of the commands, as replaying them in another order
+ * may not end up in the same session state.
+ */
+static uint32
+agent_session_fingerprint(List *guc_list)
+{
+    uint32         hash = 0;
+    ListCell      *guc_list_item = NULL;
+    PoolerSetDesc *guc_desc = NULL;
+
+    foreach(guc_list_item, guc_list)
+    {
+        guc_desc = (PoolerSetDesc*)lfirst(guc_list_item);
+        hash = POOL_SESSION_HASH_COMBINE(hash, guc_desc->hash);
+    }
+    return hash;
+}
+
+/*
+ * Build the command needed to bring the session state of slot to the one of
+ * agent. If the commands already applied on the slot are a prefix of the
+ * agent session parameters, only the remaining ones are replayed, otherwise
+ * the slot is reset first and all the parameters are replayed.
+ * Returns NULL if nothing needs to be sent, or if out of memory.
+ *
+ * Called by the sync network threads, so the result is malloced and has to
+ * be freed by the caller with free().
+ */
+static char *
+pooler_build_session_command(PoolAgent *agent, PGXCNodePoolSlot *slot)
+{
+    int32          ncmd      = 0;
+    int32          total_len = 0;
+    int32          offset    = 0;
+    uint32         hash      = 0;
+    bool           need_reset = false;
+    char          *command   = NULL;
+    ListCell      *guc_list_item = NULL;
+    ListCell      *start_item    = NULL;
+    PoolerSetDesc *guc_desc  = NULL;
+
+    if (POOL_SESSION_MATCHED(agent, slot))
+    {
+        return NULL;
+    }
+
+    /* find out whether the slot state is a prefix of the agent state */
+    need_reset = (slot->session_hash != 0 || slot->session_ncmd != 0);
+    if (need_reset && slot->session_ncmd > 0 &&
+        slot->session_ncmd < list_length(agent->session_params_list))
+    {
+        foreach(guc_list_item, agent->session_params_list)
+        {
+            guc_desc = (PoolerSetDesc*)lfirst(guc_list_item);
+            hash = POOL_SESSION_HASH_COMBINE(hash, guc_desc->hash);
+            ncmd++;
+            if (ncmd == slot->session_ncmd)
+            {
+                if (hash == slot->session_hash)
+                {
+                    need_reset = false;
+                    start_item = lnext(guc_list_item);
+                }
+                break;
+            }
+        }
+    }
+    else if (!need_reset)
+    {
+        start_item = list_head(agent->session_params_list);
+    }
+
+    if (need_reset)
+    {
+        start_item = list_head(agent->session_params_list);
+        total_len += strlen(POOL_SESSION_RESET_COMMAND);
+    }
+
+    for (guc_list_item = start_item; guc_list_item != NULL; guc_list_item = lnext(guc_list_item))
+    {
+        guc_desc = (PoolerSetDesc*)lfirst(guc_list_item);
+        total_len += guc_desc->total_len + 1; /* ";" */
+    }
+
+    if (0 == total_len)
+    {
+        return NULL;
+    }
+
+    command = (char *) malloc(total_len + 1);
+    if (NULL == command)
+    {
+        return NULL;
+    }
+
+    if (need_reset)
+    {
+        offset += snprintf(command + offset, total_len + 1 - offset, "%s", POOL_SESSION_RESET_COMMAND);
+    }
+    for (guc_list_item = start_item; guc_list_item != NULL; guc_list_item = lnext(guc_list_item))
+    {
+        guc_desc = (PoolerSetDesc*)lfirst(guc_list_item);
+        offset += snprintf(command + offset, total_len + 1 - offset, "%s;", guc_desc->command);
+    }
+    return command;
+}
+
+/*
+ * Tag slot with the session fingerprint of agent, called once the session
+ * parameters of agent have been applied on the connection.
+ */
+static void
+pooler_mark_session_applied(PoolAgent *agent, PGXCNodePoolSlot *slot)
+{
+    slot->session_hash = agent->session_hash;
+    slot->session_ncmd = agent->session_hash ? list_length(agent->session_params_list) : 0;
+}
+
 /*
  * Save a SET command and distribute it to the agent connections
  * already in use. Return the number of set command that have been sent out.
@@ -2777,6 +3017,7 @@ agent_set_command(PoolAgent *agent,
                     asyncTaskCtl = create_task_control(NULL, NULL, NULL, NULL);
                     oldcontext = MemoryContextSwitchTo(agent->mcxt);
                     asyncTaskCtl->m_command = pstrdup(set_command);
+                    asyncTaskCtl->m_command_type = command_type;
                     MemoryContextSwitchTo(oldcontext);
                 }                
                 
@@ -2809,6 +3050,7 @@ agent_set_command(PoolAgent *agent,
                     asyncTaskCtl = create_task_control(NULL, NULL, NULL, NULL);
                     oldcontext = MemoryContextSwitchTo(agent->mcxt);
                     asyncTaskCtl->m_command = pstrdup(set_command);
+                    asyncTaskCtl->m_command_type = command_type;
                     MemoryContextSwitchTo(oldcontext);
                 }                
                 
@@ -3117,7 +3359,7 @@ agent_acquire_connections(PoolAgent *agent, List *datanodelist, List *coordlist,
         if (NULL == agent->dn_connections[node])
         {
             slot = acquire_connection(agent->pool, &nodePool, node,
-                                      agent->dn_conn_oids[node], false);
+                                      agent->dn_conn_oids[node], false, agent->session_hash);
 
             /* Handle failure */
             if (slot == NULL)
@@ -3201,7 +3443,7 @@ agent_acquire_connections(PoolAgent *agent, List *datanodelist, List *coordlist,
                 /* Store in the descriptor */
                 slot->pid = agent->pid;
                 agent->dn_connections[node] = slot;
-                if (agent->session_params)
+                if (!POOL_SESSION_MATCHED(agent, slot))
                 {                    
                     if (agent->task_control)
                     {
@@ -3242,6 +3484,10 @@ agent_acquire_connections(PoolAgent *agent, List *datanodelist, List *coordlist,
                     if (PoolPrintStatTimeout > 0)
                     {
                         g_pooler_stat.acquire_conn_from_hashtab++;
+                        if (agent->session_hash)
+                        {
+                            g_pooler_stat.acquire_conn_fingerprint_hit++;
+                        }
                     }
                 }
             }            
@@ -3272,7 +3518,8 @@ agent_acquire_connections(PoolAgent *agent, List *datanodelist, List *coordlist,
         /* Acquire from the pool if none */
         if (NULL == agent->coord_connections[node])
         {
-            PGXCNodePoolSlot *slot = acquire_connection(agent->pool, &nodePool, node, agent->coord_conn_oids[node], true);
+            PGXCNodePoolSlot *slot = acquire_connection(agent->pool, &nodePool, node, agent->coord_conn_oids[node], true,
+                                                        agent->session_hash);
 
             /* Handle failure */
             if (slot == NULL)
@@ -3337,7 +3584,7 @@ agent_acquire_connections(PoolAgent *agent, List *datanodelist, List *coordlist,
                 */
                 slot->pid = agent->pid;
                 agent->coord_connections[node] = slot;
-                if (agent->session_params)
+                if (!POOL_SESSION_MATCHED(agent, slot))
                 {
                     set_request_num++;
                     /* we have task control pending, can not proceed, wait for the pending job done */
@@ -3379,6 +3626,10 @@ agent_acquire_connections(PoolAgent *agent, List *datanodelist, List *coordlist,
                     if (PoolPrintStatTimeout > 0)
                     {
                         g_pooler_stat.acquire_conn_from_hashtab++;
+                        if (agent->session_hash)
+                        {
+                            g_pooler_stat.acquire_conn_fingerprint_hit++;
+                        }
                     }
                 }
             }
@@ -3999,7 +4250,7 @@ agent_release_connections(PoolAgent *agent, bool force_destroy, bool sync)
         agent->local_params = NULL;
     }
 
-    if (((agent->session_params) || agent->is_temp) && !force_destroy)
+    if (((agent->session_params && !PoolSessionFingerprint) || agent->is_temp) && !force_destroy)
     {
         if (PoolConnectDebugPrint)
         {
@@ -4584,15 +4835,20 @@ find_database_pool(const char *database, const char *user_name, const char *pgop
  * Acquire connection
  */
 static PGXCNodePoolSlot *
-acquire_connection(DatabasePool *dbPool, PGXCNodePool **pool,int32 nodeidx, Oid node, bool bCoord)
+acquire_connection(DatabasePool *dbPool, PGXCNodePool **pool,int32 nodeidx, Oid node, bool bCoord,
+				   uint32 session_hash)
 {// #lizard forgives
     int32              fd;
     int32              loop = 0;
     PGXCNodePool       *nodePool;
     PGXCNodePoolSlot   *slot;
+    struct timeval     start_time;
+    struct timeval     end_time;
 
     Assert(dbPool);
 
+    gettimeofday(&start_time, NULL);
+
     nodePool = (PGXCNodePool *) hash_search(dbPool->nodePools, &node, HASH_FIND,
                                             NULL);
 
@@ -4630,6 +4886,30 @@ acquire_connection(DatabasePool *dbPool, PGXCNodePool **pool,int32 nodeidx, Oid
         int            poll_result;
 
         loop++;
+
+        /*
+         * Prefer a free connection whose session fingerprint matches, so that
+         * no SET command needs to be replayed on it. Move it to the top of
+         * the free slots.
+         */
+        if (PoolSessionFingerprint &&
+            nodePool->slot[nodePool->freeSize - 1]->session_hash != session_hash)
+        {
+            int32 i;
+
+            for (i = nodePool->freeSize - 2; i >= 0; i--)
+            {
+                if (nodePool->slot[i]->session_hash == session_hash &&
+                    nodePool->slot[i]->session_ncmd >= 0)
+                {
+                    slot = nodePool->slot[i];
+                    nodePool->slot[i] = nodePool->slot[nodePool->freeSize - 1];
+                    nodePool->slot[nodePool->freeSize - 1] = slot;
+                    break;
+                }
+            }
+        }
+
         DecreasePoolerFreesize(nodePool,__FILE__,__LINE__);
         slot = nodePool->slot[nodePool->freeSize];
         nodePool->slot[nodePool->freeSize] = NULL;
@@ -4714,6 +4994,10 @@ retry:
     if (slot)
     {
         PgxcNodeUpdateHealth(node, true);
+        pool_demand_record(nodePool, time(NULL));
+
+        gettimeofday(&end_time, NULL);
+        pool_record_latency(nodePool, PoolLatencyHit, &start_time, &end_time);
     }
     
     /* prebuild connection before next acquire */
@@ -4985,6 +5269,8 @@ grow_pool(DatabasePool *dbPool, int32 nodeidx, Oid node, bool bCoord)
         nodePool->coord      = bCoord;        
         nodePool->nwarming   = 0;
         nodePool->nquery     = 0;
+        pool_demand_init(nodePool);
+        MemSet(&nodePool->telemetry, 0, sizeof(PoolNodeTelemetry));
 
         name_str = get_node_name_by_nodeoid(node);
         if (NULL == name_str)
@@ -5041,6 +5327,156 @@ grow_pool(DatabasePool *dbPool, int32 nodeidx, Oid node, bool bCoord)
 }
 
 
+/*
+ * Reset the demand history of a newly created node pool.
+ */
+static void
+pool_demand_init(PGXCNodePool *nodePool)
+{
+    int i;
+
+    for (i = 0; i < POOL_DEMAND_HOURS; i++)
+    {
+        nodePool->demand_profile[i] = 0;
+    }
+    nodePool->demand_hour = -1;
+    nodePool->demand_peak = 0;
+}
+
+static int
+pool_demand_hour_of(time_t t)
+{
+    pg_time_t stamp_time = (pg_time_t) t;
+
+    return pg_localtime(&stamp_time, log_timezone)->tm_hour;
+}
+
+/*
+ * Track the peak number of connections in use during the current hour. When
+ * the hour changes, the peak is folded into the demand profile of the hour
+ * that just ended with an exponential moving average.
+ */
+static void
+pool_demand_record(PGXCNodePool *nodePool, time_t now)
+{
+    int hour   = pool_demand_hour_of(now);
+    int in_use = nodePool->size - nodePool->freeSize;
+
+    if (nodePool->demand_hour != hour)
+    {
+        if (nodePool->demand_hour >= 0)
+        {
+            float *profile = &nodePool->demand_profile[nodePool->demand_hour];
+
+            *profile = POOL_DEMAND_DECAY * nodePool->demand_peak + (1 - POOL_DEMAND_DECAY) * (*profile);
+        }
+        nodePool->demand_hour = hour;
+        nodePool->demand_peak = 0;
+    }
+
+    if (in_use > nodePool->demand_peak)
+    {
+        nodePool->demand_peak = in_use;
+    }
+}
+
+/*
+ * Predict how many connections the node pool will need in the next
+ * PoolDemandPrewarmLead minutes, based on the demand profile.
+ */
+static int32
+pool_demand_predict(PGXCNodePool *nodePool, time_t now)
+{
+    float current = nodePool->demand_profile[pool_demand_hour_of(now)];
+    float ahead   = nodePool->demand_profile[pool_demand_hour_of(now + PoolDemandPrewarmLead * 60)];
+
+    return (int32) ceil(Max(current, ahead));
+}
+
+/*
+ * Grow the node pool towards the predicted demand before the connections are
+ * actually asked for, at most MinFreeSize connections at a time.
+ */
+static void
+pool_demand_prewarm(DatabasePool *dbPool, PGXCNodePool *nodePool, int32 nodeidx, int32 predicted)
+{
+    int32 size;
+
+    if (!dbPool->bneed_pool || nodePool->asyncInProgress)
+    {
+        return;
+    }
+
+    predicted = Min(predicted, MaxPoolSize);
+    if (nodePool->size >= predicted)
+    {
+        return;
+    }
+
+    size = Min(predicted - nodePool->size, Max(MinFreeSize, 1));
+    if (PoolConnectDebugPrint)
+    {
+        elog(LOG, POOL_MGR_PREFIX"prewarm %d connections to node:%s, predicted:%d size:%d freeSize:%d",
+             size, nodePool->node_name, predicted, nodePool->size, nodePool->freeSize);
+    }
+
+    if (pooler_async_build_connection(dbPool, nodePool->m_version, nodeidx, nodePool->nodeoid,
+                                      size, nodePool->connstr, nodePool->coord))
+    {
+        nodePool->asyncInProgress = true;
+    }
+}
+
+/*
+ * Histogram bucket of value, see POOL_LATENCY_BUCKETS.
+ */
+static int
+pool_telemetry_bucket(uint64 value, int nbuckets)
+{
+    int bucket = 0;
+
+    while (value > 1 && bucket < nbuckets - 1)
+    {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/*
+ * Record a latency sample in the telemetry of node pool. Only called in
+ * the main thread, sync threads hand their timestamps back in the request.
+ */
+static void
+pool_record_latency(PGXCNodePool *nodePool, PoolLatencyKind kind, struct timeval *start_time, struct timeval *end_time)
+{
+    int64 diff;
+
+    if (NULL == nodePool || (start_time->tv_sec == 0 && start_time->tv_usec == 0) ||
+        (end_time->tv_sec == 0 && end_time->tv_usec == 0))
+    {
+        return;
+    }
+
+    diff = (int64) 1000000 * (end_time->tv_sec - start_time->tv_sec) + (end_time->tv_usec - start_time->tv_usec);
+    if (diff < 0)
+    {
+        diff = 0;
+    }
+
+    nodePool->telemetry.latency[kind][pool_telemetry_bucket((uint64) diff, POOL_LATENCY_BUCKETS)]++;
+    nodePool->telemetry.latency_sum[kind] += diff;
+}
+
+static void
+pool_record_build_fail(PGXCNodePool *nodePool, PoolBuildFailCause cause)
+{
+    if (nodePool)
+    {
+        nodePool->telemetry.build_fail[cause]++;
+    }
+}
+
 /*
  * Destroy pool slot, including slot itself.
  */
@@ -5943,6 +6379,7 @@ shrink_pool(DatabasePool *pool)
     PGXCNodePool   *nodePool;
     int             i;
     int32             nodeidx;
+    int32           predicted;
     bool            empty = true;
 
     /* Negative PooledConnKeepAlive disables automatic connection cleanup */
@@ -5961,7 +6398,12 @@ shrink_pool(DatabasePool *pool)
         */
         freeCount = 0;
         nodeidx = get_node_index_by_nodeoid(nodePool->nodeoid);
-        for (i = 0; i < nodePool->freeSize && freeCount < MAX_FREE_CONNECTION_NUM && nodePool->size >= MinPoolSize && nodePool->freeSize >= MinFreeSize; )
+
+        /* keep connections the demand profile predicts to be needed soon */
+        pool_demand_record(nodePool, now);
+        predicted = PoolDemandPrediction ? pool_demand_predict(nodePool, now) : 0;
+
+        for (i = 0; i < nodePool->freeSize && freeCount < MAX_FREE_CONNECTION_NUM && nodePool->size >= MinPoolSize && nodePool->freeSize >= MinFreeSize && nodePool->size > predicted; )
         {
             PGXCNodePoolSlot *slot = nodePool->slot[i];
             if (slot)
@@ -6049,6 +6491,11 @@ shrink_pool(DatabasePool *pool)
                 grow_pool(pool, nodeidx, nodePool->nodeoid, nodePool->coord);
             }
         }
+
+        if (predicted > 0)
+        {
+            pool_demand_prewarm(pool, nodePool, nodeidx, predicted);
+        }
         
 		if (PoolConnectDebugPrint)
 		{
@@ -6196,6 +6643,9 @@ static void pooler_handle_sync_response_queue(void)
                 {        
                     
                     record_time(connRsp->start_time, connRsp->end_time);
+                    pool_record_latency(connRsp->nodepool,
+                                        connRsp->needConnect ? PoolLatencySyncBuild : PoolLatencySetReplay,
+                                        &connRsp->start_time, &connRsp->end_time);
                     
                     switch (get_task_status(connRsp->taskControl))
                     {
@@ -6376,6 +6826,15 @@ static void pooler_handle_sync_response_queue(void)
                     {
                         case  PoolResetStatus_reset:
                         {
+                            Oid resetOid = connRsp->bCoord ? agent->coord_conn_oids[connRsp->nodeindex]
+                                                           : agent->dn_conn_oids[connRsp->nodeindex];
+
+                            if (agent->pool)
+                            {
+                                pool_record_latency((PGXCNodePool *) hash_search(agent->pool->nodePools, &resetOid, HASH_FIND, NULL),
+                                                    PoolLatencyReset, &connRsp->start_time, &connRsp->end_time);
+                            }
+
                             if (PoolConnectDebugPrint)
                             {
                                 elog(LOG, POOL_MGR_PREFIX"++++pooler_handle_sync_response_queue middle disconnect bCoord:%d nodeindex:%d pid:%d finish++++ ", connRsp->bCoord, connRsp->nodeindex, agent->pid);
@@ -6770,6 +7229,8 @@ static void pooler_sync_connections_to_nodepool(void)
                     nodePool->coord      = false; /* in this case, only datanode */
                     nodePool->nwarming   = 0;
                     nodePool->nquery     = 0;
+                    pool_demand_init(nodePool);
+                    MemSet(&nodePool->telemetry, 0, sizeof(PoolNodeTelemetry));
 					nodePool->m_version = asyncInfo->dbPool->version++;
 
                     name_str = get_node_name_by_nodeoid(asyncInfo->node);
@@ -6932,6 +7393,8 @@ static void pooler_sync_connections_to_nodepool(void)
                         nodePool->coord      = connRsp->bCoord; 
                         nodePool->nwarming   = 0;
                         nodePool->nquery     = 0;
+                        pool_demand_init(nodePool);
+                        MemSet(&nodePool->telemetry, 0, sizeof(PoolNodeTelemetry));
 
                         name_str = get_node_name_by_nodeoid(connRsp->nodeoid);
                         if (NULL == name_str)
@@ -6992,6 +7455,7 @@ static void pooler_sync_connections_to_nodepool(void)
                         else
                         {
 							destroy_slot(connRsp->nodeindex, connRsp->nodeoid, slot, false);
+                            pool_record_build_fail(nodePool, PoolBuildFailDiscard);
                             if (PoolConnectDebugPrint)
                             {
 								elog(LOG, POOL_MGR_PREFIX"destroy slot poolsize:%d, "
@@ -7005,6 +7469,7 @@ static void pooler_sync_connections_to_nodepool(void)
                                     
                     }
                     nodePool->asyncInProgress = false;
+                    pool_record_latency(nodePool, PoolLatencyAsyncBuild, &connRsp->start_time, &connRsp->end_time);
 
                     if (PoolConnectDebugPrint)
                     {
@@ -7016,6 +7481,7 @@ static void pooler_sync_connections_to_nodepool(void)
                     /* check if some node failed to connect, just release last socket */
                     if (connRsp->validSize < connRsp->size && connRsp->failed)
                     {                
+                        pool_record_build_fail(nodePool, PoolBuildFailConnect);
                         ereport(LOG,
                                 (errcode(ERRCODE_CONNECTION_FAILURE),
                                  errmsg(POOL_MGR_PREFIX"failed to connect to Datanode:[%s], validSize:%d, size:%d, errmsg:%s", nodePool->connstr, 
@@ -7201,6 +7667,8 @@ static bool pooler_async_build_connection(DatabasePool *pool, int64 pool_version
 	if (-1 == threadid)
 	{
 		elog(LOG, POOL_MGR_PREFIX"no pipeline avaliable, pooler_async_build_connection node:%u nodeidx:%d", node, nodeidx);	
+		pool_record_build_fail((PGXCNodePool *) hash_search(pool->nodePools, &node, HASH_FIND, NULL),
+							   PoolBuildFailNoThread);
 		return false;
 	}
 	
@@ -7215,6 +7683,7 @@ static bool pooler_async_build_connection(DatabasePool *pool, int64 pool_version
     connReq->size      = size;
     connReq->validSize = 0;
     connReq->m_version = pool_version;
+    gettimeofday(&connReq->start_time, NULL);
 
 	while (-1 == PipePut(g_PoolConnControl.request[threadid], (void*)connReq))
     {
@@ -7541,6 +8010,8 @@ preconnect_and_warm(DatabasePool *dbPool)
             nodePool->coord    = false;
             nodePool->nwarming   = 0;
             nodePool->nquery     = 0;
+            pool_demand_init(nodePool);
+            MemSet(&nodePool->telemetry, 0, sizeof(PoolNodeTelemetry));
 
             name_str = get_node_name_by_nodeoid(dnOids[i]);
             if (NULL == name_str)
@@ -7700,6 +8171,7 @@ void *pooler_async_connection_management_thread(void *arg)
 						SetSockKeepAlive(((PGconn *)slot->conn)->sock);
                         set_cancel_conn_keepalive((PGcancel *)slot->xc_cancelConn);
 					}					
+					gettimeofday(&request->end_time, NULL);
 					break;
 				}
 
@@ -7861,6 +8333,11 @@ void *pooler_sync_remote_operator_thread(void *arg)
                             if (slot)
                             {
                                 res = PGXCNodeSendSetQuery(slot->conn, "DISCARD ALL;", NULL, 0, &request->setquery_status, &commandId);
+                                if (0 == res)
+                                {
+                                    slot->session_hash = 0;
+                                    slot->session_ncmd = 0;
+                                }
                             }
 
                             if (res)
@@ -8029,37 +8506,40 @@ void *pooler_sync_remote_operator_thread(void *arg)
                                 CommandId commandId = InvalidCommandId;
                                 if (PoolConnectStaus_set_param == request->final_status)
                                 {
+                                    char *session_command = NULL;
+
                                     res = 0;
-                                    if (request->agent->session_params)
+                                    /* get nodeoid and slot */
+                                    if (request->bCoord)
+                                    {
+                                        nodeoid =  request->agent->coord_conn_oids[request->nodeindex];
+                                        slot2    =  request->agent->coord_connections[request->nodeindex];
+                                    }
+                                    else
+                                    {
+                                        nodeoid =  request->agent->dn_conn_oids[request->nodeindex];
+                                        slot2    =  request->agent->dn_connections[request->nodeindex];
+                                    }
+
+                                    /* only replay the commands the connection is lacking */
+                                    session_command = pooler_build_session_command(request->agent, slot2);
+                                    if (session_command)
                                     {
                                         /* 
                                          * sepcial case in 'g', othes set in front of pooler_sync_remote_operator_thread
                                          * by call pooler_async_task_start
                                          */
-                                        
-                                        /* get nodeoid and slot */
-                                        if (request->bCoord)
-                                        {
-                                            nodeoid =  request->agent->coord_conn_oids[request->nodeindex];
-                                            slot2    =  request->agent->coord_connections[request->nodeindex];
-                                        }
-                                        else
-                                        {
-                                            nodeoid =  request->agent->dn_conn_oids[request->nodeindex];
-                                            slot2    =  request->agent->dn_connections[request->nodeindex];
-                                        } 
                                         record_slot_info(&g_PoolSyncNetworkControl, threadIndex, slot2, nodeoid);
                                         /* record message */
-                                        record_task_message(&g_PoolSyncNetworkControl, threadIndex, request->agent->session_params);
+                                        record_task_message(&g_PoolSyncNetworkControl, threadIndex, session_command);
                                         
-                                        if (request->bCoord)
-                                        {
-                                            res = PGXCNodeSendSetQuery(request->agent->coord_connections[request->nodeindex]->conn, request->agent->session_params, request->errmsg, POOLER_ERROR_MSG_LEN, &request->setquery_status, &commandId);
-                                        }
-                                        else
-                                        {
-                                            res = PGXCNodeSendSetQuery(request->agent->dn_connections[request->nodeindex]->conn, request->agent->session_params, request->errmsg, POOLER_ERROR_MSG_LEN, &request->setquery_status, &commandId);
-                                        }
+                                        res = PGXCNodeSendSetQuery(slot2->conn, session_command, request->errmsg, POOLER_ERROR_MSG_LEN, &request->setquery_status, &commandId);
+                                        free(session_command);
+                                    }
+                                    else if (!POOL_SESSION_MATCHED(request->agent, slot2))
+                                    {
+                                        snprintf(request->errmsg, POOLER_ERROR_MSG_LEN, "out of memory when building session parameters");
+                                        res = -1;
                                     }
 
                                     /* Error, free the connection here only when we build the connection here */
@@ -8097,6 +8577,7 @@ void *pooler_sync_remote_operator_thread(void *arg)
                                     else
                                     {
                                         /* job succeed */
+                                        pooler_mark_session_applied(request->agent, slot2);
                                         request->current_status = PoolConnectStaus_done;
                                         /* Increase success count first and then finish count */
                                         acquire_command_increase_succeed(request->taskControl);
@@ -8427,11 +8908,20 @@ void *pooler_sync_remote_operator_thread(void *arg)
                             {
                                 request->error_flag = true;
                                 set_task_error_msg(request->taskControl, request->errmsg);
+                                /* we don't know which parameters are applied now */
+                                if (slot && POOL_CMD_GLOBAL_SET == request->taskControl->m_command_type)
+                                {
+                                    slot->session_ncmd = -1;
+                                }
                             }
                             else
                             {
                                 set_command_increase_succeed(request->taskControl);
                                 set_task_max_command_id(request->taskControl, commandID);
+                                if (slot && POOL_CMD_GLOBAL_SET == request->taskControl->m_command_type)
+                                {
+                                    pooler_mark_session_applied(request->agent, slot);
+                                }
                             }
                             finish_task_request(request->taskControl);
                             break;
@@ -8473,8 +8963,8 @@ void *pooler_sync_remote_operator_thread(void *arg)
                 }
             }
 
-            /* record each conn request end time */
-            if (PoolPrintStatTimeout > 0 && 'g' == request->cmd)
+            /* record each conn and reset request end time */
+            if ('g' == request->cmd || 'd' == request->cmd)
             {
                 gettimeofday(&request->end_time, NULL);        
             }
@@ -8670,11 +9160,8 @@ static inline bool dispatch_connection_request(PGXCASyncTaskCtl  *taskControl,
     req->needfree                  = dispatched;
     req->req_seq                  = reqseq;
 
-    /*record request begin time*/
-    if (PoolPrintStatTimeout > 0 && !dispatched)
-    {
-        gettimeofday(&req->start_time, NULL);
-    }
+    /* record request begin time */
+    gettimeofday(&req->start_time, NULL);
 
     /* only init stauts need to alloc a slot */
     if (PoolConnectStaus_init == status)
@@ -9083,6 +9570,7 @@ static inline bool dispatch_reset_request(PGXCASyncTaskCtl  *taskControl,
     req->needfree                  = dispatched;
     req->error_flag                  = false;
     req->setquery_status          = SendSetQuery_OK;
+    gettimeofday(&req->start_time, NULL);
     
     if (PoolConnectDebugPrint)
     {
@@ -11167,6 +11655,7 @@ static void reset_pooler_statistics(void)
     g_pooler_stat.acquire_conn_from_hashtab = 0;
     g_pooler_stat.acquire_conn_from_hashtab_and_set = 0;
     g_pooler_stat.acquire_conn_from_thread = 0;
+    g_pooler_stat.acquire_conn_fingerprint_hit = 0;
     g_pooler_stat.client_request_conn_total = 0;
     g_pooler_stat.client_request_from_hashtab = 0;
     g_pooler_stat.client_request_from_thread = 0;
@@ -11196,7 +11685,7 @@ static void print_pooler_statistics(void)
             elog(LOG, "[pooler stat]client_request_conn_total=%d, client_request_from_hashtab=%d, "
                       "client_request_from_thread=%d, acquire_conn_from_hashtab=%d, "
                         "acquire_conn_from_hashtab_and_set=%d, acquire_conn_from_thread=%d, "
-                        "acquire_conn_time=%lu, "
+                        "acquire_conn_fingerprint_hit=%d, acquire_conn_time=%lu, "
                         "each_client_conn_request_cost_time=%f us",
                   g_pooler_stat.client_request_conn_total, 
                   g_pooler_stat.client_request_from_hashtab,
@@ -11204,6 +11693,7 @@ static void print_pooler_statistics(void)
                   g_pooler_stat.acquire_conn_from_hashtab,
                   g_pooler_stat.acquire_conn_from_hashtab_and_set,
                   g_pooler_stat.acquire_conn_from_thread,
+                  g_pooler_stat.acquire_conn_fingerprint_hit,
                   g_pooler_stat.acquire_conn_time,
                   (double)g_pooler_stat.acquire_conn_time / (double)g_pooler_stat.client_request_conn_total);
             reset_pooler_statistics();
@@ -11647,3 +12137,141 @@ handle_get_conn_statistics(PoolAgent *agent)
 
     pfree(buf.data);
 }
+
+/*
+ * handle get demand statistics, one row per node pool
+ */
+static void
+handle_get_demand_statistics(PoolAgent *agent)
+{
+    DatabasePool     *database_pool = databasePools;
+    HASH_SEQ_STATUS  hseq_status;
+    PGXCNodePool     *node_pool = NULL;
+    uint32           node_cnt = 0;
+    uint32           node_cnt_offset = 0;
+    time_t           now = time(NULL);
+    StringInfoData   buf;
+
+    initStringInfo(&buf);
+    /* reserve a place for node_cnt */
+    node_cnt_offset = buf.len;
+    pq_sendint(&buf, node_cnt, sizeof(uint32));
+
+    /* node count | database | username | node name | hour | in use | size | hour peak | predicted | ... */
+    while (database_pool)
+    {
+        hash_seq_init(&hseq_status, database_pool->nodePools);
+        while ((node_pool = (PGXCNodePool *) hash_seq_search(&hseq_status)))
+        {
+            node_cnt++;
+
+            pq_sendstring(&buf, database_pool->database);
+            pq_sendstring(&buf, database_pool->user_name);
+            pq_sendstring(&buf, node_pool->node_name);
+            pq_sendint(&buf, node_pool->demand_hour, sizeof(int32));
+            pq_sendint(&buf, node_pool->size - node_pool->freeSize, sizeof(int32));
+            pq_sendint(&buf, node_pool->size, sizeof(int32));
+            pq_sendint(&buf, node_pool->demand_peak, sizeof(int32));
+            pq_sendint(&buf, pool_demand_predict(node_pool, now), sizeof(int32));
+        }
+        database_pool = database_pool->next;
+    }
+
+    /* change the nodes count in message buff */
+    node_cnt = htonl(node_cnt);
+    pq_updatemsgbytes(&buf, node_cnt_offset, (char*) &node_cnt, sizeof(uint32));
+
+    /* send messages */
+    pool_putmessage(&agent->port, 'D', buf.data, buf.len);
+    pool_flush(&agent->port);
+
+    pfree(buf.data);
+}
+
+/*
+ * handle get node pool telemetry, one row per node pool
+ */
+static void
+handle_get_node_telemetry(PoolAgent *agent)
+{
+    DatabasePool     *database_pool = databasePools;
+    HASH_SEQ_STATUS  hseq_status;
+    PGXCNodePool     *node_pool = NULL;
+    uint32           node_cnt = 0;
+    uint32           node_cnt_offset = 0;
+    uint32           slot_age[POOL_SLOT_AGE_BUCKETS];
+    int              i = 0;
+    int              j = 0;
+    time_t           now = time(NULL);
+    StringInfoData   buf;
+
+    initStringInfo(&buf);
+    /* reserve a place for node_cnt */
+    node_cnt_offset = buf.len;
+    pq_sendint(&buf, node_cnt, sizeof(uint32));
+
+    /*
+     * node count | database | username | node name | for each latency kind: sum, buckets |
+     * build failures | free slot age buckets | ...
+     */
+    while (database_pool)
+    {
+        hash_seq_init(&hseq_status, database_pool->nodePools);
+        while ((node_pool = (PGXCNodePool *) hash_seq_search(&hseq_status)))
+        {
+            PoolNodeTelemetry *telemetry = &node_pool->telemetry;
+
+            node_cnt++;
+
+            pq_sendstring(&buf, database_pool->database);
+            pq_sendstring(&buf, database_pool->user_name);
+            pq_sendstring(&buf, node_pool->node_name);
+
+            for (i = 0; i < POOL_LATENCY_KIND_COUNT; i++)
+            {
+                pq_sendint64(&buf, telemetry->latency_sum[i]);
+                for (j = 0; j < POOL_LATENCY_BUCKETS; j++)
+                {
+                    pq_sendint(&buf, telemetry->latency[i][j], sizeof(uint32));
+                }
+            }
+
+            for (i = 0; i < POOL_BUILD_FAIL_COUNT; i++)
+            {
+                pq_sendint(&buf, telemetry->build_fail[i], sizeof(uint32));
+            }
+
+            /* only the free slots are in the pool, slots in use belong to the agents */
+            MemSet(slot_age, 0, sizeof(slot_age));
+            if (node_pool->slot)
+            {
+                for (i = 0; i < node_pool->freeSize; i++)
+                {
+                    double age;
+
+                    if (NULL == node_pool->slot[i])
+                    {
+                        continue;
+                    }
+                    age = difftime(now, node_pool->slot[i]->created);
+                    slot_age[pool_telemetry_bucket(age > 0 ? (uint64) age : 0, POOL_SLOT_AGE_BUCKETS)]++;
+                }
+            }
+            for (i = 0; i < POOL_SLOT_AGE_BUCKETS; i++)
+            {
+                pq_sendint(&buf, slot_age[i], sizeof(uint32));
+            }
+        }
+        database_pool = database_pool->next;
+    }
+
+    /* change the nodes count in message buff */
+    node_cnt = htonl(node_cnt);
+    pq_updatemsgbytes(&buf, node_cnt_offset, (char*) &node_cnt, sizeof(uint32));
+
+    /* send messages */
+    pool_putmessage(&agent->port, 'T', buf.data, buf.len);
+    pool_flush(&agent->port);
+
+    pfree(buf.data);
+}
@@ -439,6 +439,8 @@ int64 vacuum_shard_internal(Relation rel, Bitmapset *to_vacuum, Snapshot vacuum_
     }    
 
     scan = heap_beginscan(rel, vacuum_snapshot, 0, NULL);
+    /* the extents of other shards are not read */
+    heap_setscanshards(scan, to_vacuum);
     tup = heap_getnext(scan,ForwardScanDirection);
     
     while(HeapTupleIsValid(tup))
@@ -75,6 +75,7 @@
 #include "utils/fmgroids.h"
 #include "utils/rel.h"
 #include "utils/inval.h"
+#include "utils/plancache.h"
 #include "pgxc/shardmap.h"
 #include "pgxc/pgxc.h"
 #include "pgxc/pgxcnode.h"
@@ -106,12 +107,12 @@
 #include "pgxc/groupmgr.h"
 #include "funcapi.h"
 #include "utils/builtins.h"
+#include "utils/memutils.h"
 #include "utils/regproc.h"
 #include "catalog/namespace.h"
 #include <sys/stat.h>
 #ifdef __COLD_HOT__
 #include "catalog/pgxc_key_values.h"
-#include "utils/memutils.h"
 #include "postmaster/postmaster.h"
 #include "utils/ruleutils.h"
 #endif
@@ -131,6 +132,7 @@ typedef struct
     int32   shmemNumShardGroups;    /* number of shard groups */
     int32   shmemNumShards;            /* number of shards */
     int32   shmemNumShardNodes;        /* number of nodes in the sharding group*/
+    pg_crc32c shmemMapFingerprint;    /* crc of the node of every shard */
 
     int32   shmemshardnodes[MAX_GROUP_NODE_NUMBER];/* node index of this group, ordered by node name */
     int32   shmemNodeMap[OPENTENBASE_MAX_DATANODE_NUMBER];    /* map for global node index to group native node index */
@@ -152,6 +154,7 @@ typedef struct
 {
     bool           inited;
     bool           needLock;                      /* whether we need lock */
+    pg_atomic_uint64 generation;                  /* bumped when the maps change */
     slock_t           lock[MAX_SHARDING_NODE_GROUP]; /* locks to protect used fields */
     bool            used[MAX_SHARDING_NODE_GROUP];
 
@@ -163,6 +166,7 @@ typedef struct
 {
     bool           inited;
     bool           needLock;                      /* whether we need lock */
+    pg_atomic_uint64 generation;                  /* bumped when the map changes */
     slock_t           lock; /* locks to protect used fields */
     bool            used;
 
@@ -180,6 +184,26 @@ static ShardNodeGroupInfo_DN *g_GroupShardingMgr_DN = NULL;
 static bool g_ShardMapValid = false;
 static ShardMapItemDef g_ShardMap[SHARD_MAP_GROUP_NUM];
 
+/*
+ * Private copy of the shard map of a group, used to route rows without
+ * taking ShardMapLock, see GetShardMapCache. Datanodes only have the map
+ * of their own group.
+ */
+#define SHARD_MAP_CACHE_SHARDS    Max(SHARD_MAP_SHARD_NUM, EXTENSION_SHARD_MAP_SHARD_NUM)
+
+typedef struct
+{
+    bool    valid;
+    Oid     group;
+    uint64  generation;         /* of the shared maps when copied */
+    int32   nshards;
+    int32  *nodeindex;          /* node index of every shard */
+}ShardMapCacheEnt;
+
+static ShardMapCacheEnt  g_ShardMapCache[MAX_SHARDING_NODE_GROUP];
+static int               g_ShardMapCacheNum  = 0;
+static ShardMapCacheEnt *g_ShardMapCacheLast = NULL;
+
 /* used for datanodes */
 Bitmapset                      *g_DatanodeShardgroupBitmap  = NULL;
 
@@ -337,6 +361,10 @@ static void   FreshGroupShardMap(Oid group);
 static void   BuildDatanodeVisibilityMap(Form_pgxc_shard_map tuple, Oid self_oid);
 static void GetShardNodes_CN(Oid group, int32 ** nodes, int32 *num_nodes, bool *isextension);
 static void GetShardNodes_DN(Oid group, int32 ** nodes, int32 *num_nodes, bool *isextension);
+static void ComputeShardMapFingerprint(GroupShardInfo *info);
+static GroupShardInfo *GetUsingGroupShardInfo_CN(Oid group);
+static void ShardMapBumpGeneration(void);
+static ShardMapCacheEnt *GetShardMapCache(Oid group);
 
 extern Datum  pg_stat_table_shard(PG_FUNCTION_ARGS);
 extern Datum  pg_stat_all_shard(PG_FUNCTION_ARGS);
@@ -371,6 +399,7 @@ void InvalidateShmemShardMap(bool iscommit)
                 g_GroupShardingMgr->needLock = true;
                 
                 LWLockAcquire(ShardMapLock, LW_EXCLUSIVE);
+                ShardMapBumpGeneration();
                 for (i = 0; i < g_UpdateShardingGroupInfo.nGroups; i++)
                 {
                     if (ShardOpType_create == g_UpdateShardingGroupInfo.optype[i])
@@ -401,6 +430,7 @@ void InvalidateShmemShardMap(bool iscommit)
                     else if (ShardOpType_drop == g_UpdateShardingGroupInfo.optype[i])
                     {
                         LWLockAcquire(ShardMapLock, LW_EXCLUSIVE);
+                        ShardMapBumpGeneration();
                         RemoveShardMapEntry(g_UpdateShardingGroupInfo.group[i]);
                         LWLockRelease(ShardMapLock);
                     }
@@ -472,6 +502,7 @@ void ShardMapShmemInit_CN(void)
     }
     g_GroupShardingMgr->inited   = false;
     g_GroupShardingMgr->needLock = false;
+    pg_atomic_init_u64(&g_GroupShardingMgr->generation, 0);
     
     groupshard = (GroupShardInfo *)ShmemInitStruct("Group shard major",
                                                         MAXALIGN64(sizeof(GroupShardInfo)) + MAXALIGN64(sizeof(ShardMapItemDef)) * (SHARD_MAP_GROUP_NUM - 1),
@@ -538,6 +569,7 @@ void ShardMapShmemInit_DN(void)
     }
     g_GroupShardingMgr_DN->inited   = false;
     g_GroupShardingMgr_DN->needLock = false;
+    pg_atomic_init_u64(&g_GroupShardingMgr_DN->generation, 0);
     
     groupshard = (GroupShardInfo *)ShmemInitStruct("Group shard major",
                                                         MAXALIGN64(sizeof(GroupShardInfo)) + MAXALIGN64(sizeof(ShardMapItemDef)) * (SHARD_MAP_GROUP_NUM - 1),
@@ -631,7 +663,8 @@ static void SyncShardMapList_CN(bool force)
 		g_GroupShardingMgr->needLock = false;
 		return;
 	}
-    
+
+	ShardMapBumpGeneration();
 	g_GroupShardingMgr->inited = false;
     SyncShardMapList_Node_CN();
     g_GroupShardingMgr->inited = true;
@@ -674,6 +707,7 @@ static void SyncShardMapList_DN(bool force)
 		g_GroupShardingMgr_DN->needLock = false;
 		return;
 	}
+	ShardMapBumpGeneration();
 	g_GroupShardingMgr_DN->inited = false;
     
     g_GroupShardingMgr_DN->inited = SyncShardMapList_Node_DN();
@@ -984,6 +1018,7 @@ static void ShardMapInitDone_CN(int32 map, Oid group, bool need_lock)
     if (need_lock)
     {
         LWLockAcquire(ShardMapLock, LW_EXCLUSIVE);
+        ShardMapBumpGeneration();
     }
 
     /* Add group node to hashmap. */
@@ -1051,6 +1086,7 @@ static void ShardMapInitDone_CN(int32 map, Oid group, bool need_lock)
             g_GroupShardingMgr->members[map]->shmemNodeMap[nodeindex] = i;
         }
     }
+    ComputeShardMapFingerprint(g_GroupShardingMgr->members[map]);
     g_GroupShardingMgr->members[map]->shardMapStatus = SHMEM_SHRADMAP_STATUS_USING;
     
     if (need_lock)
@@ -1086,6 +1122,7 @@ static void ShardMapInitDone_DN(Oid group, bool need_lock)
     if (need_lock)
     {
         LWLockAcquire(ShardMapLock, LW_EXCLUSIVE);
+        ShardMapBumpGeneration();
     }
     
     /* init shard group nodes of the shard map */
@@ -1130,6 +1167,7 @@ static void ShardMapInitDone_DN(Oid group, bool need_lock)
         /* Store the group native index of the node into the node global map. */
         g_GroupShardingMgr_DN->members->shmemNodeMap[nodeindex] = i;
     }
+    ComputeShardMapFingerprint(g_GroupShardingMgr_DN->members);
     g_GroupShardingMgr_DN->members->shardMapStatus = SHMEM_SHRADMAP_STATUS_USING;
     
     if (need_lock)
@@ -1139,6 +1177,145 @@ static void ShardMapInitDone_DN(Oid group, bool need_lock)
 }
 
 
+/*
+ * Fingerprint of the shard map of a group: the node every shard is routed
+ * to. Groups whose maps have the same fingerprint are likely to place every
+ * shard on the same node, ShardMapsIdentical verifies it.
+ */
+static void ComputeShardMapFingerprint(GroupShardInfo *info)
+{
+    int32 i;
+
+    INIT_CRC32C(info->shmemMapFingerprint);
+    COMP_CRC32C(info->shmemMapFingerprint, &info->shmemNumShards, sizeof(int32));
+    for (i = 0; i < info->shmemNumShards; i++)
+    {
+        COMP_CRC32C(info->shmemMapFingerprint,
+                    &info->shmemshardmap[i].nodeindex, sizeof(int32));
+    }
+    FIN_CRC32C(info->shmemMapFingerprint);
+}
+
+/*
+ * Tell backends their copies of the shard maps are stale. Called with
+ * ShardMapLock held exclusively, before the maps are changed.
+ */
+static void ShardMapBumpGeneration(void)
+{
+    if (IS_PGXC_COORDINATOR)
+    {
+        pg_atomic_fetch_add_u64(&g_GroupShardingMgr->generation, 1);
+    }
+    else if (IS_PGXC_DATANODE)
+    {
+        pg_atomic_fetch_add_u64(&g_GroupShardingMgr_DN->generation, 1);
+    }
+}
+
+/*
+ * Copy of the shard map of group private to the backend.
+ *
+ * Routing a row only reads the generation of the shared maps: the copy is
+ * used as long as the generation has not moved since it was taken, and is
+ * taken again under ShardMapLock in shared mode otherwise. A copy taken
+ * before a change is used until the change is done, as if the lock had
+ * been taken before it.
+ */
+static ShardMapCacheEnt *GetShardMapCache(Oid group)
+{
+    pg_atomic_uint64 *generation;
+    ShardMapCacheEnt *cache;
+    GroupShardInfo   *info;
+    GroupLookupTag    tag;
+    GroupLookupEnt   *ent;
+    bool              found;
+    int               i;
+
+    if (IS_PGXC_COORDINATOR)
+    {
+        generation = &g_GroupShardingMgr->generation;
+    }
+    else
+    {
+        generation = &g_GroupShardingMgr_DN->generation;
+        group = InvalidOid;
+    }
+
+    cache = g_ShardMapCacheLast;
+    if (cache == NULL || !cache->valid || cache->group != group)
+    {
+        cache = NULL;
+        for (i = 0; i < g_ShardMapCacheNum; i++)
+        {
+            if (g_ShardMapCache[i].valid && g_ShardMapCache[i].group == group)
+            {
+                cache = &g_ShardMapCache[i];
+                break;
+            }
+        }
+    }
+
+    if (cache != NULL && cache->generation == pg_atomic_read_u64(generation))
+    {
+        g_ShardMapCacheLast = cache;
+        return cache;
+    }
+
+    if (cache == NULL)
+    {
+        /* groups dropped leave their copies behind, reuse one if full */
+        if (g_ShardMapCacheNum < MAX_SHARDING_NODE_GROUP)
+        {
+            cache = &g_ShardMapCache[g_ShardMapCacheNum++];
+        }
+        else
+        {
+            cache = &g_ShardMapCache[group % MAX_SHARDING_NODE_GROUP];
+        }
+    }
+
+    cache->valid = false;
+    if (cache->nodeindex == NULL)
+    {
+        cache->nodeindex = (int32 *) MemoryContextAlloc(TopMemoryContext,
+                                                        sizeof(int32) * SHARD_MAP_CACHE_SHARDS);
+    }
+
+    LWLockAcquire(ShardMapLock, LW_SHARED);
+
+    if (IS_PGXC_COORDINATOR)
+    {
+        tag.group = group;
+        ent = (GroupLookupEnt*)hash_search(g_GroupHashTab, (void *) &tag, HASH_FIND, &found);
+        if (!found)
+        {
+            LWLockRelease(ShardMapLock);
+            elog(ERROR , "no shard group of %u found", group);
+        }
+        info = g_GroupShardingMgr->members[ent->shardIndex];
+    }
+    else
+    {
+        info = g_GroupShardingMgr_DN->members;
+    }
+
+    cache->generation = pg_atomic_read_u64(generation);
+    cache->nshards    = info->shmemNumShards;
+    Assert(cache->nshards > 0 && cache->nshards <= SHARD_MAP_CACHE_SHARDS);
+    for (i = 0; i < cache->nshards; i++)
+    {
+        cache->nodeindex[i] = info->shmemshardmap[i].nodeindex;
+    }
+
+    LWLockRelease(ShardMapLock);
+
+    cache->group = group;
+    cache->valid = true;
+    g_ShardMapCacheLast = cache;
+
+    return cache;
+}
+
 static int cmp_int32(const void *p1, const void *p2)
 {
     int i1;
@@ -1277,64 +1454,71 @@ List* ShardMapRouter(Oid group, Oid relation, Oid type, Datum dvalue, RelationAc
 }
 #endif
 int32  GetNodeIndexByHashValue(Oid group, long hashvalue)
-{// #lizard forgives    
-    int            shardIdx;
-    int            nodeIdx = 0;
-    bool           needLock = false;
-    bool           found;
-    GroupLookupTag tag;
-    GroupLookupEnt *ent;
-    ShardMapItemDef *shardgroup;
-    int slot = 0;
+{
+    ShardMapCacheEnt *cache;
+    int               shardIdx;
     
     if(IS_PGXC_COORDINATOR && !OidIsValid(group))
     {
         elog(PANIC, "[GetNodeIndexByHashValue]group oid can not be invalid.");
     }
 
-    if (IS_PGXC_COORDINATOR)
+    if (!IS_PGXC_COORDINATOR && !IS_PGXC_DATANODE)
     {
-        needLock  = g_GroupShardingMgr->needLock;
-        if (needLock)
-        {
-            LWLockAcquire(ShardMapLock, LW_SHARED);
-        }
+        return 0;
+    }
 
-        tag.group =  group;
-        ent = (GroupLookupEnt*)hash_search(g_GroupHashTab, (void *) &tag, HASH_FIND, &found);            
-        if (!found)
-        {
-            elog(ERROR , "no shard group of %u found", group);
-        }
+    /* no lock, see GetShardMapCache */
+    cache    = GetShardMapCache(group);
+    shardIdx = abs(hashvalue) % cache->nshards;
 
-        slot = ent->shardIndex;
+    if (IS_PGXC_DATANODE && g_ShardMapValid)
+    {
+        return g_ShardMap[shardIdx].nodeindex;
+    }
+    return cache->nodeindex[shardIdx];
+}
+
+#ifdef __OPENTENBASE__
+/*
+ * GetNodeIndexByHashValue for each of nvalues hash values, looking up the
+ * shard map of the group only once.
+ */
+void GetNodeIndexesByHashValues(Oid group, long *hashvalues, int nvalues,
+                                int32 *nodeindexes)
+{
+    ShardMapCacheEnt *cache;
+    int            i;
 
-        shardIdx     = abs(hashvalue) % (g_GroupShardingMgr->members[slot]->shmemNumShards);
-        shardgroup   = &g_GroupShardingMgr->members[slot]->shmemshardmap[shardIdx];
-        nodeIdx      = shardgroup->nodeindex;
+    if (IS_PGXC_COORDINATOR && !OidIsValid(group))
+    {
+        elog(PANIC, "[GetNodeIndexesByHashValues]group oid can not be invalid.");
     }
-    else if (IS_PGXC_DATANODE)
+
+    if (!IS_PGXC_COORDINATOR && !IS_PGXC_DATANODE)
     {
-        needLock  = g_GroupShardingMgr_DN->needLock;
-        if (needLock)
+        /* same as GetNodeIndexByHashValue */
+        memset(nodeindexes, 0, sizeof(int32) * nvalues);
+        return;
+    }
+
+    cache = GetShardMapCache(group);
+
+    if (IS_PGXC_DATANODE && g_ShardMapValid)
+    {
+        for (i = 0; i < nvalues; i++)
         {
-            LWLockAcquire(ShardMapLock, LW_SHARED);
+            nodeindexes[i] = g_ShardMap[abs(hashvalues[i]) % cache->nshards].nodeindex;
         }
-
-        shardIdx     = abs(hashvalue) % (g_GroupShardingMgr_DN->members->shmemNumShards);
-		if (g_ShardMapValid)
-			shardgroup = &g_ShardMap[shardIdx];
-		else
-        shardgroup   = &g_GroupShardingMgr_DN->members->shmemshardmap[shardIdx];
-        nodeIdx      = shardgroup->nodeindex;
+        return;
     }
 
-    if (needLock)
+    for (i = 0; i < nvalues; i++)
     {
-        LWLockRelease(ShardMapLock);
+        nodeindexes[i] = cache->nodeindex[abs(hashvalues[i]) % cache->nshards];
     }
-    return nodeIdx;
 }
+#endif
 
 /* Get node index map of group. */
 void  GetGroupNodeIndexMap(Oid group, int32 *map)
@@ -1390,6 +1574,171 @@ void  GetGroupNodeIndexMap(Oid group, int32 *map)
 }
 
 
+/*
+ * Shard map of the group in use, NULL if the group has none or it is being
+ * reloaded. Called with ShardMapLock held if needed.
+ */
+static GroupShardInfo *GetUsingGroupShardInfo_CN(Oid group)
+{
+    bool           found;
+    GroupLookupTag tag;
+    GroupLookupEnt *ent;
+    GroupShardInfo *info;
+
+    tag.group = group;
+    ent = (GroupLookupEnt*)hash_search(g_GroupHashTab, (void *) &tag, HASH_FIND, &found);
+    if (!found)
+    {
+        return NULL;
+    }
+
+    info = g_GroupShardingMgr->members[ent->shardIndex];
+    if (info->group != group || info->shardMapStatus != SHMEM_SHRADMAP_STATUS_USING)
+    {
+        return NULL;
+    }
+
+    return info;
+}
+
+/*
+ * Do the shard maps of the two groups place every shard on the same node?
+ * The rows of tables in such groups are co-located by their shard keys, the
+ * same as if the tables were in one group. Groups cloned from one template
+ * are the usual case.
+ */
+bool ShardMapsIdentical(Oid group1, Oid group2)
+{
+    bool           needLock = false;
+    bool           result = false;
+    GroupShardInfo *info1;
+    GroupShardInfo *info2;
+    int32          i;
+
+    if (group1 == group2)
+    {
+        return true;
+    }
+
+    /* A datanode knows the shard map of its own group only */
+    if (!IS_PGXC_COORDINATOR || !OidIsValid(group1) || !OidIsValid(group2))
+    {
+        return false;
+    }
+
+    needLock = g_GroupShardingMgr->needLock;
+    if (needLock)
+    {
+        LWLockAcquire(ShardMapLock, LW_SHARED);
+    }
+
+    info1 = GetUsingGroupShardInfo_CN(group1);
+    info2 = GetUsingGroupShardInfo_CN(group2);
+    if (info1 && info2 &&
+        EQ_CRC32C(info1->shmemMapFingerprint, info2->shmemMapFingerprint) &&
+        info1->shmemNumShards == info2->shmemNumShards)
+    {
+        result = true;
+        for (i = 0; i < info1->shmemNumShards; i++)
+        {
+            if (info1->shmemshardmap[i].nodeindex != info2->shmemshardmap[i].nodeindex)
+            {
+                result = false;
+                break;
+            }
+        }
+    }
+
+    if (needLock)
+    {
+        LWLockRelease(ShardMapLock);
+    }
+    return result;
+}
+
+/*
+ * Reset the cached plans if the shard maps changed since the last call.
+ *
+ * A plan may join tables of different groups without redistribution because
+ * their shard maps were identical when it was made (ShardMapsIdentical).
+ * Moving a shard in one of the groups breaks that, so no plan made before a
+ * change of the maps may be used after it.
+ */
+void ResetPlansOnShardMapChange(void)
+{
+    static uint64 plannedGeneration = 0;
+    uint64        generation;
+
+    if (!IS_PGXC_COORDINATOR || g_GroupShardingMgr == NULL)
+    {
+        return;
+    }
+
+    generation = pg_atomic_read_u64(&g_GroupShardingMgr->generation);
+    if (generation != plannedGeneration)
+    {
+        plannedGeneration = generation;
+        ResetPlanCache();
+    }
+}
+
+/*
+ * Add the group to the groups a query involves, unless the shard map of one
+ * of them is identical to its own: the planner treats the query as being in
+ * one group then.
+ */
+List *AppendShardMapGroup(List *groups, Oid group)
+{
+    ListCell *lc;
+
+    foreach(lc, groups)
+    {
+        if (ShardMapsIdentical(lfirst_oid(lc), group))
+        {
+            return groups;
+        }
+    }
+
+    return lappend_oid(groups, group);
+}
+
+/*
+ * Are the tables sharded in the groups co-located by their shard keys? The
+ * groups are those of the two sides of a join, added by AppendShardMapGroup,
+ * so no two of them place every shard alike and at most one may have a shard
+ * map.
+ */
+bool ShardGroupsColocated(List *groups)
+{
+    bool     needLock = false;
+    int      count = 0;
+    ListCell *lc;
+
+    if (!IS_PGXC_COORDINATOR || list_length(groups) < 2)
+    {
+        return true;
+    }
+
+    needLock = g_GroupShardingMgr->needLock;
+    if (needLock)
+    {
+        LWLockAcquire(ShardMapLock, LW_SHARED);
+    }
+
+    foreach(lc, groups)
+    {
+        if (GetUsingGroupShardInfo_CN(lfirst_oid(lc)))
+        {
+            count++;
+        }
+    }
+
+    if (needLock)
+    {
+        LWLockRelease(ShardMapLock);
+    }
+    return count <= 1;
+}
 
 void GetShardNodes(Oid group, int32 ** nodes, int32 *num_nodes, bool *isextension)
 {
@@ -1942,6 +2291,7 @@ void UpdateReplicaRelNodes(Oid newnodeid)
 void ForceRefreshShardMap(Oid groupoid)
 {
     LWLockAcquire(ShardMapLock, LW_EXCLUSIVE);
+    ShardMapBumpGeneration();
     if(!OidIsValid(groupoid))
     {    
         if (IS_PGXC_COORDINATOR)
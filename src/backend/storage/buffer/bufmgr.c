@@ -60,6 +60,10 @@
 #include "utils/relcrypt.h"
 #include "storage/relcryptstorage.h"
 #endif
+#ifdef _SHARDING_
+#include "storage/extentcache.h"
+#include "storage/zonemap.h"
+#endif
 
 
 /* Note: these two macros only work on shared buffers, not local ones! */
@@ -1593,6 +1597,12 @@ MarkBufferDirty(Buffer buffer)
     Assert(LWLockHeldByMeInMode(BufferDescriptorGetContentLock(bufHdr),
                                 LW_EXCLUSIVE));
 
+#ifdef _SHARDING_
+    /* a cached copy of an extent map page is stale now */
+    if (bufHdr->tag.forkNum == EXTENT_FORKNUM)
+        ExtentCacheInvalidatePage(bufHdr->tag.rnode, bufHdr->tag.blockNum);
+#endif
+
     old_buf_state = pg_atomic_read_u32(&bufHdr->state);
     for (;;)
     {
@@ -3130,6 +3140,11 @@ DropRelFileNodeBuffers(RelFileNodeBackend rnode, ForkNumber forkNum,
         return;
     }
 
+#ifdef _SHARDING_
+    if (forkNum == EXTENT_FORKNUM)
+        ExtentCacheInvalidateRel(rnode.node);
+#endif
+
     for (i = 0; i < NBuffers; i++)
     {
         BufferDesc *bufHdr = GetBufferDescriptor(i);
@@ -3195,7 +3210,13 @@ DropRelFileNodesAllBuffers(RelFileNodeBackend *rnodes, int nnodes)
                 DropRelFileNodeAllLocalBuffers(rnodes[i].node);
         }
         else
+        {
+#ifdef _SHARDING_
+            ExtentCacheInvalidateRel(rnodes[i].node);
+            ZoneMapInvalidateRel(rnodes[i].node);
+#endif
             nodes[n++] = rnodes[i].node;
+        }
     }
 
     /*
@@ -3286,6 +3307,11 @@ DropDatabaseBuffers(Oid dbid)
      * database isn't our own.
      */
 
+#ifdef _SHARDING_
+    ExtentCacheInvalidateDatabase(dbid);
+    ZoneMapInvalidateDatabase(dbid);
+#endif
+
     for (i = 0; i < NBuffers; i++)
     {
         BufferDesc *bufHdr = GetBufferDescriptor(i);
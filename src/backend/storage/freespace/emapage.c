@@ -94,6 +94,7 @@
 #include "nodes/bitmapset.h"
 #include "utils/rel.h"
 #include "storage/bufmgr.h"
+#include "storage/extentcache.h"
 #include "storage/extentmapping.h"
 #include "storage/freespace.h"
 #include "storage/extent_xlog.h"
@@ -241,6 +242,9 @@ extent_readbuffer(Relation rel, BlockNumber blkno, bool extend)
                 elog(PANIC, "page type %d is not supported.", pagetype);
                 break;
         }
+        /* not dirtied, but a page zeroed on error may be cached */
+        if (!RelationUsesLocalBuffers(rel))
+            ExtentCacheInvalidatePage(rel->rd_node, blkno);
 		LockBuffer(buf, BUFFER_LOCK_UNLOCK);
     }
     return buf;
@@ -1110,6 +1114,9 @@ esa_get_anchor(Relation rel, ShardID sid)
     ESAPage esa_pg;
     EMAShardAnchor anchor;
 
+    if (ExtentCacheGetAnchor(rel, sid, &anchor))
+        return anchor;
+
     addr = esa_sid_to_address(sid);
 
     Assert(ESAAddressIsValid(&addr));
@@ -1129,6 +1136,7 @@ esa_get_anchor(Relation rel, ShardID sid)
     pg = BufferGetPage(buf);
     esa_pg = (ESAPage)PageGetContents(pg);
     anchor = esa_pg->anchors[addr.local_idx];
+    ExtentCachePutESA(rel, addr.physical_page_number, pg);
     UnlockReleaseBuffer(buf);
 
     return anchor;
@@ -1512,6 +1520,20 @@ ema_get_eme_extract(Relation rel, ExtentID eid,
     EMAAddress    addr;
     Buffer         buf;
     Page        pg;
+    ExtentMappingElement eme;
+
+    if (ExtentCacheGetEME(rel, eid, &eme))
+    {
+        if(is_occupied)
+            *is_occupied = (bool)eme.is_occupied;
+        if(sid)
+            *sid = (ShardID)eme.shardid;
+        if(hwm)
+            *hwm = eme.hwm;
+        if(freespace)
+            *freespace = (uint8)eme.max_freespace;
+        return;
+    }
 
     addr = ema_eid_to_address(eid);
     buf = extent_readbuffer(rel, addr.physical_page_number, false);
@@ -1521,6 +1543,7 @@ ema_get_eme_extract(Relation rel, ExtentID eid,
     pg = BufferGetPage(buf);
 
     ema_page_get_eme_extract(pg, addr.local_idx, is_occupied, sid, hwm, freespace);
+    ExtentCachePutEMA(rel, addr.physical_page_number, pg);
 
     UnlockReleaseBuffer(buf);
 }
@@ -5746,6 +5769,97 @@ RelOidGetShardScanHead(Oid reloid, ShardID sid)
     return scanhead;
 }
 
+/*
+ * Extents of the first nblocks pages of the relation that belong to one of
+ * the shards, in ascending order, for a scan to read only their pages. If
+ * shardids is not NULL, it is set to the shard of every extent.
+ *
+ * The EMA pages are read in order, or their copies in the extent map cache,
+ * rather than the scan lists of the shards walked, as one EMA page tells
+ * the shards of EMES_PER_PAGE extents. An
+ * extent the map does not describe is returned too, its pages are checked
+ * by the scan then.
+ */
+ExtentID *
+GetShardExtents(Relation rel, Bitmapset *shards, BlockNumber nblocks,
+                int *nextents, ShardID **shardids)
+{
+    ExtentID    max_eid = (nblocks + PAGES_PER_EXTENTS - 1) / PAGES_PER_EXTENTS;
+    ExtentID   *extents;
+    ShardID    *sids = NULL;
+    ExtentID    eid = 0;
+    int         n = 0;
+    ExtentMappingElement *cached;
+
+    cached = (ExtentMappingElement *) palloc(sizeof(ExtentMappingElement) * EMES_PER_PAGE);
+
+    extents = (ExtentID *) palloc(sizeof(ExtentID) * Max(max_eid, 1));
+    if (shardids)
+        sids = (ShardID *) palloc(sizeof(ShardID) * Max(max_eid, 1));
+
+    while (eid < max_eid)
+    {
+        EMAAddress  addr = ema_eid_to_address(eid);
+        Buffer      buf = InvalidBuffer;
+        ExtentMappingElement *emes = cached;
+        int32       n_emes;
+        int         i;
+
+        if (!ExtentCacheGetEMAPage(rel, addr.physical_page_number,
+                                   cached, &n_emes))
+        {
+            EMAPage     pg;
+
+            buf = extent_readbuffer(rel, addr.physical_page_number, false);
+            if (!BufferIsValid(buf))
+            {
+                /* the map ends before the relation does */
+                while (eid < max_eid)
+                {
+                    if (sids)
+                        sids[n] = InvalidShardID;
+                    extents[n++] = eid++;
+                }
+                break;
+            }
+
+            LockBuffer(buf, BUFFER_LOCK_SHARE);
+            pg = (EMAPage) PageGetContents(BufferGetPage(buf));
+            emes = pg->ema;
+            n_emes = pg->n_emes;
+        }
+
+        for (i = addr.local_idx; i < EMES_PER_PAGE && eid < max_eid; i++, eid++)
+        {
+            if (i >= n_emes)
+            {
+                if (sids)
+                    sids[n] = InvalidShardID;
+                extents[n++] = eid;
+            }
+            else if (emes[i].is_occupied &&
+                     bms_is_member(emes[i].shardid, shards))
+            {
+                if (sids)
+                    sids[n] = emes[i].shardid;
+                extents[n++] = eid;
+            }
+        }
+
+        if (BufferIsValid(buf))
+        {
+            ExtentCachePutEMA(rel, addr.physical_page_number, BufferGetPage(buf));
+            UnlockReleaseBuffer(buf);
+        }
+    }
+
+    pfree(cached);
+    *nextents = n;
+    if (shardids)
+        *shardids = sids;
+    return extents;
+}
+
 #if 0
 static int
 next_free_extent(EOBPage eob_pg, int search_from)
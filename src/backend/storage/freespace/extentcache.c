@@ -0,0 +1,463 @@
+/*-------------------------------------------------------------------------
+ *
+ * extentcache.c
+ *	  Shared-memory cache of the extent map
+ *
+ * Looking up the shard of an extent, or the anchor of a shard, pins and
+ * share-locks an EMA or ESA page of the extent fork. This cache keeps in
+ * shared memory a compact copy of the map pages looked up: of an EMA page,
+ * the word of every extent telling its shard, free space, high water mark
+ * and occupation, without the list links; of an ESA page, the anchors of
+ * its shards. Lookups read the copies without taking any lock, and go to
+ * the page when they miss.
+ *
+ * The slots are direct-mapped by relfilenode and block number. The version
+ * of a slot is odd while the slot is written, and changes whenever a page
+ * mapped to the slot changes: MarkBufferDirty() of an extent fork page
+ * invalidates the slot of the page, which covers the changes of the map as
+ * well as their WAL replay. A reader copies what it looks for between two
+ * reads of the version, and drops the copy if they differ. A slot is only
+ * filled while the page is share-locked, so no change can be made to the
+ * page meanwhile and go unnoticed. Dropping the buffers of the extent fork
+ * of a relation, or of its database, invalidates its slots too.
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/storage/freespace/extentcache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "port/atomics.h"
+#include "storage/extentcache.h"
+#include "storage/s_lock.h"
+#include "storage/shmem.h"
+#include "utils/hsearch.h"
+#include "utils/rel.h"
+
+/* GUC parameters */
+int			extent_map_cache_size = 1024;
+
+/* a relation has few ESA pages, see ESA_MAXPAGES */
+#define ESA_CACHE_SLOTS(ema_slots)	Max((ema_slots) / 8, 16)
+
+typedef struct ExtentCacheTag
+{
+	RelFileNode rnode;
+	BlockNumber blkno;			/* InvalidBlockNumber if the slot is empty */
+} ExtentCacheTag;
+
+typedef struct EMACacheSlot
+{
+	pg_atomic_uint32 version;	/* odd while the slot is written */
+	ExtentCacheTag tag;
+	int32		n_emes;
+	uint32		emes[EMES_PER_PAGE];	/* first word of every EME: shard,
+										 * free space, hwm and occupation */
+} EMACacheSlot;
+
+typedef struct ESACacheSlot
+{
+	pg_atomic_uint32 version;	/* odd while the slot is written */
+	ExtentCacheTag tag;
+	EMAShardAnchor anchors[ESAS_PER_PAGE];
+} ESACacheSlot;
+
+typedef struct ExtentCacheShmemStruct
+{
+	int			n_ema_slots;
+	int			n_esa_slots;
+	EMACacheSlot *ema_slots;
+	ESACacheSlot *esa_slots;
+} ExtentCacheShmemStruct;
+
+static ExtentCacheShmemStruct *ExtentCacheShmem = NULL;
+
+static bool extent_cache_usable(Relation rel);
+static uint32 extent_cache_hash(RelFileNode rnode, BlockNumber blkno);
+static bool slot_try_lock(pg_atomic_uint32 *version);
+static void slot_lock(pg_atomic_uint32 *version);
+static void slot_unlock(pg_atomic_uint32 *version);
+
+
+Size
+ExtentCacheShmemSize(void)
+{
+	Size		size;
+
+	size = MAXALIGN(sizeof(ExtentCacheShmemStruct));
+	if (extent_map_cache_size > 0)
+	{
+		size = add_size(size, mul_size(sizeof(EMACacheSlot),
+									   extent_map_cache_size));
+		size = add_size(size, mul_size(sizeof(ESACacheSlot),
+									   ESA_CACHE_SLOTS(extent_map_cache_size)));
+	}
+	return size;
+}
+
+void
+ExtentCacheShmemInit(void)
+{
+	bool		found;
+	char	   *ptr;
+	int			i;
+
+	ptr = ShmemInitStruct("Extent Map Cache", ExtentCacheShmemSize(), &found);
+	ExtentCacheShmem = (ExtentCacheShmemStruct *) ptr;
+
+	if (found)
+		return;
+
+	ExtentCacheShmem->n_ema_slots = Max(extent_map_cache_size, 0);
+	ExtentCacheShmem->n_esa_slots = extent_map_cache_size > 0 ?
+		ESA_CACHE_SLOTS(extent_map_cache_size) : 0;
+
+	ptr += MAXALIGN(sizeof(ExtentCacheShmemStruct));
+	ExtentCacheShmem->ema_slots = (EMACacheSlot *) ptr;
+	ptr += sizeof(EMACacheSlot) * ExtentCacheShmem->n_ema_slots;
+	ExtentCacheShmem->esa_slots = (ESACacheSlot *) ptr;
+
+	for (i = 0; i < ExtentCacheShmem->n_ema_slots; i++)
+	{
+		pg_atomic_init_u32(&ExtentCacheShmem->ema_slots[i].version, 0);
+		ExtentCacheShmem->ema_slots[i].tag.blkno = InvalidBlockNumber;
+	}
+	for (i = 0; i < ExtentCacheShmem->n_esa_slots; i++)
+	{
+		pg_atomic_init_u32(&ExtentCacheShmem->esa_slots[i].version, 0);
+		ExtentCacheShmem->esa_slots[i].tag.blkno = InvalidBlockNumber;
+	}
+}
+
+static bool
+extent_cache_usable(Relation rel)
+{
+	return ExtentCacheShmem != NULL && ExtentCacheShmem->n_ema_slots > 0 &&
+		!RelationUsesLocalBuffers(rel);
+}
+
+static uint32
+extent_cache_hash(RelFileNode rnode, BlockNumber blkno)
+{
+	ExtentCacheTag tag;
+
+	tag.rnode = rnode;
+	tag.blkno = blkno;
+	return tag_hash(&tag, sizeof(ExtentCacheTag));
+}
+
+#define EMA_SLOT(rnode, blkno) \
+	(&ExtentCacheShmem->ema_slots[extent_cache_hash(rnode, blkno) % \
+								  ExtentCacheShmem->n_ema_slots])
+#define ESA_SLOT(rnode, blkno) \
+	(&ExtentCacheShmem->esa_slots[extent_cache_hash(rnode, blkno) % \
+								  ExtentCacheShmem->n_esa_slots])
+#define SLOT_HOLDS(slot, node, blk) \
+	((slot)->tag.blkno == (blk) && RelFileNodeEquals((slot)->tag.rnode, node))
+
+/* take the slot to fill it, unless it is being written */
+static bool
+slot_try_lock(pg_atomic_uint32 *version)
+{
+	uint32		v = pg_atomic_read_u32(version);
+
+	if (v & 1)
+		return false;
+	return pg_atomic_compare_exchange_u32(version, &v, v + 1);
+}
+
+/* take the slot to invalidate it, waiting for a fill to end */
+static void
+slot_lock(pg_atomic_uint32 *version)
+{
+	SpinDelayStatus delay;
+
+	init_local_spin_delay(&delay);
+	for (;;)
+	{
+		uint32		v = pg_atomic_read_u32(version);
+
+		if (!(v & 1) && pg_atomic_compare_exchange_u32(version, &v, v + 1))
+			break;
+		perform_spin_delay(&delay);
+	}
+	finish_spin_delay(&delay);
+}
+
+static void
+slot_unlock(pg_atomic_uint32 *version)
+{
+	/* a full barrier, the writes are done before the version is even */
+	pg_atomic_fetch_add_u32(version, 1);
+}
+
+/*
+ * Shard, free space, high water mark and occupation of the extent, set in
+ * eme if the cache has them. The links of eme are not set.
+ */
+bool
+ExtentCacheGetEME(Relation rel, ExtentID eid, ExtentMappingElement *eme)
+{
+	EMAAddress	addr;
+	EMACacheSlot *slot;
+	uint32		v;
+	uint32		word = 0;
+	bool		hit;
+
+	if (!extent_cache_usable(rel))
+		return false;
+
+	addr = ema_eid_to_address(eid);
+	slot = EMA_SLOT(rel->rd_node, addr.physical_page_number);
+
+	v = pg_atomic_read_u32(&slot->version);
+	if (v & 1)
+		return false;
+	pg_read_barrier();
+	hit = SLOT_HOLDS(slot, rel->rd_node, addr.physical_page_number);
+	if (hit)
+		word = slot->emes[addr.local_idx];
+	pg_read_barrier();
+	if (!hit || pg_atomic_read_u32(&slot->version) != v)
+		return false;
+
+	memset(eme, 0, sizeof(ExtentMappingElement));
+	memcpy(eme, &word, sizeof(uint32));
+	return true;
+}
+
+/*
+ * The EMEs of an EMA page, set in emes with their links unset, if the
+ * cache has the page.
+ */
+bool
+ExtentCacheGetEMAPage(Relation rel, BlockNumber blkno,
+					  ExtentMappingElement *emes, int32 *n_emes)
+{
+	EMACacheSlot *slot;
+	uint32		words[EMES_PER_PAGE];
+	uint32		v;
+	int32		n = 0;
+	bool		hit;
+	int			i;
+
+	if (!extent_cache_usable(rel))
+		return false;
+
+	slot = EMA_SLOT(rel->rd_node, blkno);
+
+	v = pg_atomic_read_u32(&slot->version);
+	if (v & 1)
+		return false;
+	pg_read_barrier();
+	hit = SLOT_HOLDS(slot, rel->rd_node, blkno);
+	if (hit)
+	{
+		n = slot->n_emes;
+		memcpy(words, slot->emes, sizeof(words));
+	}
+	pg_read_barrier();
+	if (!hit || pg_atomic_read_u32(&slot->version) != v)
+		return false;
+
+	memset(emes, 0, sizeof(ExtentMappingElement) * EMES_PER_PAGE);
+	for (i = 0; i < EMES_PER_PAGE; i++)
+		memcpy(&emes[i], &words[i], sizeof(uint32));
+	*n_emes = n;
+	return true;
+}
+
+/*
+ * Keep a copy of an EMA page of the relation. The caller holds a lock on
+ * the page.
+ */
+void
+ExtentCachePutEMA(Relation rel, BlockNumber blkno, Page page)
+{
+	EMAPage		pg = (EMAPage) PageGetContents(page);
+	EMACacheSlot *slot;
+	int			i;
+
+	if (!extent_cache_usable(rel))
+		return;
+
+	slot = EMA_SLOT(rel->rd_node, blkno);
+	if (!slot_try_lock(&slot->version))
+		return;
+
+	slot->tag.rnode = rel->rd_node;
+	slot->tag.blkno = blkno;
+	slot->n_emes = pg->n_emes;
+	for (i = 0; i < EMES_PER_PAGE; i++)
+		memcpy(&slot->emes[i], &pg->ema[i], sizeof(uint32));
+
+	slot_unlock(&slot->version);
+}
+
+/*
+ * Anchor of the shard in the relation, if the cache has it.
+ */
+bool
+ExtentCacheGetAnchor(Relation rel, ShardID sid, EMAShardAnchor *anchor)
+{
+	ESAAddress	addr;
+	ESACacheSlot *slot;
+	EMAShardAnchor copy;
+	uint32		v;
+	bool		hit;
+
+	if (!extent_cache_usable(rel))
+		return false;
+
+	addr = esa_sid_to_address(sid);
+	slot = ESA_SLOT(rel->rd_node, addr.physical_page_number);
+
+	v = pg_atomic_read_u32(&slot->version);
+	if (v & 1)
+		return false;
+	pg_read_barrier();
+	hit = SLOT_HOLDS(slot, rel->rd_node, addr.physical_page_number);
+	if (hit)
+		copy = slot->anchors[addr.local_idx];
+	pg_read_barrier();
+	if (!hit || pg_atomic_read_u32(&slot->version) != v)
+		return false;
+
+	*anchor = copy;
+	return true;
+}
+
+/*
+ * Keep a copy of an ESA page of the relation. The caller holds a lock on
+ * the page.
+ */
+void
+ExtentCachePutESA(Relation rel, BlockNumber blkno, Page page)
+{
+	ESAPage		pg = (ESAPage) PageGetContents(page);
+	ESACacheSlot *slot;
+
+	if (!extent_cache_usable(rel))
+		return;
+
+	slot = ESA_SLOT(rel->rd_node, blkno);
+	if (!slot_try_lock(&slot->version))
+		return;
+
+	slot->tag.rnode = rel->rd_node;
+	slot->tag.blkno = blkno;
+	memcpy(slot->anchors, pg->anchors, sizeof(slot->anchors));
+
+	slot_unlock(&slot->version);
+}
+
+/*
+ * A page of the extent fork of the relation changes. Called with the page
+ * exclusively locked, by MarkBufferDirty().
+ *
+ * The slot is invalidated even if it holds another page, as the page may
+ * be being copied into it.
+ */
+void
+ExtentCacheInvalidatePage(RelFileNode rnode, BlockNumber blkno)
+{
+	pg_atomic_uint32 *version;
+	ExtentCacheTag *tag;
+
+	if (ExtentCacheShmem == NULL || ExtentCacheShmem->n_ema_slots == 0)
+		return;
+
+	if (blkno >= EMAPAGE_OFFSET)
+	{
+		EMACacheSlot *slot = EMA_SLOT(rnode, blkno);
+
+		version = &slot->version;
+		tag = &slot->tag;
+	}
+	else if (blkno >= ESAPAGE_OFFSET)
+	{
+		ESACacheSlot *slot = ESA_SLOT(rnode, blkno);
+
+		version = &slot->version;
+		tag = &slot->tag;
+	}
+	else
+		return;					/* EOB pages are not cached */
+
+	slot_lock(version);
+	tag->blkno = InvalidBlockNumber;
+	slot_unlock(version);
+}
+
+/*
+ * The buffers of the extent fork of the relation are dropped. The relation
+ * is locked so that no page of it is being copied into a slot.
+ */
+void
+ExtentCacheInvalidateRel(RelFileNode rnode)
+{
+	int			i;
+
+	if (ExtentCacheShmem == NULL)
+		return;
+
+	for (i = 0; i < ExtentCacheShmem->n_ema_slots; i++)
+	{
+		EMACacheSlot *slot = &ExtentCacheShmem->ema_slots[i];
+
+		if (RelFileNodeEquals(slot->tag.rnode, rnode))
+		{
+			slot_lock(&slot->version);
+			slot->tag.blkno = InvalidBlockNumber;
+			slot_unlock(&slot->version);
+		}
+	}
+	for (i = 0; i < ExtentCacheShmem->n_esa_slots; i++)
+	{
+		ESACacheSlot *slot = &ExtentCacheShmem->esa_slots[i];
+
+		if (RelFileNodeEquals(slot->tag.rnode, rnode))
+		{
+			slot_lock(&slot->version);
+			slot->tag.blkno = InvalidBlockNumber;
+			slot_unlock(&slot->version);
+		}
+	}
+}
+
+/*
+ * The buffers of the database are dropped.
+ */
+void
+ExtentCacheInvalidateDatabase(Oid dbid)
+{
+	int			i;
+
+	if (ExtentCacheShmem == NULL)
+		return;
+
+	for (i = 0; i < ExtentCacheShmem->n_ema_slots; i++)
+	{
+		EMACacheSlot *slot = &ExtentCacheShmem->ema_slots[i];
+
+		if (slot->tag.rnode.dbNode == dbid)
+		{
+			slot_lock(&slot->version);
+			slot->tag.blkno = InvalidBlockNumber;
+			slot_unlock(&slot->version);
+		}
+	}
+	for (i = 0; i < ExtentCacheShmem->n_esa_slots; i++)
+	{
+		ESACacheSlot *slot = &ExtentCacheShmem->esa_slots[i];
+
+		if (slot->tag.rnode.dbNode == dbid)
+		{
+			slot_lock(&slot->version);
+			slot->tag.blkno = InvalidBlockNumber;
+			slot_unlock(&slot->version);
+		}
+	}
+}
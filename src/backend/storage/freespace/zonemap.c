@@ -0,0 +1,634 @@
+/*-------------------------------------------------------------------------
+ *
+ * zonemap.c
+ *	  Per-extent min/max summaries of designated columns
+ *
+ * A table of append-mostly data, like a time series, stores rows of close
+ * timestamps or of the same tenant in the same extents. With the
+ * zone_map_columns reloption naming some of its columns, the least and
+ * greatest values of each of them in an extent are kept in shared memory,
+ * and a seq scan skips the extents whose ranges cannot satisfy its quals
+ * on these columns (see heap_setscanzonemap()). Only columns of types
+ * passed by value and ordered by a default btree opclass are summarized.
+ *
+ * Nothing is written to disk. The summary of an extent is built by a
+ * pagemode scan reading the whole extent, and from then on widened by
+ * every tuple put in the extent: heap_insert(), heap_multi_insert() and
+ * heap_update() call ZoneMapNoteInsert() once the tuple is on its page,
+ * and before the transaction putting it commits, so a snapshot seeing
+ * the tuple sees it in the summary. Deleting tuples does not narrow a
+ * summary. A summary covers every tuple of the extent, visible or not.
+ *
+ * The slots are direct-mapped by relfilenode and extent, so a slot keeps
+ * the summary of the last extent mapped to it. The version of a slot
+ * changes at every change of the slot. A scan claims the slot of an extent
+ * before reading its first page, and installs the summary built if the
+ * version did not change meanwhile: a tuple put in the extent while the
+ * summary is built changes it, as it may be on a page read already. Slots
+ * are only held by their spinlock to copy or store ranges, comparisons are
+ * done out of it.
+ *
+ * A standby does not summarize anything as WAL replay does not widen the
+ * summaries. They are dropped with the buffers of the relation or of its
+ * database, and lost at restart.
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/storage/freespace/zonemap.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "access/nbtree.h"
+#include "access/xlog.h"
+#include "catalog/pg_am.h"
+#include "catalog/pg_class.h"
+#include "commands/defrem.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
+#include "storage/zonemap.h"
+#include "utils/builtins.h"
+#include "utils/hsearch.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/varlena.h"
+#ifdef _MLS_
+#include "utils/relcrypt.h"
+#endif
+
+/* GUC parameters */
+bool		enable_zone_map = true;
+int			zone_map_cache_size = 4096;
+
+typedef struct ZoneMapTag
+{
+	RelFileNode rnode;
+	ExtentID	eid;			/* InvalidExtentID if the slot is empty */
+} ZoneMapTag;
+
+typedef struct ZoneMapSlot
+{
+	slock_t		mutex;
+	ZoneMapTag	tag;
+	uint32		version;		/* changes whenever the slot does */
+	bool		valid;			/* ranges summarize the extent */
+	int16		natts;
+	AttrNumber	attnums[ZONEMAP_MAX_COLUMNS];	/* columns summarized */
+	ZoneMapRange ranges[ZONEMAP_MAX_COLUMNS];
+} ZoneMapSlot;
+
+typedef struct ZoneMapShmemStruct
+{
+	int			nslots;
+	ZoneMapSlot *slots;
+} ZoneMapShmemStruct;
+
+static ZoneMapShmemStruct *ZoneMapShmem = NULL;
+
+static bool zone_map_usable(Relation rel);
+static ZoneMapSlot *zone_map_slot(RelFileNode rnode, ExtentID eid);
+static bool slot_holds(ZoneMapSlot *slot, RelFileNode rnode, ExtentID eid,
+		   ZoneMapDesc *desc);
+static bool zone_map_widen(ZoneMapRange *range, Datum value, FmgrInfo *cmp);
+static void zone_map_drop_slots(RelFileNode *rnode, Oid dbid);
+
+
+Size
+ZoneMapShmemSize(void)
+{
+	Size		size;
+
+	size = MAXALIGN(sizeof(ZoneMapShmemStruct));
+	if (zone_map_cache_size > 0)
+		size = add_size(size, mul_size(sizeof(ZoneMapSlot),
+									   zone_map_cache_size));
+	return size;
+}
+
+void
+ZoneMapShmemInit(void)
+{
+	bool		found;
+	char	   *ptr;
+	int			i;
+
+	ptr = ShmemInitStruct("Zone Maps", ZoneMapShmemSize(), &found);
+	ZoneMapShmem = (ZoneMapShmemStruct *) ptr;
+
+	if (found)
+		return;
+
+	ZoneMapShmem->nslots = Max(zone_map_cache_size, 0);
+	ZoneMapShmem->slots = (ZoneMapSlot *)
+		(ptr + MAXALIGN(sizeof(ZoneMapShmemStruct)));
+
+	for (i = 0; i < ZoneMapShmem->nslots; i++)
+	{
+		ZoneMapSlot *slot = &ZoneMapShmem->slots[i];
+
+		SpinLockInit(&slot->mutex);
+		slot->tag.eid = InvalidExtentID;
+		slot->version = 0;
+		slot->valid = false;
+		slot->natts = 0;
+	}
+}
+
+static bool
+zone_map_usable(Relation rel)
+{
+	return ZoneMapShmem != NULL && ZoneMapShmem->nslots > 0 &&
+		!RelationUsesLocalBuffers(rel);
+}
+
+static ZoneMapSlot *
+zone_map_slot(RelFileNode rnode, ExtentID eid)
+{
+	ZoneMapTag	tag;
+
+	tag.rnode = rnode;
+	tag.eid = eid;
+	return &ZoneMapShmem->slots[tag_hash(&tag, sizeof(ZoneMapTag)) %
+								ZoneMapShmem->nslots];
+}
+
+/* does the slot summarize the columns of the extent? Hold its spinlock */
+static bool
+slot_holds(ZoneMapSlot *slot, RelFileNode rnode, ExtentID eid,
+		   ZoneMapDesc *desc)
+{
+	return slot->tag.eid == eid &&
+		RelFileNodeEquals(slot->tag.rnode, rnode) &&
+		slot->natts == desc->natts &&
+		memcmp(slot->attnums, desc->attnums,
+			   sizeof(AttrNumber) * desc->natts) == 0;
+}
+
+/* widen the range to the value, returns true if it changed */
+static bool
+zone_map_widen(ZoneMapRange *range, Datum value, FmgrInfo *cmp)
+{
+	if (!range->hasvalues)
+	{
+		range->hasvalues = true;
+		range->min = range->max = value;
+		return true;
+	}
+	if (DatumGetInt32(FunctionCall2(cmp, value, range->min)) < 0)
+	{
+		range->min = value;
+		return true;
+	}
+	if (DatumGetInt32(FunctionCall2(cmp, value, range->max)) > 0)
+	{
+		range->max = value;
+		return true;
+	}
+	return false;
+}
+
+/*
+ * Validate the zone_map_columns reloption. The columns are looked up when
+ * the relation is used, see RelationGetZoneMap().
+ */
+void
+ZoneMapValidateColumns(char *value)
+{
+	char	   *rawstring;
+	List	   *names;
+
+	if (value == NULL)
+		return;
+
+	rawstring = pstrdup(value);
+	if (!SplitIdentifierString(rawstring, ',', &names))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid value for \"zone_map_columns\" option"),
+				 errdetail("Valid values are lists of column names.")));
+	if (list_length(names) > ZONEMAP_MAX_COLUMNS)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid value for \"zone_map_columns\" option"),
+				 errdetail("At most %d columns can be summarized.",
+						   ZONEMAP_MAX_COLUMNS)));
+
+	list_free(names);
+	pfree(rawstring);
+}
+
+/*
+ * Columns of the relation summarized, NULL if none. The columns named by
+ * zone_map_columns that do not exist or whose type can not be summarized
+ * are left out. Kept in the relcache entry, which is rebuilt when the
+ * reloptions change.
+ */
+ZoneMapDesc *
+RelationGetZoneMap(Relation rel)
+{
+	ZoneMapDesc desc;
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	char	   *columns;
+	char	   *rawstring;
+	List	   *names;
+	ListCell   *lc;
+
+	if (rel->rd_zonemapvalid)
+		return rel->rd_zonemap;
+
+	desc.natts = 0;
+	columns = rel->rd_rel->relkind == RELKIND_RELATION ?
+		RelationGetZoneMapColumns(rel) : NULL;
+	rawstring = columns ? pstrdup(columns) : NULL;
+
+	if (rawstring && SplitIdentifierString(rawstring, ',', &names))
+	{
+		foreach(lc, names)
+		{
+			char	   *name = (char *) lfirst(lc);
+			Form_pg_attribute attr = NULL;
+			Oid			opclass;
+			Oid			opcintype;
+			RegProcedure cmp;
+			int			i;
+
+			for (i = 0; i < tupdesc->natts; i++)
+			{
+				if (!tupdesc->attrs[i]->attisdropped &&
+					namestrcmp(&tupdesc->attrs[i]->attname, name) == 0)
+				{
+					attr = tupdesc->attrs[i];
+					break;
+				}
+			}
+			if (attr == NULL || !attr->attbyval ||
+				desc.natts >= ZONEMAP_MAX_COLUMNS)
+				continue;
+#ifdef _MLS_
+			/* the values of an encrypted column are not compared */
+			if (tupdesc->transp_crypt &&
+				TRANSP_CRYPT_ALGO_ID_IS_VALID(tupdesc->transp_crypt[attr->attnum - 1].algo_id))
+				continue;
+#endif
+			for (i = 0; i < desc.natts; i++)
+			{
+				if (desc.attnums[i] == attr->attnum)
+					break;
+			}
+			if (i < desc.natts)
+				continue;
+
+			opclass = GetDefaultOpClass(attr->atttypid, BTREE_AM_OID);
+			if (!OidIsValid(opclass))
+				continue;
+			opcintype = get_opclass_input_type(opclass);
+			cmp = get_opfamily_proc(get_opclass_family(opclass),
+									opcintype, opcintype, BTORDER_PROC);
+			if (!RegProcedureIsValid(cmp))
+				continue;
+
+			desc.attnums[desc.natts] = attr->attnum;
+			fmgr_info_cxt(cmp, &desc.cmp[desc.natts], CacheMemoryContext);
+			desc.natts++;
+		}
+		list_free(names);
+	}
+	if (rawstring)
+		pfree(rawstring);
+
+	rel->rd_zonemap = NULL;
+	if (desc.natts > 0)
+	{
+		rel->rd_zonemap = (ZoneMapDesc *)
+			MemoryContextAlloc(CacheMemoryContext, sizeof(ZoneMapDesc));
+		memcpy(rel->rd_zonemap, &desc, sizeof(ZoneMapDesc));
+	}
+	rel->rd_zonemapvalid = true;
+
+	return rel->rd_zonemap;
+}
+
+/*
+ * Widen the summary of the extent of a tuple just put on its page. Call
+ * it before the transaction putting it commits.
+ */
+void
+ZoneMapNoteInsert(Relation rel, HeapTuple tuple)
+{
+	ZoneMapDesc *desc = RelationGetZoneMap(rel);
+	ZoneMapSlot *slot;
+	ZoneMapRange ranges[ZONEMAP_MAX_COLUMNS];
+	Datum		values[ZONEMAP_MAX_COLUMNS];
+	bool		isnull[ZONEMAP_MAX_COLUMNS];
+	ExtentID	eid;
+	uint32		version;
+	int			i;
+
+	if (desc == NULL || !zone_map_usable(rel))
+		return;
+
+	eid = ItemPointerGetBlockNumber(&tuple->t_self) / PAGES_PER_EXTENTS;
+	slot = zone_map_slot(rel->rd_node, eid);
+
+	for (i = 0; i < desc->natts; i++)
+		values[i] = heap_getattr(tuple, desc->attnums[i],
+								 RelationGetDescr(rel), &isnull[i]);
+
+	for (;;)
+	{
+		bool		widened = false;
+
+		SpinLockAcquire(&slot->mutex);
+		if (!slot_holds(slot, rel->rd_node, eid, desc))
+		{
+			SpinLockRelease(&slot->mutex);
+			return;
+		}
+		if (!slot->valid)
+		{
+			/* a scan building the summary may have read the page already */
+			slot->version++;
+			SpinLockRelease(&slot->mutex);
+			return;
+		}
+		version = slot->version;
+		memcpy(ranges, slot->ranges, sizeof(ZoneMapRange) * desc->natts);
+		SpinLockRelease(&slot->mutex);
+
+		for (i = 0; i < desc->natts; i++)
+		{
+			if (!isnull[i] && zone_map_widen(&ranges[i], values[i], &desc->cmp[i]))
+				widened = true;
+		}
+		if (!widened)
+			return;
+
+		/* store the ranges widened, unless another tuple widened them */
+		SpinLockAcquire(&slot->mutex);
+		if (slot->version == version)
+		{
+			memcpy(slot->ranges, ranges, sizeof(ZoneMapRange) * desc->natts);
+			slot->version++;
+			SpinLockRelease(&slot->mutex);
+			return;
+		}
+		SpinLockRelease(&slot->mutex);
+	}
+}
+
+/*
+ * A scan is about to read the page: when it is the first page of an extent
+ * not summarized, start building its summary. Only the extents below
+ * nblocks, the end of the scan, are summarized, as the pages added after
+ * them are not read.
+ */
+void
+ZoneMapBuildStart(Relation rel, ZoneMapBuildState *state,
+				  BlockNumber blkno, BlockNumber nblocks)
+{
+	ZoneMapDesc *desc;
+	ZoneMapSlot *slot;
+	ExtentID	eid = blkno / PAGES_PER_EXTENTS;
+	int			i;
+
+	if (eid == state->eid)
+		return;
+
+	state->eid = eid;
+	state->active = false;
+	state->npages = 0;
+
+	desc = RelationGetZoneMap(rel);
+	if (desc == NULL || !zone_map_usable(rel) || RecoveryInProgress() ||
+		blkno != eid * PAGES_PER_EXTENTS ||
+		nblocks - eid * PAGES_PER_EXTENTS < PAGES_PER_EXTENTS)
+		return;
+
+	slot = zone_map_slot(rel->rd_node, eid);
+
+	SpinLockAcquire(&slot->mutex);
+	if (slot_holds(slot, rel->rd_node, eid, desc) && slot->valid)
+	{
+		SpinLockRelease(&slot->mutex);
+		return;
+	}
+	slot->tag.rnode = rel->rd_node;
+	slot->tag.eid = eid;
+	slot->natts = desc->natts;
+	memcpy(slot->attnums, desc->attnums, sizeof(AttrNumber) * desc->natts);
+	slot->valid = false;
+	slot->version++;
+	state->version = slot->version;
+	SpinLockRelease(&slot->mutex);
+
+	for (i = 0; i < desc->natts; i++)
+		state->ranges[i].hasvalues = false;
+	state->active = true;
+}
+
+/*
+ * Add the tuples of page blkno of the extent to the summary built, the page
+ * being share-locked. Once every page of the extent is added, install the
+ * summary unless a tuple was put in the extent meanwhile.
+ *
+ * The pages must come in order, each once: a scroll cursor going back and
+ * forth reads some pages again and may never read others. Anything else
+ * gives up the summary.
+ */
+void
+ZoneMapBuildAddPage(Relation rel, ZoneMapBuildState *state, BlockNumber blkno,
+					Page page)
+{
+	ZoneMapDesc *desc;
+	ZoneMapSlot *slot;
+	OffsetNumber lineoff;
+	OffsetNumber lines;
+
+	if (!state->active)
+		return;
+
+	if (blkno != state->eid * PAGES_PER_EXTENTS + state->npages)
+	{
+		state->active = false;
+		return;
+	}
+
+	desc = RelationGetZoneMap(rel);
+	lines = PageGetMaxOffsetNumber(page);
+	for (lineoff = FirstOffsetNumber; lineoff <= lines; lineoff++)
+	{
+		ItemId		lpp = PageGetItemId(page, lineoff);
+		HeapTupleData tuple;
+		int			i;
+
+		if (!ItemIdIsNormal(lpp))
+			continue;
+
+		tuple.t_data = (HeapTupleHeader) PageGetItem(page, lpp);
+		tuple.t_len = ItemIdGetLength(lpp);
+		for (i = 0; i < desc->natts; i++)
+		{
+			bool		isnull;
+			Datum		value = heap_getattr(&tuple, desc->attnums[i],
+											 RelationGetDescr(rel), &isnull);
+
+			if (!isnull)
+				zone_map_widen(&state->ranges[i], value, &desc->cmp[i]);
+		}
+	}
+
+	if (++state->npages < PAGES_PER_EXTENTS)
+		return;
+
+	state->active = false;
+	slot = zone_map_slot(rel->rd_node, state->eid);
+
+	SpinLockAcquire(&slot->mutex);
+	if (slot->version == state->version &&
+		slot_holds(slot, rel->rd_node, state->eid, desc))
+	{
+		memcpy(slot->ranges, state->ranges, sizeof(ZoneMapRange) * desc->natts);
+		slot->valid = true;
+		slot->version++;
+	}
+	SpinLockRelease(&slot->mutex);
+}
+
+/*
+ * Can tuples of the extent satisfy the keys? The keys on the columns
+ * summarized are btree strategies with the order proc of the operator as
+ * sk_func, comparing a value of the column to sk_argument. Other keys are
+ * ignored. True if the extent is not summarized.
+ */
+bool
+ZoneMapExtentMayMatch(Relation rel, ExtentID eid, ScanKey keys, int nkeys)
+{
+	ZoneMapDesc *desc = RelationGetZoneMap(rel);
+	ZoneMapRange ranges[ZONEMAP_MAX_COLUMNS];
+	ZoneMapSlot *slot;
+	int			k;
+
+	if (desc == NULL || !enable_zone_map || !zone_map_usable(rel))
+		return true;
+
+	slot = zone_map_slot(rel->rd_node, eid);
+
+	SpinLockAcquire(&slot->mutex);
+	if (!slot_holds(slot, rel->rd_node, eid, desc) || !slot->valid)
+	{
+		SpinLockRelease(&slot->mutex);
+		return true;
+	}
+	memcpy(ranges, slot->ranges, sizeof(ZoneMapRange) * desc->natts);
+	SpinLockRelease(&slot->mutex);
+
+	for (k = 0; k < nkeys; k++)
+	{
+		ScanKey		key = &keys[k];
+		ZoneMapRange *range = NULL;
+		int			i;
+
+		if (key->sk_flags & SK_ISNULL)
+			continue;
+		for (i = 0; i < desc->natts; i++)
+		{
+			if (desc->attnums[i] == key->sk_attno)
+			{
+				range = &ranges[i];
+				break;
+			}
+		}
+		if (range == NULL)
+			continue;
+
+		/* the operators are strict, nulls match none */
+		if (!range->hasvalues)
+			return false;
+
+#define ZONE_MAP_CMP(value) \
+		DatumGetInt32(FunctionCall2Coll(&key->sk_func, key->sk_collation, \
+										(value), key->sk_argument))
+
+		switch (key->sk_strategy)
+		{
+			case BTLessStrategyNumber:
+				if (ZONE_MAP_CMP(range->min) >= 0)
+					return false;
+				break;
+			case BTLessEqualStrategyNumber:
+				if (ZONE_MAP_CMP(range->min) > 0)
+					return false;
+				break;
+			case BTEqualStrategyNumber:
+				if (ZONE_MAP_CMP(range->min) > 0 ||
+					ZONE_MAP_CMP(range->max) < 0)
+					return false;
+				break;
+			case BTGreaterEqualStrategyNumber:
+				if (ZONE_MAP_CMP(range->max) < 0)
+					return false;
+				break;
+			case BTGreaterStrategyNumber:
+				if (ZONE_MAP_CMP(range->max) <= 0)
+					return false;
+				break;
+			default:
+				break;
+		}
+#undef ZONE_MAP_CMP
+	}
+
+	return true;
+}
+
+static void
+zone_map_drop_slots(RelFileNode *rnode, Oid dbid)
+{
+	int			i;
+
+	if (ZoneMapShmem == NULL)
+		return;
+
+	for (i = 0; i < ZoneMapShmem->nslots; i++)
+	{
+		ZoneMapSlot *slot = &ZoneMapShmem->slots[i];
+
+#define SLOT_DROPPED(slot) \
+		((slot)->tag.eid != InvalidExtentID && \
+		 (rnode ? RelFileNodeEquals((slot)->tag.rnode, *rnode) : \
+		  (slot)->tag.rnode.dbNode == dbid))
+
+		/* no new summary of the relation can be started meanwhile */
+		if (!SLOT_DROPPED(slot))
+			continue;
+
+		SpinLockAcquire(&slot->mutex);
+		if (SLOT_DROPPED(slot))
+		{
+			slot->tag.eid = InvalidExtentID;
+			slot->valid = false;
+			slot->version++;
+		}
+		SpinLockRelease(&slot->mutex);
+#undef SLOT_DROPPED
+	}
+}
+
+/*
+ * Drop the summaries of a relation whose buffers are dropped, before its
+ * relfilenode can be used again.
+ */
+void
+ZoneMapInvalidateRel(RelFileNode rnode)
+{
+	zone_map_drop_slots(&rnode, InvalidOid);
+}
+
+void
+ZoneMapInvalidateDatabase(Oid dbid)
+{
+	zone_map_drop_slots(NULL, dbid);
+}
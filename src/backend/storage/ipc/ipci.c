@@ -130,6 +130,11 @@
 
 #ifdef _MIGRATE_
 #include "pgxc/shardmap.h"
+#include "pgxc/netcost.h"
+#endif
+#ifdef _SHARDING_
+#include "storage/extentcache.h"
+#include "storage/zonemap.h"
 #endif
 #ifdef __OPENTENBASE__
 #include "storage/nodelock.h"
@@ -293,6 +298,8 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 #endif
 #ifdef _SHARDING_
         size = add_size(size, ShardBarrierShmemSize());
+        size = add_size(size, ExtentCacheShmemSize());
+        size = add_size(size, ZoneMapShmemSize());
 #endif
 #ifdef _MLS_
         size = add_size(size, MlsShmemSize());
@@ -301,6 +308,7 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
         size = add_size(size, UserAuthShmemSize());
         size = add_size(size, NodeLockShmemSize());
         size = add_size(size, ShardStatisticShmemSize());
+        size = add_size(size, NetworkCostShmemSize());
         size = add_size(size, QueryAnalyzeInfoShmemSize());
 #endif
 #ifdef __AUDIT__
@@ -468,11 +476,14 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 
 #ifdef _SHARDING_
     ShardBarrierShmemInit();
+    ExtentCacheShmemInit();
+    ZoneMapShmemInit();
 #endif
 
 #ifdef __OPENTENBASE__
     NodeLockShmemInit();
     ShardStatisticShmemInit();
+    NetworkCostShmemInit();
     QueryAnalyzeInfoInit();
     UserAuthShmemInit();
 #endif
@@ -95,6 +95,7 @@
 #include "pgxc/pgxcnode.h"
 #ifdef XCP
 #include "pgxc/pause.h"
+#include "pgxc/insertbatch.h"
 #include "pgxc/squeue.h"
 #endif
 #include "commands/copy.h"
@@ -1333,6 +1334,9 @@ exec_simple_query(const char *query_string)
         Portal        portal;
         DestReceiver *receiver;
         int16        format;
+#ifdef __OPENTENBASE__
+        bool        insert_batched = false;
+#endif
             /* get this portal's query when has multi parse tree */
         const char  *myself_query_string = isTopLevel ? debug_query_string :
                                            (const char *)get_myself_query_string(debug_query_string, parsetree);
@@ -1398,6 +1402,24 @@ exec_simple_query(const char *query_string)
         /* If we got a cancel signal in parsing or prior command, quit */
         CHECK_FOR_INTERRUPTS();
 
+#ifdef __OPENTENBASE__
+        /*
+         * The INSERTs kept are sent before anything may look at their rows.
+         * A rollback drops them instead: as SAVEPOINT sends them too, the
+         * rows kept all belong to the (sub)transaction being rolled back.
+         */
+        if (IS_PGXC_COORDINATOR && !IsA(parsetree->stmt, InsertStmt))
+        {
+            if (IsA(parsetree->stmt, TransactionStmt) &&
+                (((TransactionStmt *) parsetree->stmt)->kind == TRANS_STMT_ROLLBACK ||
+                 ((TransactionStmt *) parsetree->stmt)->kind == TRANS_STMT_ROLLBACK_TO ||
+                 ((TransactionStmt *) parsetree->stmt)->kind == TRANS_STMT_ROLLBACK_SUBTXN))
+                InsertBatchDiscard();
+            else
+                InsertBatchFlush();
+        }
+#endif
+
         /*
          * Set up a snapshot if parse analysis/planning will need one.
          */
@@ -1427,8 +1449,25 @@ exec_simple_query(const char *query_string)
          */
         oldcontext = MemoryContextSwitchTo(MessageContext);
 
+#ifdef __OPENTENBASE__
+        /* only this analysis may keep an INSERT, see InsertBatchCandidate */
+        insert_batch_analyzing = IS_PGXC_COORDINATOR;
+        PG_TRY();
+        {
+            querytree_list = pg_analyze_and_rewrite(parsetree, query_string,
+                                                    NULL, 0, NULL);
+        }
+        PG_CATCH();
+        {
+            insert_batch_analyzing = false;
+            PG_RE_THROW();
+        }
+        PG_END_TRY();
+        insert_batch_analyzing = false;
+#else
         querytree_list = pg_analyze_and_rewrite(parsetree, query_string,
                                                 NULL, 0, NULL);
+#endif
 #ifdef __AUDIT__
         if (xact_started)
         {
@@ -1487,10 +1526,22 @@ exec_simple_query(const char *query_string)
                 bool success;
                 InsertStmt *insert_stmt = (InsertStmt*)parsetree->stmt;
 
-                plantree_list = transformInsertValuesIntoCopyFrom(NULL, insert_stmt, &success, 
-                                                                  parse->copy_filename, parse);
+                /* a single row may be kept to be sent with the ones to come */
+                if (InsertBatchAdd(insert_stmt, parse))
+                {
+                    plantree_list = NIL;
+                    insert_batched = true;
+                }
+                else
+                    plantree_list = transformInsertValuesIntoCopyFrom(NULL, insert_stmt, &success,
+                                                                      parse->copy_filename, parse);
             }
         }
+
+        /* the INSERTs kept are sent before this one */
+        if (IS_PGXC_COORDINATOR && IsA(parsetree->stmt, InsertStmt) &&
+            !insert_batched)
+            InsertBatchFlush();
 #endif
         /*
          * We don't have to copy anything into the portal, because everything
@@ -1574,6 +1625,9 @@ exec_simple_query(const char *query_string)
         PortalDrop(portal, false);
 
 #ifdef __OPENTENBASE__
+        if (insert_batched)
+            strcpy(completionTag, "INSERT 0 1");
+
         /* remove query info */
         if (distributed_query_analyze)
         {
@@ -2052,7 +2106,9 @@ exec_plan_message(const char *query_string,    /* source of the query */
                   const char *plan_string,        /* encoded plan to execute */
                   char **paramTypeNames,    /* parameter type names */
 				  int numParams,		/* number of parameters */
-				  int instrument_options)		/* explain analyze option */
+				  int instrument_options,		/* explain analyze option */
+				  int cache_slot,		/* where to cache the plan, or -1 */
+				  uint64 plan_key)		/* key of the cached plan */
 {
     MemoryContext oldcontext;
     bool        save_log_statement_stats = log_statement_stats;
@@ -2150,7 +2206,7 @@ exec_plan_message(const char *query_string,    /* source of the query */
      */
 	StorePreparedStatement(stmt_name, psrc, false, true, 'N');
 
-    SetRemoteSubplan(psrc, plan_string);
+    SetRemoteSubplan(psrc, plan_string, cache_slot, plan_key);
 	/* set instrument_options, default 0 */
 	psrc->instrument_options = instrument_options;
 
@@ -2789,6 +2845,13 @@ exec_bind_message(StringInfo input_message)
 		shard_map = pq_getmsgstring(input_message);
 		if (shard_map[0] != '\0')
 			DeserializeShardmap(shard_map);
+
+		/* Get the exchange chosen at run time */
+		if (input_message->cursor < input_message->len)
+		{
+			portal->adaptive = pq_getmsgbyte(input_message);
+			portal->adaptive_rows = pq_getmsgint(input_message, 4);
+		}
 	}
 	
     pq_getmsgend(input_message);
@@ -3041,6 +3104,12 @@ exec_execute_message(const char *portal_name, long max_rows)
                         "commands ignored until end of transaction block"),
                  errdetail_abort()));
 
+#ifdef __OPENTENBASE__
+    /* the INSERTs kept by simple queries are sent before the portal runs */
+    if (IS_PGXC_COORDINATOR)
+        InsertBatchFlush();
+#endif
+
     /* Check for cancel signal before we start execution */
     CHECK_FOR_INTERRUPTS();
 
@@ -3116,7 +3185,7 @@ exec_execute_message(const char *portal_name, long max_rows)
 		    desc != NULL &&
 		    desc->myindex == -1)
 		{
-			SendLocalInstr(desc->planstate);
+			SendLocalInstr(desc->planstate, desc->dest);
 		}
 #endif
         /* Send appropriate CommandComplete to client */
@@ -5585,6 +5654,8 @@ PostgresMain(int argc, char *argv[],
                     int            numParams;
                     char       **paramTypes = NULL;
 					int         instrument_options = 0;
+					int         cache_slot;
+					uint64      plan_key;
 
                     /* Set statement_timestamp() */
                     SetCurrentStatementStartTimestamp();
@@ -5603,12 +5674,28 @@ PostgresMain(int argc, char *argv[],
                     }
 					
 					instrument_options = pq_getmsgint(&input_message, 4);
+					/*
+					 * Cache slot and plan key follow if the sender caches
+					 * the fragment, an empty plan_string then refers to the
+					 * plan cached in the slot.
+					 */
+					if (input_message.cursor < input_message.len)
+					{
+						cache_slot = (int16) pq_getmsgint(&input_message, 2);
+						plan_key = (uint64) pq_getmsgint64(&input_message);
+					}
+					else
+					{
+						cache_slot = -1;
+						plan_key = 0;
+					}
 					
                     pq_getmsgend(&input_message);
 
                     exec_plan_message(query_string, stmt_name, plan_string,
 									  paramTypes, numParams,
-									  instrument_options);
+									  instrument_options,
+									  cache_slot, plan_key);
                 }
                 break;
 #endif
@@ -266,7 +266,7 @@ ProcessQuery(PlannedStmt *plan,
 #ifdef __OPENTENBASE__
 	if (instrument && queryDesc->planstate)
 	{
-		SendLocalInstr(queryDesc->planstate);
+		SendLocalInstr(queryDesc->planstate, NULL);
 	}
 #endif
 
@@ -971,6 +971,18 @@ PortalStart(Portal portal, ParamListInfo params,
                             queryDesc->sender
 #endif
                                 );
+#ifdef __OPENTENBASE__
+                        /* the consumers may have chosen another exchange */
+                        if (portal->adaptive != SQ_ADAPTIVE_NONE &&
+                            !needParallelSend(queryDesc->squeue))
+                            SetProducerAdaptive(dest, portal->adaptive,
+                                                portal->adaptive_rows,
+                                                queryDesc->plannedstmt->distributionNodes,
+                                                consMap);
+                        /* explain analyze from cn shows the exchange */
+                        if (portal->up_instrument & INSTRUMENT_EXCHANGE)
+                            SetProducerInstrument(dest);
+#endif
                         queryDesc->dest = dest;
 
                         addProducingPortal(portal);
@@ -2677,6 +2689,9 @@ AdvanceProducingPortal(Portal portal, bool can_wait)
             else
                 result = 1;
             tuplestore_select_read_pointer(portal->holdStore, 0);
+#ifdef __OPENTENBASE__
+            ProducerReceiverPause(queryDesc->dest, result == 0);
+#endif
 
             if (result)
             {
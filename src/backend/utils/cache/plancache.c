@@ -88,6 +88,7 @@
 #include "commands/vacuum.h"
 #include "commands/prepare.h"
 #include "optimizer/pgxcship.h"
+#include "pgxc/shardmap.h"
 #endif
 
 /*
@@ -112,6 +113,8 @@ static List *RevalidateCachedQuery(CachedPlanSource *plansource,
 static bool CheckCachedPlan(CachedPlanSource *plansource);
 static CachedPlan *BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
                 ParamListInfo boundParams, QueryEnvironment *queryEnv);
+static CachedPlan *BuildGenericPlan(CachedPlanSource *plansource, List *qlist,
+                 QueryEnvironment *queryEnv);
 static bool choose_custom_plan(CachedPlanSource *plansource,
                    ParamListInfo boundParams);
 static double cached_plan_cost(CachedPlan *plan, bool include_planner);
@@ -124,6 +127,33 @@ static TupleDesc PlanCacheComputeResultDesc(List *stmt_list);
 static void PlanCacheRelCallback(Datum arg, Oid relid);
 static void PlanCacheFuncCallback(Datum arg, int cacheid, uint32 hashvalue);
 static void PlanCacheSysCallback(Datum arg, int cacheid, uint32 hashvalue);
+#ifdef XCP
+/*
+ * RemoteSubplan fragments stored by this session on request of the node that
+ * sends them, in the slot chosen by the sender (see pgxc_node_send_plan).
+ * Later PLAN messages for the same fragment carry the key only.  The parsed
+ * tree is kept along with the string, and is parsed again when the relations
+ * it scans or the catalog objects stringToNode resolves by name change.
+ */
+typedef struct RemoteSubplanCacheEntry
+{
+    uint64        key;            /* key given by the sender, 0 if unused */
+    MemoryContext context;        /* holds plan_string */
+    char       *plan_string;
+    MemoryContext tree_context;    /* holds rstmt and relids */
+    RemoteStmt *rstmt;            /* NULL if not parsed */
+    List       *relids;            /* OIDs of the relations in rstmt->rtable */
+    bool        outdated;        /* rstmt must be parsed again */
+} RemoteSubplanCacheEntry;
+
+static RemoteSubplanCacheEntry *remote_subplan_cache = NULL;
+
+static RemoteStmt *ParseRemoteSubplan(const char *plan_string);
+static RemoteStmt *FetchRemoteSubplan(int cache_slot, uint64 plan_key,
+                   const char *plan_string);
+static void RemoteSubplanRelCallback(Datum arg, Oid relid);
+static void RemoteSubplanSysCallback(Datum arg, int cacheid, uint32 hashvalue);
+#endif
 
 
 /*
@@ -141,6 +171,13 @@ InitPlanCache(void)
     CacheRegisterSyscacheCallback(AMOPOPID, PlanCacheSysCallback, (Datum) 0);
     CacheRegisterSyscacheCallback(FOREIGNSERVEROID, PlanCacheSysCallback, (Datum) 0);
     CacheRegisterSyscacheCallback(FOREIGNDATAWRAPPEROID, PlanCacheSysCallback, (Datum) 0);
+#ifdef XCP
+    CacheRegisterRelcacheCallback(RemoteSubplanRelCallback, (Datum) 0);
+    CacheRegisterSyscacheCallback(PROCOID, RemoteSubplanSysCallback, (Datum) 0);
+    CacheRegisterSyscacheCallback(TYPEOID, RemoteSubplanSysCallback, (Datum) 0);
+    CacheRegisterSyscacheCallback(NAMESPACEOID, RemoteSubplanSysCallback, (Datum) 0);
+    CacheRegisterSyscacheCallback(OPEROID, RemoteSubplanSysCallback, (Datum) 0);
+#endif
 }
 
 /*
@@ -1078,6 +1115,10 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
     plan->stmt_list = plist;
 #ifdef __OPENTENBASE__
     plan->stmt_list_backup = NULL;
+    /* a generic plan routing by a parameter needs no custom plans */
+    plan->fqs_key_param = 0;
+    if (boundParams == NULL && IS_PGXC_COORDINATOR && list_length(plist) == 1)
+        plan->fqs_key_param = pgxc_fqs_key_param(linitial_node(PlannedStmt, plist));
 #endif
 
     /*
@@ -1179,6 +1220,18 @@ choose_custom_plan(CachedPlanSource *plansource, ParamListInfo boundParams)
     if (plansource->cursor_options & CURSOR_OPT_CUSTOM_PLAN)
         return true;
 
+#ifdef __OPENTENBASE__
+    /*
+     * A point query the generic plan ships to the node of its distribution
+     * key parameter is not planned again for every execution, the node is
+     * found at execution from the parameter. GetCachedPlan builds the
+     * generic plan to find out whether the query is one of those.
+     */
+    if (enable_fqs_generic_plan && IS_PGXC_COORDINATOR &&
+        plansource->gplan && plansource->gplan->fqs_key_param > 0)
+        return false;
+#endif
+
     /* Generate custom plans until we have done at least 5 (arbitrary) */
     if (plansource->num_custom_plans < 5)
         return true;
@@ -1288,9 +1341,33 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
     if (useResOwner && !plansource->is_saved)
         elog(ERROR, "cannot apply ResourceOwner to non-saved cached plan");
 
+#ifdef __OPENTENBASE__
+    /* co-location of groups depends on their shard maps */
+    ResetPlansOnShardMapChange();
+#endif
+
     /* Make sure the querytree list is valid and we have parse-time locks */
     qlist = RevalidateCachedQuery(plansource, queryEnv);
 
+#ifdef __OPENTENBASE__
+    /*
+     * Whether the query is a point query routed by a parameter is only known
+     * from its generic plan. Build it the first time, then choose as usual:
+     * unless it is such a query, custom plans are still made first.
+     */
+    if (enable_fqs_generic_plan && IS_PGXC_COORDINATOR &&
+        boundParams != NULL && plansource->generic_cost < 0 &&
+        !IsTransactionStmtPlan(plansource) &&
+        !(plansource->cursor_options &
+          (CURSOR_OPT_GENERIC_PLAN | CURSOR_OPT_CUSTOM_PLAN)) &&
+        !CheckCachedPlan(plansource))
+    {
+        BuildGenericPlan(plansource, qlist, queryEnv);
+        /* the planner may have scribbled on qlist */
+        qlist = NIL;
+    }
+#endif
+
     /* Decide whether to use a custom plan */
     customplan = choose_custom_plan(plansource, boundParams);
 
@@ -1305,27 +1382,7 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
         else
         {
             /* Build a new generic plan */
-            plan = BuildCachedPlan(plansource, qlist, NULL, queryEnv);
-            /* Just make real sure plansource->gplan is clear */
-            ReleaseGenericPlan(plansource);
-            /* Link the new generic plan into the plansource */
-            plansource->gplan = plan;
-            plan->refcount++;
-            /* Immediately reparent into appropriate context */
-            if (plansource->is_saved)
-            {
-                /* saved plans all live under CacheMemoryContext */
-                MemoryContextSetParent(plan->context, CacheMemoryContext);
-                plan->is_saved = true;
-            }
-            else
-            {
-                /* otherwise, it should be a sibling of the plansource */
-                MemoryContextSetParent(plan->context,
-                                       MemoryContextGetParent(plansource->context));
-            }
-            /* Update generic_cost whenever we make a new generic plan */
-            plansource->generic_cost = cached_plan_cost(plan, false);
+            plan = BuildGenericPlan(plansource, qlist, queryEnv);
 
             /*
              * If, based on the now-known value of generic_cost, we'd not have
@@ -1383,6 +1440,40 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
     return plan;
 }
 
+/*
+ * BuildGenericPlan: build a new generic plan and link it into the plansource.
+ */
+static CachedPlan *
+BuildGenericPlan(CachedPlanSource *plansource, List *qlist,
+                 QueryEnvironment *queryEnv)
+{
+    CachedPlan *plan;
+
+    plan = BuildCachedPlan(plansource, qlist, NULL, queryEnv);
+    /* Just make real sure plansource->gplan is clear */
+    ReleaseGenericPlan(plansource);
+    /* Link the new generic plan into the plansource */
+    plansource->gplan = plan;
+    plan->refcount++;
+    /* Immediately reparent into appropriate context */
+    if (plansource->is_saved)
+    {
+        /* saved plans all live under CacheMemoryContext */
+        MemoryContextSetParent(plan->context, CacheMemoryContext);
+        plan->is_saved = true;
+    }
+    else
+    {
+        /* otherwise, it should be a sibling of the plansource */
+        MemoryContextSetParent(plan->context,
+                               MemoryContextGetParent(plansource->context));
+    }
+    /* Update generic_cost whenever we make a new generic plan */
+    plansource->generic_cost = cached_plan_cost(plan, false);
+
+    return plan;
+}
+
 /*
  * ReleaseCachedPlan: release active use of a cached plan.
  *
@@ -2078,8 +2169,167 @@ ResetPlanCache(void)
 
 
 #ifdef XCP
+/*
+ * RemoteSubplanRelCallback
+ *        Mark the parsed trees of the stored fragments using relid outdated.
+ *
+ * A tree being parsed does not have its relids yet and is marked outdated
+ * for any relation.
+ */
+static void
+RemoteSubplanRelCallback(Datum arg, Oid relid)
+{
+    int            i;
+
+    if (remote_subplan_cache == NULL)
+        return;
+
+    for (i = 0; i < SUBPLAN_CACHE_SLOTS; i++)
+    {
+        RemoteSubplanCacheEntry *entry = &remote_subplan_cache[i];
+
+        if (entry->key == 0 || entry->outdated)
+            continue;
+        if (relid == InvalidOid || entry->rstmt == NULL ||
+            list_member_oid(entry->relids, relid))
+            entry->outdated = true;
+    }
+}
+
+/*
+ * RemoteSubplanSysCallback
+ *        Mark the parsed trees of all the stored fragments outdated.
+ */
+static void
+RemoteSubplanSysCallback(Datum arg, int cacheid, uint32 hashvalue)
+{
+    int            i;
+
+    if (remote_subplan_cache == NULL)
+        return;
+
+    for (i = 0; i < SUBPLAN_CACHE_SLOTS; i++)
+        remote_subplan_cache[i].outdated = true;
+}
+
+/*
+ * Restore query plan from the string in the current memory context.
+ */
+static RemoteStmt *
+ParseRemoteSubplan(const char *plan_string)
+{
+    RemoteStmt *rstmt;
+
+    /*
+     * A try-catch block to ensure that we don't leave behind a stale state
+     * if nodeToString fails for whatever reason.
+     *
+     * XXX We should probably rewrite it someday by either passing a
+     * context to nodeToString() or remembering this information somewhere
+     * else which gets reset in case of errors. But for now, this seems
+     * enough.
+     */
+    PG_TRY();
+    {
+        set_portable_input(true);
+        rstmt = (RemoteStmt *) stringToNode((char *) plan_string);
+    }
+    PG_CATCH();
+    {
+        set_portable_input(false);
+        PG_RE_THROW();
+    }
+    PG_END_TRY();
+    set_portable_input(false);
+
+    return rstmt;
+}
+
+/*
+ * Get the query plan of the fragment stored in the cache slot, copied into
+ * the current memory context.  If plan_string is not empty the sender asks
+ * to store it in the slot, otherwise the slot must hold the fragment with
+ * the given key.
+ */
+static RemoteStmt *
+FetchRemoteSubplan(int cache_slot, uint64 plan_key, const char *plan_string)
+{
+    RemoteSubplanCacheEntry *entry;
+
+    if (cache_slot < 0 || cache_slot >= SUBPLAN_CACHE_SLOTS)
+        ereport(ERROR,
+                (errcode(ERRCODE_PROTOCOL_VIOLATION),
+                 errmsg("invalid remote subplan cache slot %d", cache_slot)));
+
+    if (remote_subplan_cache == NULL)
+        remote_subplan_cache = (RemoteSubplanCacheEntry *)
+            MemoryContextAllocZero(CacheMemoryContext,
+                                   SUBPLAN_CACHE_SLOTS * sizeof(RemoteSubplanCacheEntry));
+    entry = &remote_subplan_cache[cache_slot];
+
+    if (plan_string[0] != '\0')
+    {
+        /* replace the fragment stored in the slot */
+        if (entry->context)
+            MemoryContextDelete(entry->context);
+        entry->key = 0;
+        entry->rstmt = NULL;
+        entry->relids = NIL;
+        entry->outdated = false;
+        entry->context = AllocSetContextCreate(CacheMemoryContext,
+                                               "RemoteSubplanCache",
+                                               ALLOCSET_SMALL_SIZES);
+        entry->tree_context = AllocSetContextCreate(entry->context,
+                                                    "RemoteSubplanCacheTree",
+                                                    ALLOCSET_DEFAULT_SIZES);
+        entry->plan_string = MemoryContextStrdup(entry->context, plan_string);
+        entry->key = plan_key;
+    }
+    else if (entry->key == 0 || entry->key != plan_key)
+        ereport(ERROR,
+                (errcode(ERRCODE_PROTOCOL_VIOLATION),
+                 errmsg("remote subplan is not stored in cache slot %d",
+                        cache_slot)));
+
+    /*
+     * Check for shared-cache-inval messages before restoring query plan,
+     * avoid oid conversion and other operations to find old data.
+     */
+    AcceptInvalidationMessages();
+
+    if (entry->rstmt == NULL || entry->outdated)
+    {
+        MemoryContext oldcxt;
+        RemoteStmt *rstmt;
+        List       *relids = NIL;
+        ListCell   *lc;
+
+        entry->rstmt = NULL;
+        entry->relids = NIL;
+        entry->outdated = false;
+        MemoryContextReset(entry->tree_context);
+
+        oldcxt = MemoryContextSwitchTo(entry->tree_context);
+        rstmt = ParseRemoteSubplan(entry->plan_string);
+        foreach(lc, rstmt->rtable)
+        {
+            RangeTblEntry *rte = (RangeTblEntry *) lfirst(lc);
+
+            if (rte->rtekind == RTE_RELATION)
+                relids = lappend_oid(relids, rte->relid);
+        }
+        MemoryContextSwitchTo(oldcxt);
+
+        entry->relids = relids;
+        entry->rstmt = rstmt;
+    }
+
+    return (RemoteStmt *) copyObject(entry->rstmt);
+}
+
 void
-SetRemoteSubplan(CachedPlanSource *plansource, const char *plan_string)
+SetRemoteSubplan(CachedPlanSource *plansource, const char *plan_string,
+                 int cache_slot, uint64 plan_key)
 {// #lizard forgives
     CachedPlan            *plan;
     MemoryContext         plan_context;
@@ -2105,33 +2355,20 @@ SetRemoteSubplan(CachedPlanSource *plansource, const char *plan_string)
     oldcxt = MemoryContextSwitchTo(plan_context);
 
     /*
-     * Restore query plan.
-     *
-     * A try-catch block to ensure that we don't leave behind a stale state
-     * if nodeToString fails for whatever reason.
-     *
-     * XXX We should probably rewrite it someday by either passing a
-     * context to nodeToString() or remembering this information somewhere
-     * else which gets reset in case of errors. But for now, this seems
-     * enough.
+     * Restore query plan, from the copy stored in this session if the sender
+     * asks to cache it.
      */
-    PG_TRY();
+    if (cache_slot >= 0)
+        rstmt = FetchRemoteSubplan(cache_slot, plan_key, plan_string);
+    else
     {
-	    /*
-	     * Check for shared-cache-inval messages before restoring query plan,
-	     * avoid oid conversion and other operations to find old data.
-	     */
+        /*
+         * Check for shared-cache-inval messages before restoring query plan,
+         * avoid oid conversion and other operations to find old data.
+         */
         AcceptInvalidationMessages();
-        set_portable_input(true);
-        rstmt = (RemoteStmt *) stringToNode((char *) plan_string);
+        rstmt = ParseRemoteSubplan(plan_string);
     }
-    PG_CATCH();
-    {
-        set_portable_input(false);
-        PG_RE_THROW();
-    }
-    PG_END_TRY();
-    set_portable_input(false);
 
     stmt = makeNode(PlannedStmt);
 
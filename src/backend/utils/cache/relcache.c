@@ -2766,6 +2766,10 @@ RelationDestroyRelation(Relation relation, bool remember_tupdesc)
 #ifdef PGXC
 	if (relation->rd_locator_info)
 		FreeRelationLocInfo(relation->rd_locator_info);
+#endif
+#ifdef _SHARDING_
+    if (relation->rd_zonemap)
+        pfree(relation->rd_zonemap);
 #endif
     pfree(relation);
 }
@@ -6082,6 +6086,10 @@ load_relcache_init_file(bool shared)
         rel->rd_pkattr = NULL;
         rel->rd_idattr = NULL;
         rel->rd_pubactions = NULL;
+#ifdef _SHARDING_
+        rel->rd_zonemapvalid = false;
+        rel->rd_zonemap = NULL;
+#endif
         rel->rd_statvalid = false;
         rel->rd_statlist = NIL;
         rel->rd_createSubid = InvalidSubTransactionId;
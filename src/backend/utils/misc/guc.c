@@ -83,6 +83,8 @@
 #include "parser/parse_utilcmd.h"
 #include "pgxc/nodemgr.h"
 #include "pgxc/squeue.h"
+#include "pgxc/netcost.h"
+#include "pgxc/insertbatch.h"
 #include "utils/snapmgr.h"
 #endif
 #include "postmaster/autovacuum.h"
@@ -157,6 +159,10 @@
 #ifdef _PUB_SUB_RELIABLE_
 #include "access/xlog.h"
 #endif
+#ifdef _SHARDING_
+#include "storage/extentcache.h"
+#include "storage/zonemap.h"
+#endif
 
 #ifndef PG_KRB_SRVTAB
 #define PG_KRB_SRVTAB ""
@@ -185,6 +191,9 @@ extern char *default_tablespace;
 extern char *temp_tablespaces;
 extern bool ignore_checksum_failure;
 extern bool synchronize_seqscans;
+#ifdef _SHARDING_
+extern bool enable_shard_pruned_scan;
+#endif
 extern bool enable_cold_hot_router_print;
 #ifdef _PUB_SUB_RELIABLE_
 static char * g_wal_stream_type_str;
@@ -1156,6 +1165,68 @@ static struct config_bool ConfigureNamesBool[] =
         true,
         NULL, NULL, NULL
     },
+    {
+        {"enable_fqs_generic_plan", PGC_USERSET, QUERY_TUNING_METHOD,
+            gettext_noop("Enables the generic plan of prepared point queries shipped to the node of a parameter."),
+            gettext_noop("Such queries are not planned again for every execution.")
+        },
+        &enable_fqs_generic_plan,
+        false,
+        NULL, NULL, NULL
+    },
+    {
+        {"enable_adaptive_distribution", PGC_USERSET, QUERY_TUNING_METHOD,
+            gettext_noop("Enables choosing between broadcast and redistribution of hash join inputs at run time."),
+            gettext_noop("The inner side is broadcast if no data node produces more "
+                         "than adaptive_broadcast_rows rows of it.")
+        },
+        &enable_adaptive_distribution,
+        false,
+        NULL, NULL, NULL
+    },
+    {
+        {"enable_adaptive_partial_agg", PGC_USERSET, QUERY_TUNING_METHOD,
+            gettext_noop("Enables partial hash aggregation below a redistribution that stops aggregating at run time."),
+            gettext_noop("The partial aggregation passes the rest of its input through "
+                         "once its hash table outgrows work_mem, or it reduces the first "
+                         "100000 rows less than partial_agg_reduction_ratio.")
+        },
+        &enable_adaptive_partial_agg,
+        false,
+        NULL, NULL, NULL
+    },
+#ifdef _SHARDING_
+    {
+        {"enable_shard_pruned_scan", PGC_USERSET, QUERY_TUNING_METHOD,
+            gettext_noop("Enables sequential scans that read only the extents of the shards they return."),
+            gettext_noop("The extent map tells the extents of the shards visible to the "
+                         "scan, and the extents of the other shards are skipped without being read.")
+        },
+        &enable_shard_pruned_scan,
+        true,
+        NULL, NULL, NULL
+    },
+    {
+        {"enable_zone_map", PGC_USERSET, QUERY_TUNING_METHOD,
+            gettext_noop("Enables sequential scans that skip extents by their zone map."),
+            gettext_noop("The range of the values of the zone_map_columns of a table in an "
+                         "extent tells whether the quals of the scan can match rows of it.")
+        },
+        &enable_zone_map,
+        true,
+        NULL, NULL, NULL
+    },
+#endif
+    {
+        {"enable_network_cost_calibration", PGC_USERSET, QUERY_TUNING_COST,
+            gettext_noop("Enables the planner's use of the network costs measured from executed remote fragments."),
+            gettext_noop("Replaces network_byte_cost and remote_query_cost once measured, "
+                         "see network_cost_time_unit.")
+        },
+        &enable_network_cost_calibration,
+        false,
+        NULL, NULL, NULL
+    },
     {
         {"loose_constraints", PGC_USERSET, COORDINATORS,
             gettext_noop("Relax enforcing of constraints"),
@@ -2462,6 +2533,36 @@ static struct config_bool ConfigureNamesBool[] =
         &PoolSubThreadLogPrint,
         true,
         NULL, NULL, NULL
+    },
+    {
+        {"pool_session_fingerprint", PGC_SIGHUP, DATA_NODES,
+            gettext_noop("Reuse pooled connections by the fingerprint of their session parameters."),
+            gettext_noop("Connections carrying session parameters are returned to pool and "
+                         "handed preferably to sessions with identical parameters.")
+        },
+        &PoolSessionFingerprint,
+        false,
+        NULL, NULL, NULL
+    },
+    {
+        {"pool_demand_prediction", PGC_SIGHUP, DATA_NODES,
+            gettext_noop("Grow node pools ahead of their predicted demand."),
+            gettext_noop("Pooler keeps an hourly profile of the connections in use per node pool, "
+                         "and grows the pool before the predicted peak instead of shrinking it.")
+        },
+        &PoolDemandPrediction,
+        false,
+        NULL, NULL, NULL
+    },
+    {
+        {"enable_subplan_cache", PGC_USERSET, DATA_NODES,
+            gettext_noop("Send RemoteSubplan fragments to data node sessions only once."),
+            gettext_noop("Data node sessions keep recently received fragments parsed, "
+                         "later executions of the same fragment send only its key.")
+        },
+        &enable_subplan_cache,
+        false,
+        NULL, NULL, NULL
     },
 	{
         {"enable_plpgsql_debug_print", PGC_SUSET, CUSTOM_OPTIONS,
@@ -3324,6 +3425,30 @@ static struct config_int ConfigureNamesInt[] =
 #endif
     },
 
+#ifdef _SHARDING_
+    {
+        {"extent_map_cache_size", PGC_POSTMASTER, RESOURCES_MEM,
+            gettext_noop("Sets the number of extent map pages cached in shared memory."),
+            gettext_noop("The cache keeps the shard of every extent and the anchors "
+                         "of the shards looked up. Zero disables it.")
+        },
+        &extent_map_cache_size,
+        1024, 0, INT_MAX / 8192,
+        NULL, NULL, NULL
+    },
+
+    {
+        {"zone_map_cache_size", PGC_POSTMASTER, RESOURCES_MEM,
+            gettext_noop("Sets the number of extent zone maps kept in shared memory."),
+            gettext_noop("Zone maps summarize the zone_map_columns of tables per extent. "
+                         "Zero disables them.")
+        },
+        &zone_map_cache_size,
+        4096, 0, INT_MAX / 1024,
+        NULL, NULL, NULL
+    },
+#endif
+
 #ifdef LOCK_DEBUG
     {
         {"trace_lock_oidmin", PGC_SUSET, DEVELOPER_OPTIONS,
@@ -4444,6 +4569,17 @@ static struct config_int ConfigureNamesInt[] =
         NULL, NULL, NULL
     },
 
+    {
+        {"pool_demand_prewarm_lead", PGC_SIGHUP, DATA_NODES,
+            gettext_noop("How long before a predicted demand peak the node pools are grown."),
+            NULL,
+            GUC_UNIT_MIN
+        },
+        &PoolDemandPrewarmLead,
+        15, 0, 60,
+        NULL, NULL, NULL
+    },
+
     {
         {"max_pool_size", PGC_POSTMASTER, DATA_NODES,
             gettext_noop("Max pool size."),
@@ -4729,6 +4865,52 @@ static struct config_int ConfigureNamesInt[] =
         NULL, NULL, NULL
     },
 
+    {
+        {"remote_dml_batch_size", PGC_USERSET, DATA_NODES,
+            gettext_noop("Number of rows of coordinator-driven DML sent to a datanode before waiting for their results."),
+            gettext_noop("Applies to INSERT, UPDATE and DELETE without AFTER ROW triggers "
+                         "or RETURNING. A value of 1 waits for every row. With larger values "
+                         "the error of a row is reported after the rows sent after it were "
+                         "evaluated, but still by the statement.")
+        },
+        &RemoteDMLBatchSize,
+        1, 1, 10000,
+        NULL, NULL, NULL
+    },
+
+    {
+        {"remote_receive_threads", PGC_USERSET, DATA_NODES,
+            gettext_noop("Number of threads receiving the results of remote subplans into memory."),
+            gettext_noop("Data nodes are drained while the coordinator processes rows. "
+                         "Zero receives in the backend only.")
+        },
+        &RemoteReceiveThreads,
+        0, 0, MAX_REMOTE_RECEIVE_THREADS,
+        NULL, NULL, NULL
+    },
+
+    {
+        {"copy_send_threads", PGC_USERSET, DATA_NODES,
+            gettext_noop("Number of threads sending the rows of COPY FROM to the data nodes."),
+            gettext_noop("The coordinator reads and routes rows while the data nodes receive. "
+                         "Zero sends in the backend only.")
+        },
+        &CopySendThreads,
+        0, 0, MAX_COPY_SEND_THREADS,
+        NULL, NULL, NULL
+    },
+
+    {
+        {"copy_send_queue_size", PGC_USERSET, DATA_NODES,
+            gettext_noop("Sets the rows of COPY FROM queued for a data node by copy_send_threads."),
+            gettext_noop("The coordinator waits for a data node lagging this far behind."),
+            GUC_UNIT_KB
+        },
+        &CopySendQueueSize,
+        4096, 64, MAX_KILOBYTES,
+        NULL, NULL, NULL
+    },
+
     {
         {"replication_level", PGC_USERSET, CUSTOM_OPTIONS,
             gettext_noop("replication level on join to make Query more efficient."),
@@ -4738,6 +4920,16 @@ static struct config_int ConfigureNamesInt[] =
         1, 0, INT_MAX,
         NULL, NULL, NULL
     },
+    {
+        {"adaptive_broadcast_rows", PGC_USERSET, QUERY_TUNING_METHOD,
+            gettext_noop("Sets the most rows a data node may produce for the inner side of "
+                         "a hash join that is still broadcast."),
+            gettext_noop("Used with enable_adaptive_distribution.")
+        },
+        &adaptive_broadcast_rows,
+        1000, 0, INT_MAX,
+        NULL, NULL, NULL
+    },
 	
 	{
 		{"default_hashagg_nbatches", PGC_USERSET, CUSTOM_OPTIONS,
@@ -4953,6 +5145,20 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+    {
+        {"insert_batch_rows", PGC_USERSET, CUSTOM_OPTIONS,
+            gettext_noop("Sets the number of single-row INSERTs in a transaction block "
+                         "the coordinator keeps to send at once."),
+            gettext_noop("A kept INSERT reports \"INSERT 0 1\" without being sent. "
+                         "Errors of the rows kept, such as unique violations, are "
+                         "reported by the later statement sending them. Zero "
+                         "disables the batching.")
+        },
+        &insert_batch_rows,
+        0, 0, INT_MAX,
+        NULL, NULL, NULL
+    },
+
     /* End-of-list marker */
     {
         {NULL, 0, 0, NULL, NULL}, NULL, 0, 0, 0, NULL, NULL, NULL
@@ -5082,6 +5288,26 @@ static struct config_real ConfigureNamesReal[] =
         &remote_query_cost,
         DEFAULT_REMOTE_QUERY_COST, 0, DBL_MAX, NULL, NULL
     },
+
+    {
+        {"network_cost_time_unit", PGC_USERSET, QUERY_TUNING_COST,
+            gettext_noop("Sets the time one unit of planner cost stands for "
+                         "when network costs are calibrated."),
+            gettext_noop("In microseconds.")
+        },
+        &network_cost_time_unit,
+        10.0, 0.001, DBL_MAX, NULL, NULL
+    },
+
+    {
+        {"partial_agg_reduction_ratio", PGC_USERSET, QUERY_TUNING_METHOD,
+            gettext_noop("Sets the largest ratio of groups to input rows at which "
+                         "a partial aggregation is still worth it."),
+            gettext_noop("Used with enable_adaptive_partial_agg.")
+        },
+        &partial_agg_reduction_ratio,
+        0.5, 0.0, 1.0, NULL, NULL
+    },
 #endif
 
     {
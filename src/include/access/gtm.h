@@ -118,6 +118,9 @@ extern void InitGTM(void);
 extern void CloseGTM(void);
 extern GTM_Timestamp 
 GetGlobalTimestampGTM(void);
+#ifdef __SUPPORT_DISTRIBUTED_TRANSACTION__
+extern double GetStatementGTSWait(int *count);
+#endif
 extern GlobalTransactionId BeginTranGTM(GTM_Timestamp *timestamp, const char *globalSession);
 extern GlobalTransactionId BeginTranAutovacuumGTM(void);
 extern int CommitTranGTM(GlobalTransactionId gxid, int waited_xid_count,
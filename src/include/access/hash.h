@@ -449,6 +449,10 @@ extern void hashbucketcleanup(Relation rel, Bucket cur_bucket,
 #ifdef PGXC
 extern Datum compute_hash(Oid type, Datum value, char locator);
 extern char *get_compute_hash_function(Oid type, char locator);
+#ifdef __OPENTENBASE__
+extern void compute_hash_batch(Oid type, Datum *values, bool *nulls,
+                   int nvalues, char locator, Datum *hashes);
+#endif
 #endif
 
 #endif                            /* HASH_H */
@@ -123,6 +123,13 @@ extern HeapScanDesc heap_beginscan_sampling(Relation relation,
 						bool allow_strat, bool allow_sync, bool allow_pagemode);
 extern void heap_setscanlimits(HeapScanDesc scan, BlockNumber startBlk,
 				   BlockNumber endBlk);
+#ifdef _SHARDING_
+extern bool enable_shard_pruned_scan;
+
+extern void heap_setscanshards(HeapScanDesc scan, Bitmapset *shards);
+extern Bitmapset *heap_scan_visible_shards(Relation relation, Snapshot snapshot);
+extern void heap_setscanzonemap(HeapScanDesc scan, ScanKey keys, int nkeys);
+#endif
 extern void heapgetpage(HeapScanDesc scan, BlockNumber page);
 extern void heap_rescan(HeapScanDesc scan, ScanKey key);
 extern void heap_rescan_set_params(HeapScanDesc scan, ScanKey key,
@@ -134,6 +141,12 @@ extern Size heap_parallelscan_estimate(Snapshot snapshot);
 extern void heap_parallelscan_initialize(ParallelHeapScanDesc target,
 							 Relation relation, Snapshot snapshot);
 extern void heap_parallelscan_reinitialize(ParallelHeapScanDesc parallel_scan);
+#ifdef _SHARDING_
+extern Size heap_parallelscan_shard_estimate(Relation relation, Size len);
+extern void heap_parallelscan_initialize_shards(ParallelHeapScanDesc target,
+									Size len, Relation relation,
+									Snapshot snapshot);
+#endif
 extern HeapScanDesc heap_beginscan_parallel(Relation, ParallelHeapScanDesc);
 
 extern bool heap_fetch(Relation relation, Snapshot snapshot,
@@ -104,6 +104,11 @@ typedef struct ParallelHeapScanDescData
     BlockNumber phs_startblock; /* starting block number */
 	pg_atomic_uint64 phs_nallocated;	/* number of blocks allocated to
 										 * workers so far. */
+#ifdef _SHARDING_
+    int            phs_nextents;    /* extents handed out instead of blocks,
+                                 * -1 if blocks are */
+    Size        phs_extents_off;    /* offset of the extents from the start */
+#endif
     char        phs_snapshot_data[FLEXIBLE_ARRAY_MEMBER];
 }            ParallelHeapScanDescData;
 
@@ -138,6 +143,19 @@ typedef struct HeapScanDescData
     /* NB: if rs_cbuf is not InvalidBuffer, we hold a pin on that buffer */
     ParallelHeapScanDesc rs_parallel;    /* parallel scan information */
 
+#ifdef _SHARDING_
+    /* shards whose pages are read, NULL for all, see heap_setscanshards */
+    Bitmapset  *rs_shards;
+    ExtentID   *rs_extents;        /* extents of rs_shards, in block order */
+    int            rs_nextents;
+    BlockNumber rs_extents_nblocks;    /* rs_nblocks rs_extents was built for */
+    int            rs_cextent;        /* index in rs_extents of current block */
+    /* extents skipped by their zone map, see heap_setscanzonemap */
+    ScanKey        rs_zmkeys;
+    int            rs_nzmkeys;
+    struct ZoneMapBuildState *rs_zmbuild;    /* summary of the extent read */
+#endif
+
 #ifdef __SUPPORT_DISTRIBUTED_TRANSACTION__
     /* statistic account */
     int64        rs_scan_number;            /* scanned number of tuples */
@@ -6842,6 +6842,8 @@ DATA(insert OID = 4619 (  vacuum_hidden_shards    PGNSP PGUID 12 1 0 0 0 f f f f
 DESCR("vacuum hidden shards");
 DATA(insert OID = 4620 (  opentenbase_shard_statistic PGNSP PGUID 12 1 0 0 0 f f f f t t v r 0 0 2249 "" "{25,25,23,20,20,20,20,20,20}" "{o,o,o,o,o,o,o,o,o}" "{group_name,node_name,shard_id,ntups_select,ntups_insert,ntups_update,ntups_delete,size,ntups}" _null_ _null_ opentenbase_shard_statistic _null_ _null_ _null_ ));
 DESCR("show statistic data of all shards");
+DATA(insert OID = 4631 (  opentenbase_network_cost PGNSP PGUID 12 1 100 0 0 f f f f t t v r 0 0 2249 "" "{25,20,701,20,20,701,701,701,1184}" "{o,o,o,o,o,o,o,o,o}" "{node_name,startup_samples,startup_usec,transfer_samples,transfer_bytes,bytes_per_sec,remote_query_cost,network_byte_cost,last_update}" _null_ _null_ opentenbase_network_cost _null_ _null_ _null_ ));
+DESCR("show network costs measured from executed remote fragments");
 
 DATA(insert OID = 4628 (  opentenbase_set_need_mvcc PGNSP PGUID 12 1 0 0 0 f f f f t f v r 1 0 16 "23" _null_ _null_ _null_ _null_ _null_ opentenbase_set_need_mvcc _null_ _null_ _null_ ));
 DESCR("set need_mvcc flag");
@@ -42,6 +42,7 @@ typedef struct ExplainState
 #endif /* PGXC */
 #ifdef __OPENTENBASE__
 	bool        skip_remote_query;  /* skip execute remote query */
+	bool        distributed;    /* print exchange and node skew details */
 #endif
     bool        timing;            /* print detailed node timing */
     bool        summary;        /* print total planning and execution timing */
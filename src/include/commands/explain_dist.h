@@ -40,6 +40,13 @@ typedef struct RemoteInstr
 	
 	/* for Hash */
 	HashInstrumentation hash_stat;
+	
+	/* for RemoteSubplan */
+	char adaptive_exchange;  /* exchange chosen at run time */
+	ExchangeInstrumentation exchange;
+	
+	/* for the top node of a fragment, sent by its producer */
+	ExchangeInstrumentation producer;
 } RemoteInstr;
 
 typedef struct AttachRemoteInstrContext
@@ -49,9 +56,10 @@ typedef struct AttachRemoteInstrContext
 	Bitmapset   *printed_nodes;     /* ids of plan nodes we've handled */
 } AttachRemoteInstrContext;
 
-extern void SendLocalInstr(PlanState *planstate);
+extern void SendLocalInstr(PlanState *planstate, DestReceiver *dest);
 extern void HandleRemoteInstr(char *msg_body, size_t len, int nodeid, ResponseCombiner *combiner);
 extern bool AttachRemoteInstr(PlanState *planstate, AttachRemoteInstrContext *ctx);
+extern void AttachRemoteProducerInstr(RemoteSubplanState *node, AttachRemoteInstrContext *ctx);
 extern void ExplainCommonRemoteInstr(PlanState *planstate, ExplainState *es);
 
 #endif  /* EXPLAINDIST_H  */
\ No newline at end of file
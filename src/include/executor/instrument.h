@@ -41,6 +41,10 @@ typedef enum InstrumentOption
 	INSTRUMENT_TIMER = 1 << 0,	/* needs timer (and row counts) */
 	INSTRUMENT_BUFFERS = 1 << 1,	/* needs buffer usage */
 	INSTRUMENT_ROWS = 1 << 2,	/* needs row count */
+#ifdef __OPENTENBASE__
+	INSTRUMENT_EXCHANGE = 1 << 3,	/* needs exchange details, see
+									 * EXPLAIN (DISTRIBUTED) */
+#endif
 	INSTRUMENT_ALL = PG_INT32_MAX
 } InstrumentOption;
 
@@ -26,6 +26,8 @@
 extern bool g_hybrid_hash_agg;
 extern bool g_hybrid_hash_agg_debug;
 extern int  g_default_hashagg_nbatches;
+extern bool enable_adaptive_partial_agg;
+extern double partial_agg_reduction_ratio;
 #endif
 
 extern AggState *ExecInitAgg(Agg *node, EState *estate, int eflags);
@@ -37,5 +37,11 @@ extern bool ProducerReceiverPushBuffers(DestReceiver *self);
 
 #ifdef __OPENTENBASE__
 extern void SetProducerNodeMap(DestReceiver *self, int16 *nodemap);
+extern void SetProducerAdaptive(DestReceiver *self, char adaptive, int rows,
+                                List *distNodes, int *consMap);
+extern void SetProducerInstrument(DestReceiver *self);
+extern void ProducerReceiverPause(DestReceiver *self, bool paused);
+extern bool GetProducerInstrument(DestReceiver *self, uint64 *rows,
+                                  double *send_time, double *stall_time);
 #endif
 #endif   /* PRODUCER_RECEIVER_H */
@@ -1231,6 +1231,11 @@ typedef struct SeqScanState
 {
     ScanState    ss;                /* its first field is NodeTag */
     Size        pscan_len;        /* size of parallel heap scan descriptor */
+#ifdef _SHARDING_
+    ScanKey        zm_keys;        /* quals the zone map can evaluate */
+    ExprState **zm_keyexprs;    /* their values, NULL if constant */
+    int            zm_nkeys;
+#endif
 } SeqScanState;
 
 /* ----------------
@@ -2086,6 +2091,11 @@ typedef struct AggState
     TupleTableSlot *dataslot;
     Oid                dataType;
     MemoryContext   tmpcxt;
+    /* partial aggregation that may stop aggregating, see agg_fill_hash_table */
+    bool            adaptive;
+    bool            passthrough;    /* rest of the input is passed through */
+    bool            passthrough_groups_done;    /* hash groups all returned */
+    AggStatePerGroup passthrough_pergroup;  /* state of the row passed */
 #endif    
 } AggState;
 
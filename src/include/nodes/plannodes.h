@@ -859,6 +859,7 @@ typedef struct Agg
 	uint32     entrySize;
 	bool       hybrid;
 	bool       noDistinct;      /* no need of distinct related initialization */
+	bool       adaptive;        /* partial agg may pass rows through at run time */
 #endif
 } Agg;
 
@@ -993,6 +994,7 @@ typedef struct Limit
     Node       *limitCount;        /* COUNT parameter, or NULL if none */
 #ifdef __OPENTENBASE__
 	bool		skipEarlyFinish;	/* Early ExecFinishNode ? */
+	bool		includeOffset;	/* return the OFFSET rows too ? */
 #endif
 } Limit;
 
@@ -1497,6 +1497,9 @@ typedef struct RemoteSubPath
 {
     Path        path;
     Path       *subpath;
+#ifdef __OPENTENBASE__
+    char        adaptive;       /* see RemoteSubplan */
+#endif
 } RemoteSubPath;
 #endif
 
@@ -1724,6 +1727,7 @@ typedef struct AggPath
 	uint32      entrySize;
 	bool        hybrid;
 	bool        noDistinct;     /* no need of distinct related initialization */
+	bool        adaptive;       /* partial agg may pass rows through at run time */
 #endif
 } AggPath;
 
@@ -1866,6 +1870,7 @@ typedef struct LimitPath
     Node       *limitCount;        /* COUNT parameter, or NULL if none */
 #ifdef __OPENTENBASE__
 	bool		skipEarlyFinish;	/* Early ExecFinishNode ? */
+	bool		includeOffset;	/* return the OFFSET rows too ? */
 #endif
 } LimitPath;
 
@@ -381,6 +381,8 @@ extern int replication_level;
 
 extern bool restrict_query;
 extern bool enable_subquery_shipping;
+extern bool enable_adaptive_distribution;
+extern int adaptive_broadcast_rows;
 extern char *g_constrain_group;
 #endif
 
@@ -65,6 +65,11 @@
 #define BIT_SET(data, bit)   ((1 << (bit)) & (data)) 
 
 extern int DataRowBufferSize;
+extern bool enable_subplan_cache;
+extern int RemoteDMLBatchSize;
+extern int RemoteReceiveThreads;
+extern int CopySendThreads;
+extern int CopySendQueueSize;
 
 extern bool need_global_snapshot;
 extern List *executed_node_list;
@@ -231,6 +236,11 @@ typedef struct RemoteQueryState
     int            su_num_params;
 
     uint32        dml_prepared_mask[WORD_NUMBER_FOR_NODES]; 
+
+    /* rows pipelined to the datanodes, see ExecRemoteDML */
+    PGXCNodeHandle **dml_batch_conns;    /* connections rows were sent to */
+    int            dml_batch_nconns;
+    EState       *dml_batch_estate;        /* whose es_processed counts the rows */
 #endif
 }    RemoteQueryState;
 
@@ -246,10 +256,34 @@ typedef struct RemoteParam
 /*
  * Execution state of a RemoteSubplan node
  */
+#ifdef __OPENTENBASE__
+/*
+ * Instrumentation of the exchange of a RemoteSubplan, shown by EXPLAIN
+ * (ANALYZE, DISTRIBUTED). The consumer side is measured where the rows are
+ * received, the producer side is reported by the producers of the fragment
+ * along with their instrumentation, see explain_dist.c.
+ */
+typedef struct ExchangeInstrumentation
+{
+    uint64      recv_bytes;         /* bytes of the data rows received */
+    double      recv_wait;          /* msec spent waiting for the rows */
+    int         nproducers;         /* producers reported below */
+    uint64      send_rows;          /* rows they sent to the consumers */
+    double      send_min;           /* msec handing rows to the queues */
+    double      send_max;
+    double      send_total;
+    double      stall_min;          /* msec paused on full consumer queues */
+    double      stall_max;
+    double      stall_total;
+} ExchangeInstrumentation;
+#endif
+
 typedef struct RemoteSubplanState
 {
     ResponseCombiner combiner;            /* see ResponseCombiner struct */
     char       *subplanstr;                /* subplan encoded as a string */
+    uint64      subplankey;                /* hash of subplanstr, 0 if the
+                                         * nodes should not cache it */
     bool        bound;                    /* subplan is sent down to the nodes */
     bool        local_exec;             /* execute subplan on this datanode */
     Locator    *locator;                /* determine destination of tuples of
@@ -266,9 +300,27 @@ typedef struct RemoteSubplanState
     bool        finish_init;
     int32       eflags;                       /* estate flag. */
     ParallelWorkerStatus *parallel_status; /* Shared storage for parallel worker. */
+    /* adaptive side of a hash join, see ExecRemoteSubplan */
+    struct RemoteSubplanState *adaptive_peer;    /* the other side */
+    char        adaptive_exchange;            /* ADAPTIVE_EXCHANGE_* */
+    int         adaptive_nnodes;            /* producers of the build side */
+    Oid        *adaptive_nodes;
+    int        *adaptive_counts;            /* and their rows so far */
+    bool        measure_exchange;            /* INSTRUMENT_EXCHANGE requested */
+    ExchangeInstrumentation exchange;        /* for EXPLAIN (DISTRIBUTED) */
 #endif
 } RemoteSubplanState;
 
+#ifdef __OPENTENBASE__
+/* RemoteSubplanState.adaptive_exchange */
+#define ADAPTIVE_EXCHANGE_NONE          '\0'
+#define ADAPTIVE_EXCHANGE_COUNTING      'c'        /* build side in progress */
+#define ADAPTIVE_EXCHANGE_BROADCAST     'b'
+#define ADAPTIVE_EXCHANGE_DISTRIBUTE    'd'
+#define ADAPTIVE_EXCHANGE_LOCAL         'l'
+#define ADAPTIVE_EXCHANGE_MIXED         'm'        /* differs by node, explain only */
+#endif
+
 
 /*
  * Data needed to set up a PreparedStatement on the remote node and other data
@@ -377,6 +429,9 @@ extern TupleTableSlot* ExecRemoteSubplan(PlanState *pstate);
 extern void ExecEndRemoteSubplan(RemoteSubplanState *node);
 extern void ExecReScanRemoteSubplan(RemoteSubplanState *node);
 #ifdef __OPENTENBASE__
+extern void ExecLinkAdaptiveRemoteSubplans(PlanState *probe, PlanState *build);
+#endif
+#ifdef __OPENTENBASE__
 extern void ExecRemoteUtility(RemoteQuery *node,
 								PGXCNodeHandle *leader_cn_conn,
 								ParallelDDLRemoteType type);
@@ -440,6 +495,7 @@ extern bool ExecRemoteDML(ModifyTableState *mtstate, ItemPointer tupleid, HeapTu
               TupleTableSlot *slot, TupleTableSlot *planSlot, EState *estate, EPQState *epqstate,
               bool canSetTag, TupleTableSlot **returning, UPSERT_ACTION *result,
               ResultRelInfo *resultRelInfo, int rel_index);
+extern void ExecFinishRemoteDML(ModifyTableState *mtstate);
 extern void ExecDisconnectRemoteSubplan(RemoteSubplanState *node);
 extern void SetCurrentHandlesReadonly(void);
 
@@ -0,0 +1,27 @@
+/*-------------------------------------------------------------------------
+ *
+ * insertbatch.h
+ *	  Single-row INSERTs buffered on the coordinator, see insertbatch.c
+ *
+ *
+ * IDENTIFICATION
+ *	  src/include/pgxc/insertbatch.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef INSERTBATCH_H
+#define INSERTBATCH_H
+
+#include "nodes/parsenodes.h"
+
+/* GUC parameters */
+extern int	insert_batch_rows;
+
+extern bool insert_batch_analyzing;
+
+extern bool InsertBatchCandidate(InsertStmt *stmt, SelectStmt *selectStmt);
+extern bool InsertBatchAdd(InsertStmt *stmt, Query *query);
+extern void InsertBatchFlush(void);
+extern void InsertBatchDiscard(void);
+
+#endif							/* INSERTBATCH_H */
@@ -251,6 +251,9 @@ extern bool IsTypeDistributable(Oid col_type);
 #endif
 
 #ifdef __OPENTENBASE__
+extern bool IsLocatorBatchable(Locator *self);
+extern void GET_NODES_BATCH(Locator *self, Datum *values, bool *nulls,
+                            int nvalues, void **results);
 extern char getLocatorDisType(Locator *self);
 extern bool prefer_olap;
 extern bool IsDistributedColumn(AttrNumber attr, RelationLocInfo *relation_loc_info);
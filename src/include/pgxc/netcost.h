@@ -0,0 +1,34 @@
+/*-------------------------------------------------------------------------
+ *
+ * netcost.h
+ *	  Network costs measured from the remote fragments executed, see
+ *	  netcost.c
+ *
+ *
+ * IDENTIFICATION
+ *	  src/include/pgxc/netcost.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef NETCOST_H
+#define NETCOST_H
+
+#include "fmgr.h"
+#include "utils/timestamp.h"
+
+/* GUC parameters */
+extern bool enable_network_cost_calibration;
+extern double network_cost_time_unit;
+
+extern Size NetworkCostShmemSize(void);
+extern void NetworkCostShmemInit(void);
+
+extern void NetworkCostReportStartup(Oid nodeoid, TimestampTz sent,
+						 TimestampTz answered);
+extern void NetworkCostReportTransfer(Oid nodeoid, uint64 bytes,
+						  TimestampTz start, TimestampTz end);
+extern void GetNetworkCost(double *byte_cost, double *query_cost);
+
+extern Datum opentenbase_network_cost(PG_FUNCTION_ARGS);
+
+#endif							/* NETCOST_H */
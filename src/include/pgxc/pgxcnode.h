@@ -28,6 +28,21 @@
 
 #define NO_SOCKET -1
 
+/* RemoteSubplan fragments a data node session keeps parsed */
+#define SUBPLAN_CACHE_SLOTS 32
+
+/* Upper limit of remote_receive_threads */
+#define MAX_REMOTE_RECEIVE_THREADS 16
+
+/* Ring a reader thread receives a handle's input into, see pgxcnode.c */
+struct PGXCNodeReceivePump;
+
+/* Upper limit of copy_send_threads */
+#define MAX_COPY_SEND_THREADS 16
+
+/* Ring a writer thread sends a handle's output from, see pgxcnode.c */
+struct PGXCNodeSendPump;
+
 /* Connection to Datanode maintained by Pool Manager */
 typedef struct PGconn NODE_CONNECTION;
 typedef struct PGcancel NODE_CANCEL;
@@ -133,10 +148,44 @@ struct pgxc_node_handle
 	bool 		plpgsql_need_begin_sub_txn;
 	bool 		plpgsql_need_begin_txn;
 	char        node_type;
+
+	/* registration in the receive epoll set, see pgxc_node_receive */
+	int			epoll_sock;		/* sock registered, NO_SOCKET if none */
+	uint32		epoll_gen;		/* last wait the handle was waited for in */
+	int			epoll_idx;		/* index of the handle in that wait */
+
+	/* fragments stored in the remote session, see pgxc_node_send_plan */
+	uint64		subplan_keys[SUBPLAN_CACHE_SLOTS];	/* 0 if slot is unused */
+	int			subplan_next;	/* slot to be replaced next */
+
+	int			dml_pipelined;	/* DML rows sent and not answered yet,
+								 * see ExecRemoteDML */
+
+	/* input received by a reader thread, NULL if read by the backend */
+	struct PGXCNodeReceivePump *recv_pump;
+
+	/* output sent by a writer thread, NULL if sent by the backend */
+	struct PGXCNodeSendPump *send_pump;
+
+	/* measurement of the fragment running, see netcost.c */
+	TimestampTz fragment_sent;	/* fragment queued, 0 once bound */
+	TimestampTz fragment_rows_start;	/* first data row, 0 if none yet */
+	uint64		fragment_bytes; /* data row bytes since the first */
+	bool		fragment_measured;
 #endif
 };
 typedef struct pgxc_node_handle PGXCNodeHandle;
 
+/*
+ * Extended Query protocol messages encoded once and shared by all the
+ * handles a command is sent to, [0] without and [1] with the Parse message.
+ */
+typedef struct
+{
+	char	   *data[2];
+	int			len[2];
+} PGXCNodeSendTemplate;
+
 /* Structure used to get all the handles involved in a transaction */
 typedef struct
 {
@@ -225,7 +274,8 @@ extern int pgxc_node_send_disconnect(PGXCNodeHandle * handle, char *cursor, int
 #endif
 extern int	pgxc_node_send_bind(PGXCNodeHandle * handle, const char *portal,
 								const char *statement, int paramlen, const char *params,
-								int eqpctxlen, const char *epqctx, StringInfo shardmap);
+								int eqpctxlen, const char *epqctx, StringInfo shardmap,
+								char adaptive, int adaptive_rows);
 extern int	pgxc_node_send_parse(PGXCNodeHandle * handle, const char* statement,
 								 const char *query, short num_params, Oid *param_types);
 extern int	pgxc_node_send_flush(PGXCNodeHandle * handle);
@@ -234,9 +284,18 @@ extern int	pgxc_node_send_query_extended(PGXCNodeHandle *handle, const char *que
 							  int num_params, Oid *param_types,
 							  int paramlen, char *params,
 							  bool send_describe, int fetch_size);
+extern int	pgxc_node_send_query_extended_template(PGXCNodeHandle *handle,
+							  PGXCNodeSendTemplate *tmpl, const char *query,
+							  const char *statement, const char *portal,
+							  int num_params, Oid *param_types,
+							  int paramlen, char *params,
+							  bool send_describe, int fetch_size);
+extern void pgxc_node_free_send_template(PGXCNodeSendTemplate *tmpl);
 extern int  pgxc_node_send_plan(PGXCNodeHandle * handle, const char *statement,
 					const char *query, const char *planstr,
-					short num_params, Oid *param_types, int instrument_options);
+					short num_params, Oid *param_types, int instrument_options,
+					uint64 plan_key);
+extern void pgxc_node_forget_subplans(PGXCNodeHandle *handle);
 extern int pgxc_node_send_gid(PGXCNodeHandle *handle, char* gid);
 #ifdef __TWO_PHASE_TRANS__
 extern int pgxc_node_send_starter(PGXCNodeHandle *handle, char* startnode);
@@ -269,9 +328,21 @@ extern bool	pgxc_node_receive(const int conn_count,
 #endif
 extern int	pgxc_node_read_data(PGXCNodeHandle * conn, bool close_if_error);
 extern int	pgxc_node_is_data_enqueued(PGXCNodeHandle *conn);
+#ifdef __OPENTENBASE__
+extern void	pgxc_node_start_receive_pump(PGXCNodeHandle *handle);
+extern void	pgxc_node_stop_receive_pump(PGXCNodeHandle *handle);
+extern void	pgxc_node_start_send_pump(PGXCNodeHandle *handle);
+extern int	pgxc_node_stop_send_pump(PGXCNodeHandle *handle, bool discard);
+extern int	pgxc_node_send_pump_push(PGXCNodeHandle *handle);
+#endif
 
 extern int	send_some(PGXCNodeHandle * handle, int len);
 extern int	pgxc_node_flush(PGXCNodeHandle *handle);
+#ifdef __OPENTENBASE__
+extern void	pgxc_node_batch_send_begin(void);
+extern int	pgxc_node_batch_send_end(void);
+extern void	pgxc_node_batch_send_reset(void);
+#endif
 extern int	pgxc_node_flush_read(PGXCNodeHandle *handle);
 
 extern char get_message(PGXCNodeHandle *conn, int *len, char **msg);
@@ -259,10 +259,23 @@ typedef struct
     bool        parallelWorkerSendTuple; 
 	/* params that generated by initplan */
 	Bitmapset  *initPlanParams;
+	/*
+	 * side of a hash join whose exchange may change at run time, and the
+	 * rows a build side may have to still be broadcast
+	 */
+	char        adaptive;
+	int         adaptiveRows;
 #endif
 
 } RemoteSubplan;
 
+#ifdef __OPENTENBASE__
+/* RemoteSubplan.adaptive */
+#define REMOTE_ADAPTIVE_NONE	'\0'
+#define REMOTE_ADAPTIVE_BUILD	'b'		/* inner side of the hash join */
+#define REMOTE_ADAPTIVE_PROBE	'p'		/* outer side of the hash join */
+#endif
+
 /*
  * FQS_context
  * This context structure is used by the Fast Query Shipping walker, to gather
@@ -309,6 +322,8 @@ extern void pgxc_build_dml_statement(PlannerInfo *root, CmdType cmdtype,
 extern Expr *pgxc_set_en_expr(Oid tableoid, Index resultRelationIndex);
 
 extern Expr *pgxc_set_sec_en_expr(Oid tableoid, Index resultRelationIndex);
+
+extern int pgxc_fqs_key_param(PlannedStmt *stmt);
 #endif
 
 #endif   /* PGXCPLANNER_H */
@@ -44,6 +44,10 @@
  * a session.
  * At the end of a transaction, a session using either temporary objects
  * or global session parameters has its connections not sent back to pool.
+ * With pool_session_fingerprint on, connections carrying global session
+ * parameters are returned to pool tagged with a fingerprint of the SET
+ * commands applied on them, and are handed preferably to sessions with
+ * the same fingerprint so that no SET needs to be replayed.
  *
  * Local parameters are used to change within current transaction block.
  * They are sent to remote nodes invloved in the transaction after sending
@@ -116,8 +120,50 @@ typedef struct
 	int32  lineno;	   /* lineno where destroy the slot */
 	char   *node_name; /* connection node name , pointer to datanode_pool node_name, no memory allocated*/
 	int32  backend_pid;/* backend pid of remote connection */
+
+	/* session parameter fingerprint */
+	uint32 session_hash; /* fingerprint of the SET commands applied on conn, 0 means clean */
+	int32  session_ncmd; /* number of SET commands covered by session_hash */
 } PGXCNodePoolSlot;
 
+/* number of slots of the pool demand history, one per hour of day */
+#define POOL_DEMAND_HOURS 24
+
+/*
+ * Pool telemetry histograms use power of two buckets, bucket i counts the
+ * values in [2^i, 2^(i+1)), bucket 0 also counts 0 and the last bucket is
+ * open ended. Latencies are in microseconds, slot ages in seconds.
+ */
+#define POOL_LATENCY_BUCKETS 24
+#define POOL_SLOT_AGE_BUCKETS 20
+
+/* kinds of latency recorded in pool telemetry */
+typedef enum
+{
+	PoolLatencyHit = 0,			/* acquire a free connection from the pool */
+	PoolLatencyAsyncBuild,		/* batch connection build to grow the pool */
+	PoolLatencySyncBuild,		/* acquire building a new connection in sync thread */
+	PoolLatencySetReplay,		/* replay session parameters on an acquired connection */
+	PoolLatencyReset,			/* reset a connection released to the pool */
+	POOL_LATENCY_KIND_COUNT
+} PoolLatencyKind;
+
+/* failure causes of async connection build */
+typedef enum
+{
+	PoolBuildFailNoThread = 0,	/* no async thread available */
+	PoolBuildFailConnect,		/* could not connect to the node */
+	PoolBuildFailDiscard,		/* built but pool full or version changed */
+	POOL_BUILD_FAIL_COUNT
+} PoolBuildFailCause;
+
+typedef struct
+{
+	uint32		latency[POOL_LATENCY_KIND_COUNT][POOL_LATENCY_BUCKETS];
+	uint64		latency_sum[POOL_LATENCY_KIND_COUNT];	/* microseconds */
+	uint32		build_fail[POOL_BUILD_FAIL_COUNT];
+} PoolNodeTelemetry;
+
 /* Pool of connections to specified pgxc node */
 typedef struct
 {
@@ -133,6 +179,13 @@ typedef struct
 	char		node_name[NAMEDATALEN]; /* name of the node.*/
     int64		m_version;	/* version of node pool */
 	PGXCNodePoolSlot **slot;
+
+	/* demand history, used to grow the pool before its peaks */
+	float		demand_profile[POOL_DEMAND_HOURS]; /* decayed peak of in-use connections per hour of day */
+	int			demand_hour;	/* hour of day demand_peak is collected for, -1 if none */
+	int			demand_peak;	/* peak of in-use connections during demand_hour */
+
+	PoolNodeTelemetry telemetry;
 } PGXCNodePool;
 
 /* All pools for specified database */
@@ -171,6 +224,7 @@ typedef struct PGXCASyncTaskCtl
 
 	/* set command */
 	char                 *m_command;
+	int32                 m_command_type; /* PoolCommandType of m_command */
 	int32                 m_total;
 	int32                 m_succeed;
 
@@ -208,6 +262,7 @@ typedef struct
 	char		   *local_params;
 	List            *session_params_list; /* session param list */
 	List 			*local_params_list;   /* local param list */
+	uint32			session_hash;  /* fingerprint of session_params_list, 0 if none */
 	
 	bool			is_temp; /* Temporary objects used for this pool session? */
 
@@ -243,7 +298,7 @@ typedef struct PoolerCmdStatistics
 } PoolerCmdStatistics;
 
 
-#define POOLER_CMD_COUNT (18)
+#define POOLER_CMD_COUNT (20)
 
 
 
@@ -258,6 +313,9 @@ extern int	PoolerPort;
 extern int	PoolConnKeepAlive;
 extern int	PoolMaintenanceTimeout;
 extern bool PersistentConnections;
+extern bool PoolSessionFingerprint;
+extern bool PoolDemandPrediction;
+extern int  PoolDemandPrewarmLead;
 
 extern char *g_PoolerWarmBufferInfo;
 extern char *g_unpooled_database;
@@ -377,5 +435,7 @@ extern int PoolManagerClosePooledConnections(const char *dbname, const char *use
 extern int PoolManagerGetCmdStatistics(char *s, int size);
 extern void PoolManagerResetCmdStatistics(void);
 extern int PoolManagerGetConnStatistics(StringInfo s);
+extern int PoolManagerGetDemandStatistics(StringInfo s);
+extern int PoolManagerGetNodeTelemetry(StringInfo s);
 
 #endif
@@ -106,6 +106,10 @@
 #define STRINGLENGTH 1024   /* string buffer length */
 
 extern int32       GetNodeIndexByHashValue(Oid group, long shardIdx);
+#ifdef __OPENTENBASE__
+extern void        GetNodeIndexesByHashValues(Oid group, long *hashvalues, int nvalues,
+                                              int32 *nodeindexes);
+#endif
 extern Bitmapset  *g_DatanodeShardgroupBitmap;
 extern List       *g_TempKeyValueList;
 extern bool         g_IsExtension;
@@ -184,6 +188,10 @@ extern void ATEOXact_CleanUpShardBarrier(void);
 extern void   StatShardRelation(Oid relid, ShardStat *shardstat, int32 shardnumber);
 extern void   StatShardAllRelations(ShardStat *shardstat, int32 shardnumber);
 extern void   GetGroupNodeIndexMap(Oid group, int32 *map);
+extern bool   ShardMapsIdentical(Oid group1, Oid group2);
+extern void   ResetPlansOnShardMapChange(void);
+extern List  *AppendShardMapGroup(List *groups, Oid group);
+extern bool   ShardGroupsColocated(List *groups);
 
 extern Datum pg_begin_table_dual_write(PG_FUNCTION_ARGS);
 
@@ -51,6 +51,13 @@ extern PGDLLIMPORT int SQueueSize;
 #define SQ_CONS_NONE -2
 #define SQ_CONS_INIT -3
 
+#ifdef __OPENTENBASE__
+/* exchange the consumers choose for a producer at run time */
+#define SQ_ADAPTIVE_NONE		'\0'
+#define SQ_ADAPTIVE_BROADCAST	'b'	/* first rows to all, then distribute */
+#define SQ_ADAPTIVE_LOCAL		'l'	/* all rows to the local consumer */
+#endif
+
 #ifdef __OPENTENBASE__
 #define WORD_IN_LONGLONG        2
 #define BITS_IN_BYTE            8
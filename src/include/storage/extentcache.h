@@ -0,0 +1,36 @@
+/*-------------------------------------------------------------------------
+ *
+ * extentcache.h
+ *	  Shared-memory cache of the extent map, see extentcache.c
+ *
+ *
+ * IDENTIFICATION
+ *	  src/include/storage/extentcache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef EXTENTCACHE_H
+#define EXTENTCACHE_H
+
+#include "storage/extentmapping.h"
+
+/* GUC parameters */
+extern int	extent_map_cache_size;
+
+extern Size ExtentCacheShmemSize(void);
+extern void ExtentCacheShmemInit(void);
+
+extern bool ExtentCacheGetEME(Relation rel, ExtentID eid,
+				  ExtentMappingElement *eme);
+extern bool ExtentCacheGetEMAPage(Relation rel, BlockNumber blkno,
+					  ExtentMappingElement *emes, int32 *n_emes);
+extern void ExtentCachePutEMA(Relation rel, BlockNumber blkno, Page page);
+extern bool ExtentCacheGetAnchor(Relation rel, ShardID sid,
+					 EMAShardAnchor *anchor);
+extern void ExtentCachePutESA(Relation rel, BlockNumber blkno, Page page);
+
+extern void ExtentCacheInvalidatePage(RelFileNode rnode, BlockNumber blkno);
+extern void ExtentCacheInvalidateRel(RelFileNode rnode);
+extern void ExtentCacheInvalidateDatabase(Oid dbid);
+
+#endif							/* EXTENTCACHE_H */
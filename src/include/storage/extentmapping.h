@@ -550,6 +550,9 @@ extern void     MarkExtentFull(Relation rel, ExtentID eid);
 extern void     MarkExtentAvailable(Relation rel, ExtentID eid);
 extern ExtentID    GetShardScanHead(Relation re, ShardID sid);
 extern ExtentID RelOidGetShardScanHead(Oid reloid, ShardID sid);
+extern ExtentID *GetShardExtents(Relation rel, Bitmapset *shards,
+                                 BlockNumber nblocks, int *nextents,
+                                 ShardID **shardids);
 extern void     TruncateExtentMap(Relation rel, BlockNumber nblocks);
 extern void       RebuildExtentMap(Relation rel);
 
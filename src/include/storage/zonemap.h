@@ -0,0 +1,77 @@
+/*-------------------------------------------------------------------------
+ *
+ * zonemap.h
+ *	  Per-extent min/max summaries of designated columns, see zonemap.c
+ *
+ *
+ * IDENTIFICATION
+ *	  src/include/storage/zonemap.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef ZONEMAP_H
+#define ZONEMAP_H
+
+#include "access/htup.h"
+#include "access/skey.h"
+#include "fmgr.h"
+#include "storage/bufpage.h"
+#include "storage/relfilenode.h"
+#include "utils/relcache.h"
+
+/* columns of a relation that can be summarized */
+#define ZONEMAP_MAX_COLUMNS		4
+
+/* GUC parameters */
+extern bool enable_zone_map;
+extern int	zone_map_cache_size;
+
+/* range of the values of a column in an extent */
+typedef struct ZoneMapRange
+{
+	bool		hasvalues;		/* false if there are only nulls */
+	Datum		min;
+	Datum		max;
+} ZoneMapRange;
+
+/*
+ * Columns summarized, looked up from the zone_map_columns reloption and
+ * kept in the relcache entry.
+ */
+typedef struct ZoneMapDesc
+{
+	int			natts;
+	AttrNumber	attnums[ZONEMAP_MAX_COLUMNS];
+	FmgrInfo	cmp[ZONEMAP_MAX_COLUMNS];	/* btree order proc of the type */
+} ZoneMapDesc;
+
+/* summary of an extent being built by a scan reading it */
+typedef struct ZoneMapBuildState
+{
+	ExtentID	eid;			/* extent read, or InvalidExtentID */
+	bool		active;			/* building its summary */
+	uint32		version;		/* of the slot when it was claimed */
+	int			npages;			/* pages of the extent added, from its first */
+	ZoneMapRange ranges[ZONEMAP_MAX_COLUMNS];
+} ZoneMapBuildState;
+
+extern Size ZoneMapShmemSize(void);
+extern void ZoneMapShmemInit(void);
+
+extern void ZoneMapValidateColumns(char *value);
+extern ZoneMapDesc *RelationGetZoneMap(Relation rel);
+
+extern void ZoneMapNoteInsert(Relation rel, HeapTuple tuple);
+
+extern void ZoneMapBuildStart(Relation rel, ZoneMapBuildState *state,
+				  BlockNumber blkno, BlockNumber nblocks);
+extern void ZoneMapBuildAddPage(Relation rel, ZoneMapBuildState *state,
+					BlockNumber blkno, Page page);
+
+extern bool ZoneMapExtentMayMatch(Relation rel, ExtentID eid,
+					  ScanKey keys, int nkeys);
+
+extern void ZoneMapInvalidateRel(RelFileNode rnode);
+extern void ZoneMapInvalidateDatabase(Oid dbid);
+
+#endif							/* ZONEMAP_H */
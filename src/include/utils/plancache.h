@@ -214,6 +214,9 @@ typedef struct CachedPlan
     MemoryContext context;        /* context containing this CachedPlan */
 #ifdef __OPENTENBASE__
     List       *stmt_list_backup;
+    int            fqs_key_param;    /* distribution key parameter of a
+                                 * generic point query shipped to one
+                                 * node, 0 if not such a query */
 #endif
 } CachedPlan;
 
@@ -260,7 +263,7 @@ extern CachedPlan *GetCachedPlan(CachedPlanSource *plansource,
 extern void ReleaseCachedPlan(CachedPlan *plan, bool useResOwner);
 #ifdef XCP
 extern void SetRemoteSubplan(CachedPlanSource *plansource,
-                 const char *plan_string);
+                 const char *plan_string, int cache_slot, uint64 plan_key);
 #endif
 
 #endif                            /* PLANCACHE_H */
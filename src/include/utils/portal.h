@@ -270,6 +270,10 @@ typedef struct PortalData
 	/* information about EvalPlanQual, pass it to queryDesc */
 	RemoteEPQContext *epqContext;
 	int			up_instrument;	/* explain analyze option from cn */
+
+	/* exchange chosen by the consumers, see SetProducerAdaptive */
+	char		adaptive;
+	int			adaptive_rows;
 #endif
 }            PortalData;
 
@@ -240,6 +240,11 @@ typedef struct RelationData
 #ifdef PGXC
 	RelationLocInfo *rd_locator_info;
 #endif
+#ifdef _SHARDING_
+	/* data managed by RelationGetZoneMap: */
+	bool		rd_zonemapvalid;	/* rd_zonemap is valid */
+	struct ZoneMapDesc *rd_zonemap; /* columns summarized per extent */
+#endif
 #ifdef __OPENTENBASE__
 	Form_pg_partition_interval  rd_partitions_info;
 	dlist_node		rd_lru_list_elem;	/* list member of LRU list */
@@ -308,6 +313,9 @@ typedef struct StdRdOptions
 	AutoVacOpts autovacuum;		/* autovacuum-related options */
 	bool		user_catalog_table; /* use as an additional catalog relation */
 	int			parallel_workers;	/* max number of parallel workers */
+#ifdef _SHARDING_
+	int			zone_map_columns_offset;	/* columns summarized per extent */
+#endif
 } StdRdOptions;
 
 #define HEAP_MIN_FILLFACTOR			10
@@ -321,6 +329,18 @@ typedef struct StdRdOptions
 	((relation)->rd_options ? \
 	 ((StdRdOptions *) (relation)->rd_options)->fillfactor : (defaultff))
 
+#ifdef _SHARDING_
+/*
+ * RelationGetZoneMapColumns
+ *		Returns the relation's zone_map_columns, or NULL.  See zonemap.c.
+ */
+#define RelationGetZoneMapColumns(relation) \
+	((relation)->rd_options && \
+	 ((StdRdOptions *) (relation)->rd_options)->zone_map_columns_offset != 0 ? \
+	 (char *) (relation)->rd_options + \
+	 ((StdRdOptions *) (relation)->rd_options)->zone_map_columns_offset : NULL)
+#endif
+
 /*
  * RelationGetTargetPageUsage
  *		Returns the relation's desired space usage per page in bytes.
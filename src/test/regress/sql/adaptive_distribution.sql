@@ -0,0 +1,48 @@
+--
+-- Hash joins choosing between broadcast and redistribution at run time
+--
+-- Both sides join on columns other than their distribution key, so both of
+-- them need moving.
+CREATE TABLE ad_outer (a int, b int) DISTRIBUTE BY SHARD(a);
+CREATE TABLE ad_inner (c int, d int) DISTRIBUTE BY SHARD(c);
+INSERT INTO ad_outer SELECT i, i % 10 FROM generate_series(1, 1000) i;
+INSERT INTO ad_inner SELECT i, i % 10 FROM generate_series(1, 10) i;
+ANALYZE ad_outer;
+ANALYZE ad_inner;
+CREATE FUNCTION ad_exchanges(q text) RETURNS SETOF text AS $$
+DECLARE
+    ln text;
+BEGIN
+    FOR ln IN EXECUTE 'EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF) ' || q
+    LOOP
+        IF ln ~ 'Adaptive Exchange' THEN
+            RETURN NEXT trim(ln);
+        END IF;
+    END LOOP;
+END $$ LANGUAGE plpgsql;
+SET enable_adaptive_distribution = on;
+SET enable_nestloop = off;
+SET enable_mergejoin = off;
+-- a small build side is broadcast, the probe side then stays local
+SELECT ad_exchanges('SELECT * FROM ad_outer o JOIN ad_inner i ON o.b = i.d');
+SELECT count(*), sum(o.a), sum(i.c) FROM ad_outer o JOIN ad_inner i ON o.b = i.d;
+-- the join result is then not distributed by the join key, the aggregate
+-- above must still see every row of a group together
+SELECT o.b, count(*) FROM ad_outer o JOIN ad_inner i ON o.b = i.d
+    GROUP BY o.b ORDER BY o.b;
+SELECT count(DISTINCT o.b) FROM ad_outer o JOIN ad_inner i ON o.b = i.d;
+SELECT ad_exchanges('SELECT o.b, count(*) FROM ad_outer o JOIN ad_inner i ON o.b = i.d GROUP BY o.b');
+-- outer joins keep the unmatched probe rows once
+SELECT count(*), count(i.c) FROM ad_outer o LEFT JOIN ad_inner i ON o.b = i.d + 5;
+-- a build side over the limit is redistributed, and the probe side with it
+SET adaptive_broadcast_rows = 2;
+SELECT ad_exchanges('SELECT * FROM ad_outer o JOIN ad_inner i ON o.b = i.d');
+SELECT o.b, count(*) FROM ad_outer o JOIN ad_inner i ON o.b = i.d
+    GROUP BY o.b ORDER BY o.b;
+RESET adaptive_broadcast_rows;
+RESET enable_mergejoin;
+RESET enable_nestloop;
+RESET enable_adaptive_distribution;
+DROP FUNCTION ad_exchanges(text);
+DROP TABLE ad_outer;
+DROP TABLE ad_inner;
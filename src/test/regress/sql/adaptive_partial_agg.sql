@@ -0,0 +1,29 @@
+--
+-- Partial hash aggregation that passes its input through at run time
+--
+CREATE TABLE apa_tab (a int, b int) DISTRIBUTE BY SHARD(a);
+INSERT INTO apa_tab SELECT i, i % 10 FROM generate_series(1, 1000) i;
+ANALYZE apa_tab;
+-- off by default, the plans are unchanged
+SHOW enable_adaptive_partial_agg;
+EXPLAIN (COSTS OFF) SELECT b, count(*) FROM apa_tab GROUP BY b;
+SET enable_adaptive_partial_agg = on;
+EXPLAIN (COSTS OFF) SELECT b, count(*) FROM apa_tab GROUP BY b;
+SELECT b, count(*), sum(a) FROM apa_tab GROUP BY b ORDER BY b;
+-- every group comes once from the table or once per row passed through,
+-- the final aggregation combines them
+CREATE TABLE apa_big (a int, b int) DISTRIBUTE BY SHARD(a);
+INSERT INTO apa_big SELECT i, i % 150000 FROM generate_series(1, 300000) i;
+ANALYZE apa_big;
+SELECT count(*), sum(cnt), min(cnt), max(cnt), sum(total)
+    FROM (SELECT b, count(*) cnt, sum(a) total FROM apa_big GROUP BY b) s;
+-- no reduction is good enough, but fewer rows than the sample aggregate
+SET partial_agg_reduction_ratio = 0;
+SELECT b, count(*), sum(a) FROM apa_tab GROUP BY b ORDER BY b;
+-- while more rows are passed through after it
+SELECT count(*), sum(cnt), min(cnt), max(cnt), sum(total)
+    FROM (SELECT b, count(*) cnt, sum(a) total FROM apa_big GROUP BY b) s;
+RESET partial_agg_reduction_ratio;
+RESET enable_adaptive_partial_agg;
+DROP TABLE apa_tab;
+DROP TABLE apa_big;
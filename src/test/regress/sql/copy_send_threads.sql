@@ -0,0 +1,32 @@
+--
+-- Rows of COPY FROM sent to the data nodes by sender threads
+--
+\set VERBOSITY terse
+CREATE TABLE cst_tab (a int, b int CHECK (b >= 0)) DISTRIBUTE BY SHARD(a);
+CREATE TABLE cst_ref (a int, b int) DISTRIBUTE BY SHARD(a);
+INSERT INTO cst_ref SELECT i, i % 100 FROM generate_series(1, 50000) i;
+SET copy_send_threads = 2;
+-- the queue of each data node fills and wraps many times
+SET copy_send_queue_size = 64;
+COPY cst_tab FROM PROGRAM 'awk ''BEGIN { for (i = 1; i <= 50000; i++) print i "\t" i % 100 }''';
+SELECT count(*), sum(a), sum(b) FROM cst_tab;
+-- every row is on the data node of its shard
+SELECT count(DISTINCT xc_node_id) FROM cst_tab;
+SELECT count(*) FROM
+    (SELECT xc_node_id, count(*) FROM cst_tab GROUP BY 1
+     EXCEPT
+     SELECT xc_node_id, count(*) FROM cst_ref GROUP BY 1) s;
+-- a row failing on its data node partway through
+COPY cst_tab FROM PROGRAM 'awk ''BEGIN { for (i = 50001; i <= 100000; i++) print i "\t" (i == 80000 ? -1 : i % 100) }''';
+SELECT count(*) FROM cst_tab;
+-- the connections are still usable
+COPY cst_tab FROM PROGRAM 'awk ''BEGIN { for (i = 50001; i <= 60000; i++) print i "\t" i % 100 }''';
+SELECT count(*), sum(a), sum(b) FROM cst_tab;
+BEGIN;
+COPY cst_tab FROM PROGRAM 'awk ''BEGIN { for (i = 60001; i <= 70000; i++) print i "\t" (i == 65000 ? -1 : i % 100) }''';
+ROLLBACK;
+SELECT count(*) FROM cst_tab;
+RESET copy_send_queue_size;
+RESET copy_send_threads;
+DROP TABLE cst_tab;
+DROP TABLE cst_ref;
@@ -0,0 +1,47 @@
+--
+-- Two-phase DISTINCT aggregates with GROUP BY
+--
+CREATE TABLE dag_tab (g int, x int, c int) DISTRIBUTE BY SHARD(x);
+INSERT INTO dag_tab SELECT i % 5, i % 100, i FROM generate_series(1, 1000) i;
+ANALYZE dag_tab;
+-- the strategy needs a partial path of the input
+SET min_parallel_table_scan_size = 0;
+-- no combine function, so it cannot be split
+CREATE AGGREGATE dag_sum_nocombine(int4) (
+    sfunc = int4pl,
+    stype = int4,
+    parallel = safe
+);
+CREATE FUNCTION dag_split(query text) RETURNS bool LANGUAGE plpgsql AS $$
+DECLARE
+    line text;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (COSTS OFF) ' || query LOOP
+        IF line ~ 'Partial|Finalize' THEN
+            RETURN true;
+        END IF;
+    END LOOP;
+    RETURN false;
+END;
+$$;
+-- deduplicated where the distinct value lives, combined by group
+EXPLAIN (COSTS OFF) SELECT g, count(DISTINCT x) FROM dag_tab GROUP BY g;
+SELECT g, count(DISTINCT x) FROM dag_tab GROUP BY g ORDER BY g;
+-- along with plain aggregates
+EXPLAIN (COSTS OFF)
+SELECT g, count(DISTINCT x), count(*), sum(c) FROM dag_tab GROUP BY g;
+SELECT g, count(DISTINCT x), count(*), sum(c) FROM dag_tab GROUP BY g ORDER BY g;
+-- an aggregate without a combine function is not split, distinct or not
+SELECT dag_split('SELECT g, dag_sum_nocombine(DISTINCT x) FROM dag_tab GROUP BY g');
+SELECT g, dag_sum_nocombine(DISTINCT x) FROM dag_tab GROUP BY g ORDER BY g;
+SELECT dag_split('SELECT g, count(DISTINCT x), dag_sum_nocombine(c) FROM dag_tab GROUP BY g');
+SELECT g, count(DISTINCT x), dag_sum_nocombine(c) FROM dag_tab GROUP BY g ORDER BY g;
+-- the same results unsplit
+SET enable_distinct_optimizer = off;
+SELECT dag_split('SELECT g, count(DISTINCT x) FROM dag_tab GROUP BY g');
+SELECT g, count(DISTINCT x), count(*), sum(c) FROM dag_tab GROUP BY g ORDER BY g;
+RESET enable_distinct_optimizer;
+RESET min_parallel_table_scan_size;
+DROP FUNCTION dag_split(text);
+DROP AGGREGATE dag_sum_nocombine(int4);
+DROP TABLE dag_tab;
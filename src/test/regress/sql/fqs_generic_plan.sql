@@ -0,0 +1,23 @@
+--
+-- Generic plans of prepared point queries routed by a parameter
+--
+CREATE TABLE fqsgp_tab (id int, v int) DISTRIBUTE BY SHARD(id);
+INSERT INTO fqsgp_tab SELECT i, i * 10 FROM generate_series(1, 100) i;
+PREPARE fqsgp_point(int) AS SELECT v FROM fqsgp_tab WHERE id = $1;
+PREPARE fqsgp_range(int) AS SELECT v FROM fqsgp_tab WHERE id < $1;
+-- custom plans first by default
+SHOW enable_fqs_generic_plan;
+EXPLAIN (verbose on, nodes off, costs off) EXECUTE fqsgp_point(5);
+SET enable_fqs_generic_plan = on;
+-- the generic plan of a point query is used from now on
+EXPLAIN (verbose on, nodes off, costs off) EXECUTE fqsgp_point(5);
+EXECUTE fqsgp_point(5);
+EXECUTE fqsgp_point(77);
+EXECUTE fqsgp_point(1000);
+-- other queries still get custom plans first
+EXPLAIN (verbose on, nodes off, costs off) EXECUTE fqsgp_range(3);
+EXECUTE fqsgp_range(2);
+RESET enable_fqs_generic_plan;
+DEALLOCATE fqsgp_point;
+DEALLOCATE fqsgp_range;
+DROP TABLE fqsgp_tab;
@@ -0,0 +1,24 @@
+--
+-- Single-row INSERTs kept by the coordinator to send at once
+--
+CREATE TABLE ib_tab (a int, b int) DISTRIBUTE BY SHARD(a);
+SET insert_batch_rows = 10;
+-- the rows kept are sent before a savepoint, dropped by a rollback to it
+BEGIN;
+INSERT INTO ib_tab VALUES (1, 1);
+INSERT INTO ib_tab VALUES (2, 2);
+SAVEPOINT s1;
+INSERT INTO ib_tab VALUES (3, 3);
+INSERT INTO ib_tab VALUES (4, 4);
+ROLLBACK TO SAVEPOINT s1;
+INSERT INTO ib_tab VALUES (5, 5);
+SELECT * FROM ib_tab ORDER BY a;
+INSERT INTO ib_tab VALUES (6, 6);
+COMMIT;
+SELECT * FROM ib_tab ORDER BY a;
+BEGIN;
+INSERT INTO ib_tab VALUES (7, 7);
+ROLLBACK;
+SELECT count(*) FROM ib_tab;
+RESET insert_batch_rows;
+DROP TABLE ib_tab;
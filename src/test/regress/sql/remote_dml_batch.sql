@@ -0,0 +1,56 @@
+--
+-- Coordinator-driven DML sent to the datanodes in batches
+--
+-- A row trigger that cannot be shipped makes the coordinator apply the DML
+-- row by row, see remote_dml_batch_size.
+CREATE TABLE rdml_tab (a int PRIMARY KEY, b int) DISTRIBUTE BY SHARD(a);
+CREATE FUNCTION rdml_trig() RETURNS trigger AS $$
+BEGIN
+    IF TG_OP = 'DELETE' THEN
+        RETURN OLD;
+    END IF;
+    RETURN NEW;
+END $$ LANGUAGE plpgsql;
+CREATE TRIGGER rdml_trig BEFORE INSERT OR UPDATE OR DELETE ON rdml_tab
+    FOR EACH ROW EXECUTE PROCEDURE rdml_trig();
+CREATE FUNCTION rdml_counts() RETURNS void AS $$
+DECLARE
+    n bigint;
+BEGIN
+    INSERT INTO rdml_tab SELECT i, i FROM generate_series(1, 1000) i;
+    GET DIAGNOSTICS n = ROW_COUNT;
+    RAISE NOTICE 'inserted %', n;
+    UPDATE rdml_tab SET b = b + 1 WHERE a % 3 = 0;
+    GET DIAGNOSTICS n = ROW_COUNT;
+    RAISE NOTICE 'updated %', n;
+    DELETE FROM rdml_tab WHERE a % 2 = 0;
+    GET DIAGNOSTICS n = ROW_COUNT;
+    RAISE NOTICE 'deleted %', n;
+END $$ LANGUAGE plpgsql;
+-- every row waits for its answer by default
+SHOW remote_dml_batch_size;
+SELECT rdml_counts();
+SELECT count(*), sum(b) FROM rdml_tab;
+-- row counts do not depend on the batches
+TRUNCATE rdml_tab;
+SET remote_dml_batch_size = 100;
+SELECT rdml_counts();
+SELECT count(*), sum(b) FROM rdml_tab;
+TRUNCATE rdml_tab;
+SET remote_dml_batch_size = 7;
+SELECT rdml_counts();
+SELECT count(*), sum(b) FROM rdml_tab;
+-- the error of a row is reported by the statement that sent it
+SET remote_dml_batch_size = 100;
+INSERT INTO rdml_tab SELECT i, i FROM generate_series(2001, 2050) i UNION ALL SELECT 5, 5;
+SELECT count(*) FROM rdml_tab WHERE a > 2000;
+BEGIN;
+UPDATE rdml_tab SET b = b + 1 WHERE a < 100;
+INSERT INTO rdml_tab SELECT i, i FROM generate_series(2001, 2050) i UNION ALL SELECT 7, 7;
+COMMIT;
+SELECT count(*) FROM rdml_tab WHERE a > 2000;
+SELECT sum(b) FROM rdml_tab WHERE a < 100;
+RESET remote_dml_batch_size;
+DROP TABLE rdml_tab;
+DROP FUNCTION rdml_counts();
+DROP FUNCTION rdml_trig();
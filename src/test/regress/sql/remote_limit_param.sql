@@ -0,0 +1,34 @@
+--
+-- LIMIT and OFFSET parameters pushed down below the remote subplan
+--
+CREATE TABLE rlp_tab (a int, b int) DISTRIBUTE BY SHARD(a);
+INSERT INTO rlp_tab SELECT i, i % 7 FROM generate_series(1, 3000) i;
+ANALYZE rlp_tab;
+SET enable_fast_query_shipping = off;
+SET pgxl_remote_fetch_size = 100;
+PREPARE rlp_q(bigint, bigint) AS
+    SELECT a, b FROM rlp_tab ORDER BY a LIMIT $1 OFFSET $2;
+-- run enough times to use the generic plan
+EXECUTE rlp_q(3, 0);
+EXECUTE rlp_q(3, 10);
+EXECUTE rlp_q(3, 20);
+EXECUTE rlp_q(3, 30);
+EXECUTE rlp_q(3, 40);
+EXECUTE rlp_q(3, 50);
+-- every data node returns the first limit + offset rows
+EXPLAIN (COSTS OFF) EXECUTE rlp_q(3, 60);
+-- the window ends past the rows fetched at once from every data node
+EXECUTE rlp_q(5, 198);
+EXECUTE rlp_q(3, 1500);
+-- limit + offset overflows, nothing is limited
+EXECUTE rlp_q(9223372036854775807, 2998);
+EXECUTE rlp_q(9223372036854775807, 9223372036854775807);
+-- no limit
+EXECUTE rlp_q(NULL, 2997);
+-- the constant limits still read the remote streams to the end
+SELECT a, b FROM rlp_tab ORDER BY a LIMIT 3 OFFSET 250;
+SELECT count(*) FROM rlp_tab;
+DEALLOCATE rlp_q;
+RESET pgxl_remote_fetch_size;
+RESET enable_fast_query_shipping;
+DROP TABLE rlp_tab;
@@ -0,0 +1,50 @@
+--
+-- Results of remote subplans received by reader threads
+--
+\set VERBOSITY terse
+CREATE TABLE rrt_tab (a int, b int) DISTRIBUTE BY SHARD(a);
+INSERT INTO rrt_tab SELECT i, i % 100 FROM generate_series(1, 20000) i;
+-- fails for row bad, on the data node holding it
+CREATE FUNCTION rrt_check(a int, bad int) RETURNS int AS $$
+BEGIN
+    IF a = bad THEN
+        RAISE EXCEPTION 'bad row %', a;
+    END IF;
+    RETURN a;
+END $$ LANGUAGE plpgsql IMMUTABLE;
+-- closes the connection of the data node holding row bad
+CREATE FUNCTION rrt_exit(a int, bad int) RETURNS int AS $$
+BEGIN
+    IF a = bad THEN
+        PERFORM pg_terminate_backend(pg_backend_pid());
+    END IF;
+    RETURN a;
+END $$ LANGUAGE plpgsql IMMUTABLE;
+SET enable_fast_query_shipping = off;
+SET remote_receive_threads = 2;
+SELECT count(*), sum(a ORDER BY a) FROM (SELECT rrt_check(a, 0) AS a FROM rrt_tab) s;
+SELECT b, count(*) FROM rrt_tab WHERE b < 3 GROUP BY b ORDER BY b;
+-- stop reading in the middle of the results
+BEGIN;
+DECLARE rrt_cur CURSOR FOR SELECT a FROM rrt_tab ORDER BY a;
+FETCH 3 FROM rrt_cur;
+CLOSE rrt_cur;
+COMMIT;
+SELECT a FROM rrt_tab ORDER BY a LIMIT 2;
+-- error on one data node while the others are drained
+SELECT count(*), sum(a ORDER BY a) FROM (SELECT rrt_check(a, 5) AS a FROM rrt_tab) s;
+SELECT count(*) FROM rrt_tab;
+-- end of input from one data node
+DO $$
+BEGIN
+    PERFORM count(*), sum(a ORDER BY a) FROM (SELECT rrt_exit(a, 5) AS a FROM rrt_tab) s;
+    RAISE NOTICE 'query succeeded';
+EXCEPTION WHEN OTHERS THEN
+    RAISE NOTICE 'query failed';
+END $$;
+SELECT count(*), sum(a ORDER BY a) FROM (SELECT rrt_check(a, 0) AS a FROM rrt_tab) s;
+RESET remote_receive_threads;
+RESET enable_fast_query_shipping;
+DROP TABLE rrt_tab;
+DROP FUNCTION rrt_check(int, int);
+DROP FUNCTION rrt_exit(int, int);
@@ -0,0 +1,63 @@
+--
+-- Extents skipped by the zone map of their columns
+--
+-- One row per page, all in one shard: an extent of 2048 pages holds the
+-- rows of 2048 consecutive values of b.
+CREATE TABLE zm_tab (a int, b int, pad text)
+    WITH (fillfactor = 10, zone_map_columns = 'b') DISTRIBUTE BY SHARD(a);
+INSERT INTO zm_tab SELECT 1, i, repeat('x', 1000) FROM generate_series(1, 4500) i;
+-- a scroll cursor reading back and forth summarizes nothing it missed
+BEGIN;
+DECLARE zm_cur SCROLL CURSOR FOR SELECT b FROM zm_tab;
+MOVE FORWARD 1000 IN zm_cur;
+MOVE BACKWARD 500 IN zm_cur;
+MOVE FORWARD ALL IN zm_cur;
+FETCH BACKWARD 1 IN zm_cur;
+COMMIT;
+SELECT b FROM zm_tab WHERE b = 1500;
+-- a full scan summarizes the whole extents, then skipped or not
+SELECT count(*), min(b), max(b) FROM zm_tab;
+SELECT b FROM zm_tab WHERE b = 1500;
+SELECT b FROM zm_tab WHERE b = 3000;
+SELECT count(*) FROM zm_tab WHERE b > 4000;
+SELECT count(*) FROM zm_tab WHERE b < 10;
+SELECT count(*) FROM zm_tab WHERE b >= 2000 AND b <= 2100;
+SELECT count(*) FROM zm_tab WHERE b > 5000;
+-- the skipped extents are not read: the scan reads a whole extent of pages
+-- fewer than without the zone map
+CREATE FUNCTION zm_pages(query text) RETURNS int LANGUAGE plpgsql AS $$
+DECLARE
+    line text;
+    in_scan bool := false;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (ANALYZE, BUFFERS, COSTS OFF, TIMING OFF) ' || query LOOP
+        IF line ~ 'Seq Scan on zm_tab' THEN
+            in_scan := true;
+        ELSIF in_scan AND line ~ 'Buffers:' THEN
+            RETURN coalesce(substring(line from 'hit=(\d+)')::int, 0) +
+                   coalesce(substring(line from 'read=(\d+)')::int, 0);
+        END IF;
+    END LOOP;
+    RETURN 0;
+END;
+$$;
+SET enable_zone_map = off;
+SELECT zm_pages('SELECT b FROM zm_tab WHERE b = 3000') AS all_pages \gset
+SELECT :all_pages >= 4500 AS all_read;
+RESET enable_zone_map;
+SELECT zm_pages('SELECT b FROM zm_tab WHERE b = 3000') <= :all_pages - 2048 AS skipped;
+SELECT zm_pages('SELECT b FROM zm_tab WHERE b = 1500') <= :all_pages - 2048 AS skipped;
+SELECT zm_pages('SELECT b FROM zm_tab WHERE b > 5000') <= :all_pages - 4096 AS skipped;
+-- rows put in a summarized extent afterwards are still found
+UPDATE zm_tab SET b = 100000 WHERE b = 5;
+INSERT INTO zm_tab VALUES (1, -1, 'x');
+SELECT b FROM zm_tab WHERE b = 100000;
+SELECT b FROM zm_tab WHERE b < 1;
+SELECT count(*) FROM zm_tab WHERE b < 10;
+-- the same without the zone map
+SET enable_zone_map = off;
+SELECT b FROM zm_tab WHERE b = 100000;
+SELECT count(*) FROM zm_tab WHERE b < 10;
+RESET enable_zone_map;
+DROP FUNCTION zm_pages(text);
+DROP TABLE zm_tab;